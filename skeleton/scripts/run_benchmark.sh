@@ -6,6 +6,39 @@ set -x
 
 ./scripts/check_build.sh
 
+./temp/build-release/demo_sequential 4 1000000
 ./temp/build-release/demo_coarse_grained 8 4 100000
 ./temp/build-release/demo_striped 8 4 100000
 ./temp/build-release/demo_refinable 8 4 100000
+./temp/build-release/demo_batch_hash 1000000
+./temp/build-release/demo_string_keys 1000000 10000000
+./temp/build-release/demo_hot_keys 8 1000000 1000000
+./temp/build-release/demo_adaptive_stripes 8 1000000 1000000
+./temp/build-release/demo_adaptive 8 4 100000
+./temp/build-release/demo_adaptive_mixed 8 100000 1000000
+./temp/build-release/demo_segmented 8 4 100000
+./temp/build-release/demo_extendible 8 4 100000
+./temp/build-release/demo_resize_latency 8 200000
+./temp/build-release/demo_skiplist 8 4 100000
+./temp/build-release/demo_ordered 8 1000000 1000000
+./temp/build-release/demo_frozen 8 4000000 2000000
+./temp/build-release/demo_snapshot 8 10000000 temp/snapshot.bin
+./temp/build-release/demo_mapped 8 16777216 200000 temp/mapped_table
+./temp/build-release/demo_shared 8 1000000
+./temp/build-release/demo_wal 8 200000 temp/wal
+./temp/build-release/demo_transactions 8 100000
+./temp/build-release/demo_ttl 8 2000 200
+./temp/build-release/demo_bounded 8 100000 1000000
+./temp/build-release/demo_counting 8 1000000 1000000
+./temp/build-release/demo_string_pool 8 1000000 1000000
+./temp/build-release/demo_cuckoo_filter 8 4000000
+./temp/build-release/demo_replicated 8 2 100000 1000000
+./temp/build-release/demo_chained 8 16000000
+./temp/build-release/demo_lazy_buckets 100000000
+./temp/build-release/membership_server temp/membership.sock striped 0 &
+MEMBERSHIP_SERVER=$!
+./temp/build-release/membership_client temp/membership.sock 8 20000 1
+./temp/build-release/membership_client temp/membership.sock 8 200000 64
+kill "${MEMBERSHIP_SERVER}"
+wait "${MEMBERSHIP_SERVER}"
+./temp/build-release/tune_hash_set 8 4 10000 3 temp/tuned_hash_set.h
@@ -0,0 +1,237 @@
+#ifndef BATCH_HASH_H
+#define BATCH_HASH_H
+
+#include <algorithm>    // std::min
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <type_traits>  // std::is_same_v
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "src/bucket.h"
+
+namespace batch_hash {
+
+// MurmurHash3 finalisers: multiply-xorshift mixers that use only operations
+// available lane-wise in AVX2/AVX-512, so the batch kernels below produce
+// bit-identical hashes to the scalar path.
+inline constexpr uint32_t kMul32A = 0x85ebca6bu;
+inline constexpr uint32_t kMul32B = 0xc2b2ae35u;
+inline constexpr uint64_t kMul64A = 0xff51afd7ed558ccdull;
+inline constexpr uint64_t kMul64B = 0xc4ceb9fe1a85ec53ull;
+
+inline uint32_t Mix32(uint32_t x) {
+  x ^= x >> 16;
+  x *= kMul32A;
+  x ^= x >> 13;
+  x *= kMul32B;
+  x ^= x >> 16;
+  return x;
+}
+
+inline uint64_t Mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= kMul64A;
+  x ^= x >> 33;
+  x *= kMul64B;
+  x ^= x >> 33;
+  return x;
+}
+
+// Hash functor for 32/64-bit integral keys, usable as the Hash parameter of
+// every set. std::hash is the identity on integers, which keeps sequential
+// keys cache-friendly but piles strided keys into a few buckets; MixHasher
+// spreads them, and HashBatch computes it 8-16 keys per instruction.
+template <typename T>
+struct MixHasher {
+  static_assert(bucket::kVectorizable<T>,
+                "MixHasher needs a 32- or 64-bit integral key");
+
+  size_t operator()(const T& elem) const {
+    if constexpr (sizeof(T) == 4) {
+      return Mix32(static_cast<uint32_t>(elem));
+    } else {
+      return static_cast<size_t>(Mix64(static_cast<uint64_t>(elem)));
+    }
+  }
+};
+
+enum class Kernel { kScalar, kAvx2, kAvx512 };
+
+template <typename Hash, typename T>
+void HashScalar(const Hash& hasher, const T* keys, size_t n, size_t* out) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = hasher(keys[i]);
+  }
+}
+
+#if defined(__x86_64__)
+namespace internal {
+
+// Low 64 bits of a * b per lane; AVX2 only has a 32x32->64 multiply.
+__attribute__((target("avx2"))) inline __m256i MulLo64(__m256i a, uint64_t b) {
+  __m256i b_lo = _mm256_set1_epi64x(static_cast<long long>(b));
+  __m256i b_hi = _mm256_set1_epi64x(static_cast<long long>(b >> 32));
+  __m256i cross = _mm256_add_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b_lo),
+      _mm256_mul_epu32(a, b_hi));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b_lo),
+                          _mm256_slli_epi64(cross, 32));
+}
+
+// 8 x 32-bit or 4 x 64-bit keys per step.
+template <typename T>
+__attribute__((target("avx2"))) void HashAvx2(const T* keys, size_t n,
+                                              size_t* out) {
+  constexpr size_t kLanes = sizeof(__m256i) / sizeof(T);
+  const __m256i mul_a = _mm256_set1_epi32(static_cast<int>(kMul32A));
+  const __m256i mul_b = _mm256_set1_epi32(static_cast<int>(kMul32B));
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+    auto* dst = reinterpret_cast<__m256i*>(out + i);
+    if constexpr (sizeof(T) == 4) {
+      x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+      x = _mm256_mullo_epi32(x, mul_a);
+      x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 13));
+      x = _mm256_mullo_epi32(x, mul_b);
+      x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+      // Zero-extend the eight 32-bit hashes into two registers of size_t.
+      __m128i lo = _mm256_castsi256_si128(x);
+      __m128i hi = _mm256_extracti128_si256(x, 1);
+      _mm256_storeu_si256(dst, _mm256_cvtepu32_epi64(lo));
+      _mm256_storeu_si256(dst + 1, _mm256_cvtepu32_epi64(hi));
+    } else {
+      x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+      x = MulLo64(x, kMul64A);
+      x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+      x = MulLo64(x, kMul64B);
+      x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+      _mm256_storeu_si256(dst, x);
+    }
+  }
+  HashScalar(MixHasher<T>{}, keys + i, n - i, out + i);
+}
+
+// 16 x 32-bit or 8 x 64-bit keys per step.
+template <typename T>
+__attribute__((target("avx512f,avx512dq"))) void HashAvx512(const T* keys,
+                                                            size_t n,
+                                                            size_t* out) {
+  constexpr size_t kLanes = sizeof(__m512i) / sizeof(T);
+  const __m512i mul_a =
+      sizeof(T) == 4 ? _mm512_set1_epi32(static_cast<int>(kMul32A))
+                     : _mm512_set1_epi64(static_cast<long long>(kMul64A));
+  const __m512i mul_b =
+      sizeof(T) == 4 ? _mm512_set1_epi32(static_cast<int>(kMul32B))
+                     : _mm512_set1_epi64(static_cast<long long>(kMul64B));
+  size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    __m512i x = _mm512_loadu_si512(keys + i);
+    if constexpr (sizeof(T) == 4) {
+      x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+      x = _mm512_mullo_epi32(x, mul_a);
+      x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 13));
+      x = _mm512_mullo_epi32(x, mul_b);
+      x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+      __m256i lo = _mm512_castsi512_si256(x);
+      __m256i hi = _mm512_extracti64x4_epi64(x, 1);
+      _mm512_storeu_si512(out + i, _mm512_cvtepu32_epi64(lo));
+      _mm512_storeu_si512(out + i + 8, _mm512_cvtepu32_epi64(hi));
+    } else {
+      x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+      x = _mm512_mullo_epi64(x, mul_a);
+      x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+      x = _mm512_mullo_epi64(x, mul_b);
+      x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+      _mm512_storeu_si512(out + i, x);
+    }
+  }
+  HashScalar(MixHasher<T>{}, keys + i, n - i, out + i);
+}
+
+}  // namespace internal
+#endif
+
+// Widest kernel the running CPU supports; detected once.
+inline Kernel ActiveKernel() {
+#if defined(__x86_64__)
+  static const Kernel kernel = [] {
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512dq")) {
+      return Kernel::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return Kernel::kAvx2;
+    }
+    return Kernel::kScalar;
+  }();
+  return kernel;
+#else
+  return Kernel::kScalar;
+#endif
+}
+
+inline const char* KernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kScalar:
+      return "scalar";
+    case Kernel::kAvx2:
+      return "avx2";
+    case Kernel::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+// Sets out[i] = hasher(keys[i]) for i in [0, n). MixHasher runs on the widest
+// kernel available at runtime; any other hash function is called per key.
+template <typename Hash, typename T>
+void HashBatch(const Hash& hasher, const T* keys, size_t n, size_t* out) {
+  if constexpr (std::is_same_v<Hash, MixHasher<T>>) {
+#if defined(__x86_64__)
+    switch (ActiveKernel()) {
+      case Kernel::kAvx512:
+        internal::HashAvx512(keys, n, out);
+        return;
+      case Kernel::kAvx2:
+        internal::HashAvx2(keys, n, out);
+        return;
+      case Kernel::kScalar:
+        break;
+    }
+#endif
+  }
+  HashScalar(hasher, keys, n, out);
+}
+
+// Hashes elems[0, n) a block at a time into a stack buffer and calls
+// fn(base, len, hashes) for each block elems[base, base + len).
+template <typename Hash, typename T, typename Fn>
+void ForEachHashedBlock(const Hash& hasher, const T* elems, size_t n,
+                        Fn&& fn) {
+  constexpr size_t kBlock = 256;
+  size_t hashes[kBlock];
+  for (size_t base = 0; base < n; base += kBlock) {
+    size_t len = std::min(kBlock, n - base);
+    HashBatch(hasher, elems + base, len, hashes);
+    fn(base, len, static_cast<const size_t*>(hashes));
+  }
+}
+
+// Calls fn(i, hash of elems[i]) for every i in [0, n).
+template <typename Hash, typename T, typename Fn>
+void ForEachHashed(const Hash& hasher, const T* elems, size_t n, Fn&& fn) {
+  ForEachHashedBlock(hasher, elems, n,
+                     [&](size_t base, size_t len, const size_t* hashes) {
+                       for (size_t j = 0; j < len; ++j) {
+                         fn(base + j, hashes[j]);
+                       }
+                     });
+}
+
+}  // namespace batch_hash
+
+#endif  // BATCH_HASH_H
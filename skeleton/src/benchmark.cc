@@ -28,4 +28,45 @@ void ThreadBody(HashSetBase<int>& hash_set, size_t chunk_size, size_t id,
   }
 }
 
+bool RunWorkload(const char* name, HashSetBase<int>& hash_set,
+                 size_t num_threads, size_t chunk_size,
+                 std::chrono::nanoseconds& elapsed) {
+  std::vector<size_t> max_observed_sizes;
+  max_observed_sizes.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    max_observed_sizes.emplace_back(0u);
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back(std::thread(ThreadBody, std::ref(hash_set), chunk_size,
+                                     i, std::ref(max_observed_sizes.at(i))));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
+                                                                 begin_time);
+
+  size_t expected_size = chunk_size * (num_threads + 1);
+  if (hash_set.Size() != expected_size) {
+    std::cerr << name << " failed: size " << hash_set.Size()
+              << " does not match expected size " << expected_size << std::endl;
+    return false;
+  }
+  for (size_t i = 0; i < chunk_size * (num_threads + 1); i++) {
+    int expected_value = static_cast<int>(i);
+    if (!hash_set.Contains(expected_value)) {
+      std::cerr << name << " failed: expected value " << expected_value
+                << " not found" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace benchmark
@@ -15,6 +15,13 @@ namespace benchmark {
 void ThreadBody(HashSetBase<int>& hash_set, size_t chunk_size, size_t id,
                 size_t& max_observed_size);
 
+// Runs ThreadBody on |num_threads| threads against |hash_set|, then checks
+// its final contents. Stores the wall time of the threaded part in
+// |elapsed|. Returns false, after reporting to std::cerr, if the check fails.
+bool RunWorkload(const char* name, HashSetBase<int>& hash_set,
+                 size_t num_threads, size_t chunk_size,
+                 std::chrono::nanoseconds& elapsed);
+
 template <typename HashSetType>
 int RunBenchmark(int argc, char** argv) {
   if (argc != 4) {
@@ -27,44 +34,12 @@ int RunBenchmark(int argc, char** argv) {
   size_t chunk_size = std::stoul(std::string(argv[3]));
 
   HashSetType hash_set(initial_capacity);
-
-  std::vector<size_t> max_observed_sizes;
-  max_observed_sizes.reserve(num_threads);
-  for (size_t i = 0; i < num_threads; i++) {
-    max_observed_sizes.emplace_back(0u);
-  }
-
-  std::vector<std::thread> threads;
-  threads.reserve(num_threads);
-
-  auto begin_time = std::chrono::high_resolution_clock::now();
-  for (size_t i = 0; i < num_threads; i++) {
-    threads.emplace_back(std::thread(ThreadBody, std::ref(hash_set), chunk_size,
-                                     i, std::ref(max_observed_sizes.at(i))));
-  }
-  for (auto& thread : threads) {
-    thread.join();
-  }
-  auto end_time = std::chrono::high_resolution_clock::now();
-
-  auto duration = end_time - begin_time;
-  auto millis =
-      std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-
-  size_t expected_size = chunk_size * (num_threads + 1);
-  if (hash_set.Size() != expected_size) {
-    std::cerr << argv[0] << " failed: size " << hash_set.Size()
-              << " does not match expected size " << expected_size << std::endl;
+  std::chrono::nanoseconds elapsed{};
+  if (!RunWorkload(argv[0], hash_set, num_threads, chunk_size, elapsed)) {
     return 1;
   }
-  for (size_t i = 0; i < chunk_size * (num_threads + 1); i++) {
-    int expected_value = static_cast<int>(i);
-    if (!hash_set.Contains(expected_value)) {
-      std::cerr << argv[0] << " failed: expected value " << expected_value
-                << " not found" << std::endl;
-      return 1;
-    }
-  }
+  auto millis =
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
 
   std::cout << argv[0] << " succeeded" << std::endl;
   std::cout << "Concurrent computation took:" << std::endl;
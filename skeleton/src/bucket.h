@@ -0,0 +1,114 @@
+#ifndef BUCKET_H
+#define BUCKET_H
+
+#include <bit>          // std::countr_zero
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t
+#include <type_traits>  // std::is_integral_v
+#include <vector>       // std::vector
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace bucket {
+
+// Keys that Find compares several at a time with vector instructions.
+template <typename T>
+inline constexpr bool kVectorizable =
+    std::is_integral_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+// Returns the index of the first element equal to |elem| in data[0, n), or n.
+// Vectorizable keys are compared a register at a time. Only whole registers
+// are loaded, so nothing past data[n - 1] is ever read (no padding needed, and
+// ASan container-overflow checks stay quiet); the tail is scanned scalar.
+template <typename T>
+size_t FindIndex(const T* data, size_t n, const T& elem) {
+  size_t i = 0;
+  if constexpr (kVectorizable<T>) {
+#if defined(__AVX2__)
+    constexpr size_t kWideLanes = sizeof(__m256i) / sizeof(T);
+    __m256i wide_needle;
+    if constexpr (sizeof(T) == 4) {
+      wide_needle = _mm256_set1_epi32(static_cast<int>(elem));
+    } else {
+      wide_needle = _mm256_set1_epi64x(static_cast<long long>(elem));
+    }
+    for (; i + kWideLanes <= n; i += kWideLanes) {
+      __m256i v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      __m256i eq = sizeof(T) == 4 ? _mm256_cmpeq_epi32(v, wide_needle)
+                                  : _mm256_cmpeq_epi64(v, wide_needle);
+      auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+      if (mask != 0) {
+        return i + static_cast<size_t>(std::countr_zero(mask)) / sizeof(T);
+      }
+    }
+#endif
+#if defined(__SSE4_1__)
+    // Chains average kMaxLoadFactor elements, so one narrow step after the
+    // wide loop usually covers what is left without going scalar.
+    constexpr size_t kLanes = sizeof(__m128i) / sizeof(T);
+    __m128i needle;
+    if constexpr (sizeof(T) == 4) {
+      needle = _mm_set1_epi32(static_cast<int>(elem));
+    } else {
+      needle = _mm_set1_epi64x(static_cast<long long>(elem));
+    }
+    for (; i + kLanes <= n; i += kLanes) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      __m128i eq = sizeof(T) == 4 ? _mm_cmpeq_epi32(v, needle)
+                                  : _mm_cmpeq_epi64(v, needle);
+      auto mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+      if (mask != 0) {
+        return i + static_cast<size_t>(std::countr_zero(mask)) / sizeof(T);
+      }
+    }
+#endif
+  }
+  for (; i < n; ++i) {
+    if (data[i] == elem) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// Drop-in replacement for std::find(b.begin(), b.end(), elem).
+template <typename T>
+typename std::vector<T>::iterator Find(std::vector<T>& b, const T& elem) {
+  return b.begin() +
+         static_cast<std::ptrdiff_t>(FindIndex(b.data(), b.size(), elem));
+}
+
+template <typename T>
+typename std::vector<T>::const_iterator Find(const std::vector<T>& b,
+                                            const T& elem) {
+  return b.begin() +
+         static_cast<std::ptrdiff_t>(FindIndex(b.data(), b.size(), elem));
+}
+
+// Heterogeneous lookup for keys of another type, compared with elem == key.
+// Never vectorised; overload resolution prefers the forms above when K is T.
+template <typename T, typename K>
+typename std::vector<T>::iterator Find(std::vector<T>& b, const K& key) {
+  auto it = b.begin();
+  while (it != b.end() && !(*it == key)) {
+    ++it;
+  }
+  return it;
+}
+
+template <typename T, typename K>
+typename std::vector<T>::const_iterator Find(const std::vector<T>& b,
+                                            const K& key) {
+  auto it = b.begin();
+  while (it != b.end() && !(*it == key)) {
+    ++it;
+  }
+  return it;
+}
+
+}  // namespace bucket
+
+#endif  // BUCKET_H
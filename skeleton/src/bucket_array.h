@@ -0,0 +1,102 @@
+#ifndef BUCKET_ARRAY_H
+#define BUCKET_ARRAY_H
+
+#include <cstddef>  // size_t, std::max_align_t
+#include <cstdlib>  // std::calloc, std::malloc, std::free
+#include <cstring>  // std::memcmp
+#include <memory>   // std::uninitialized_value_construct_n, std::destroy_n
+#include <new>      // std::bad_alloc
+#include <utility>  // std::swap
+
+// Fixed-size array of default-constructed buckets that costs nothing until
+// a bucket is written. A table of 100M std::vector<T> buckets would
+// otherwise value-initialise 2.4 GB of headers, serially, before the first
+// insert.
+//
+// When a default-constructed B is all zero bytes, as an empty std::vector
+// is in libstdc++ and libc++, the array comes from calloc, which for large
+// sizes maps fresh anonymous pages without writing them. Pages are then
+// backed by memory only once a bucket on them is written. Other bucket types
+// are constructed one by one, as std::vector would.
+//
+// Has the parts of the std::vector interface the sets use on their bucket
+// arrays, so it can replace one without touching the call sites.
+template <typename B>
+class BucketArray {
+ public:
+  BucketArray() = default;
+
+  explicit BucketArray(size_t n) : size_(n) {
+    static_assert(alignof(B) <= alignof(std::max_align_t));
+    if (n == 0) {
+      return;
+    }
+    if (ZeroIsDefault()) {
+      data_ = static_cast<B*>(std::calloc(n, sizeof(B)));
+      if (data_ == nullptr) {
+        throw std::bad_alloc();
+      }
+      return;
+    }
+    data_ = static_cast<B*>(std::malloc(n * sizeof(B)));
+    if (data_ == nullptr) {
+      throw std::bad_alloc();
+    }
+    try {
+      std::uninitialized_value_construct_n(data_, n);
+    } catch (...) {
+      std::free(data_);
+      throw;
+    }
+  }
+
+  BucketArray(BucketArray&& other) noexcept { swap(other); }
+
+  BucketArray& operator=(BucketArray&& other) noexcept {
+    BucketArray(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  BucketArray(const BucketArray&) = delete;
+  BucketArray& operator=(const BucketArray&) = delete;
+
+  // Destroying a bucket reads it, so this does touch every page once.
+  ~BucketArray() {
+    if (data_ != nullptr) {
+      std::destroy_n(data_, size_);
+      std::free(data_);
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return size_; }
+
+  B& operator[](size_t i) { return data_[i]; }
+  const B& operator[](size_t i) const { return data_[i]; }
+
+  B* begin() { return data_; }
+  B* end() { return data_ + size_; }
+  const B* begin() const { return data_; }
+  const B* end() const { return data_ + size_; }
+
+  void swap(BucketArray& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+  }
+
+ private:
+  // Whether zero-filled memory already holds a default-constructed B. Checked
+  // once, on the object representation of a real B{}.
+  static bool ZeroIsDefault() {
+    static const bool zero = [] {
+      alignas(B) unsigned char zeros[sizeof(B)] = {};
+      B b{};
+      return std::memcmp(&b, zeros, sizeof(B)) == 0;
+    }();
+    return zero;
+  }
+
+  B* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // BUCKET_ARRAY_H
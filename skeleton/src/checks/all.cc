@@ -1,13 +1,50 @@
+#include <chrono>
+
+#include "src/counting_hash_set.h"
+#include "src/frozen_hash_set.h"
+#include "src/hash_set_adaptive.h"
+#include "src/hash_set_bounded.h"
+#include "src/hash_set_chained.h"
 #include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_cuckoo_filter.h"
+#include "src/hash_set_extendible.h"
+#include "src/hash_set_mapped.h"
 #include "src/hash_set_refinable.h"
+#include "src/hash_set_replicated.h"
+#include "src/hash_set_segmented.h"
 #include "src/hash_set_sequential.h"
+#include "src/hash_set_shared.h"
+#include "src/hash_set_skiplist.h"
 #include "src/hash_set_striped.h"
+#include "src/hash_set_ttl.h"
+#include "src/string_pool.h"
 
 namespace check_all {
 
 void Placeholder();
 
 void Placeholder() {
+  {
+    CountingHashSet<int> counts(16);
+    counts.Increment(1);
+    (void)counts.Count(1);
+  }
+
+  {
+    const int keys[] = {1};
+    FrozenHashSet<int> fs(keys, 1);
+    (void)fs.Size();
+    (void)fs.Contains(1);
+  }
+
+  {
+    HashSetAdaptive<int> hs(16);
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
   {
     HashSetCoarseGrained<int> hs(16);
     hs.Add(1);
@@ -16,6 +53,22 @@ void Placeholder() {
     (void)hs.Contains(1);
   }
 
+  {
+    HashSetExtendible<int> hs(16);
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
+  {
+    HashSetMapped<> hs("check_all_mapped", 16);
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
   {
     HashSetRefinable<int> hs(16);
     hs.Add(1);
@@ -24,6 +77,14 @@ void Placeholder() {
     (void)hs.Contains(1);
   }
 
+  {
+    HashSetSegmented<int> hs(16);
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
   {
     HashSetSequential<int> hs(16);
     hs.Add(1);
@@ -32,6 +93,49 @@ void Placeholder() {
     (void)hs.Contains(1);
   }
 
+  {
+    auto hs = HashSetShared<int>::Create("/check_all_shared", 16, 16);
+    if (hs) {
+      hs->Add(1);
+      hs->Remove(1);
+      (void)hs->Size();
+      (void)hs->Contains(1);
+    }
+    HashSetShared<int>::Unlink("/check_all_shared");
+  }
+
+  {
+    HashSetSkiplist<int> hs(16);
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
+  {
+    HashSetBounded<int> hs(16);
+    hs.Add(1);
+    (void)hs.Contains(1);
+  }
+
+  {
+    HashSetChained<int> hs(16);
+    hs.Add(1);
+    (void)hs.Contains(1);
+  }
+
+  {
+    HashSetCuckooFilter hs(16);
+    hs.Add(1);
+    (void)hs.Contains(1);
+  }
+
+  {
+    HashSetReplicated<int> hs(16);
+    hs.Add(1);
+    (void)hs.Contains(1);
+  }
+
   {
     HashSetStriped<int> hs(16);
     hs.Add(1);
@@ -39,6 +143,19 @@ void Placeholder() {
     (void)hs.Size();
     (void)hs.Contains(1);
   }
+
+  {
+    HashSetTtl<int> hs(16, std::chrono::seconds(1));
+    hs.Add(1);
+    hs.Remove(1);
+    (void)hs.Size();
+    (void)hs.Contains(1);
+  }
+
+  {
+    StringPool pool(16);
+    (void)pool.View(pool.Intern("a"));
+  }
 }
 
 }  // namespace check_all
@@ -0,0 +1,17 @@
+#include "src/hash_set_adaptive.h"
+
+namespace check_adaptive {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetAdaptive<int> hs(16);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.IsFineGrained();
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_adaptive
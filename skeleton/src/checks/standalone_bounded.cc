@@ -0,0 +1,18 @@
+#include "src/hash_set_bounded.h"
+
+namespace check_bounded {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetBounded<int> hs(16, BoundedOptions{.stripes = 4});
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.Capacity();
+  (void)hs.Evictions();
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_bounded
@@ -0,0 +1,17 @@
+#include "src/hash_set_chained.h"
+
+namespace check_chained {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetChained<int> hs(16, 4);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.BucketCount();
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_chained
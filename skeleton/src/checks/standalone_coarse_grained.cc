@@ -1,3 +1,6 @@
+#include <string>
+#include <string_view>
+
 #include "src/hash_set_coarse_grained.h"
 
 namespace check_coarse_grained {
@@ -10,6 +13,18 @@ void Placeholder() {
   hs.Remove(1);
   (void)hs.Size();
   (void)hs.Contains(1);
+  hs.ForEach([](int) {});
+
+  HashSetCoarseGrained<int> tuned(
+      16, HashSetParams{.max_load_factor = 2.0, .min_buckets = 64});
+  tuned.Add(1);
+  tuned.Remove(1);
+
+  HashSetCoarseGrained<std::string, StringHash> strings(16);
+  strings.Emplace(size_t{3}, 'a');
+  (void)strings.Contains(std::string_view("aaa"));
+  (void)strings.Contains("aaa");
+  strings.Remove(std::string_view("aaa"));
 }
 
 }  // namespace check_coarse_grained
@@ -0,0 +1,19 @@
+#include <cstdint>
+
+#include "src/counting_hash_set.h"
+
+namespace check_counting {
+
+void Placeholder();
+
+void Placeholder() {
+  CountingHashSet<int> counts(16);
+  counts.Increment(1);
+  counts.Decrement(1);
+  (void)counts.Count(1);
+  (void)counts.Size();
+  (void)counts.TopK(3);
+  counts.ForEach([](int, uint64_t) {});
+}
+
+}  // namespace check_counting
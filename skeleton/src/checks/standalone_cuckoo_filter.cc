@@ -0,0 +1,17 @@
+#include "src/hash_set_cuckoo_filter.h"
+
+namespace check_cuckoo_filter {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetCuckooFilter hs(16, 4);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.SlotCount();
+  (void)hs.MemoryUsage();
+}
+
+}  // namespace check_cuckoo_filter
@@ -0,0 +1,18 @@
+#include "src/hash_set_extendible.h"
+
+namespace check_extendible {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetExtendible<int> hs(16);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.GlobalDepth();
+  (void)hs.BucketCount();
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_extendible
@@ -0,0 +1,25 @@
+#include "src/frozen_hash_set.h"
+#include "src/hash_set_sequential.h"
+#include "src/hash_set_striped.h"
+
+namespace check_frozen {
+
+void Placeholder();
+
+void Placeholder() {
+  const int keys[] = {1, 2, 3};
+  FrozenHashSet<int> fs(keys, 3, 1);
+  (void)fs.Size();
+  (void)fs.Contains(1);
+  (void)fs.MemoryBytes();
+  bool results[3];
+  fs.ContainsBatch(keys, 3, results);
+
+  HashSetSequential<int> sequential(16);
+  (void)FrozenHashSet<int>::FromSet(sequential);
+
+  HashSetStriped<int> striped(16);
+  (void)striped.Freeze().Contains(1);
+}
+
+}  // namespace check_frozen
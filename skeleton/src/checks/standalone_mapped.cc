@@ -0,0 +1,21 @@
+#include <cstdint>
+
+#include "src/hash_set_mapped.h"
+
+namespace check_mapped {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetMapped<> hs("check_mapped", 16);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  hs.ForEach([](uint64_t) {});
+  (void)hs.FileBytes();
+  (void)hs.ResidentBytes();
+  hs.Evict();
+}
+
+}  // namespace check_mapped
@@ -1,3 +1,6 @@
+#include <string>
+#include <string_view>
+
 #include "src/hash_set_refinable.h"
 
 namespace check_refinable {
@@ -10,6 +13,18 @@ void Placeholder() {
   hs.Remove(1);
   (void)hs.Size();
   (void)hs.Contains(1);
+
+  const int group[] = {1, 2, 3};
+  (void)hs.AddAll(group, 3);
+  (void)hs.Swap(1, 4);
+  (void)hs.RemoveAll(group, 3);
+  hs.ForEach([](int) {});
+
+  HashSetRefinable<std::string, StringHash> strings(16);
+  strings.Emplace(size_t{3}, 'a');
+  (void)strings.Contains(std::string_view("aaa"));
+  (void)strings.Contains("aaa");
+  strings.Remove(std::string_view("aaa"));
 }
 
 }  // namespace check_refinable
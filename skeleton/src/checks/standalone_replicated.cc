@@ -0,0 +1,18 @@
+#include "src/hash_set_replicated.h"
+
+namespace check_replicated {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetReplicated<int> hs(16, ReplicatedOptions{.cpu_groups = {{0}, {1}}});
+  HashSetReplicated<int>::BindThisThread(1);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.ReplicaCount();
+  HashSetReplicated<int>::UnbindThisThread();
+}
+
+}  // namespace check_replicated
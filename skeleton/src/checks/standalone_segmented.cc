@@ -0,0 +1,17 @@
+#include "src/hash_set_segmented.h"
+
+namespace check_segmented {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetSegmented<int> hs(16);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.SegmentCount();
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_segmented
@@ -1,3 +1,6 @@
+#include <string>
+#include <string_view>
+
 #include "src/hash_set_sequential.h"
 
 namespace check_sequential {
@@ -10,6 +13,12 @@ void Placeholder() {
   hs.Remove(1);
   (void)hs.Size();
   (void)hs.Contains(1);
+
+  HashSetSequential<std::string, StringHash> strings(16);
+  strings.Emplace(size_t{3}, 'a');
+  (void)strings.Contains(std::string_view("aaa"));
+  (void)strings.Contains("aaa");
+  strings.Remove(std::string_view("aaa"));
 }
 
 }  // namespace check_sequential
@@ -0,0 +1,24 @@
+#include <memory>
+
+#include "src/hash_set_shared.h"
+
+namespace check_shared {
+
+void Placeholder();
+
+void Placeholder() {
+  std::unique_ptr<HashSetShared<int>> hs =
+      HashSetShared<int>::Create("/check_shared", 16, 1024);
+  if (hs) {
+    hs->Add(1);
+    hs->Remove(1);
+    (void)hs->Size();
+    (void)hs->Contains(1);
+    hs->ForEach([](int) {});
+    (void)hs->SegmentBytes();
+  }
+  (void)HashSetShared<int>::Open("/check_shared");
+  (void)HashSetShared<int>::Unlink("/check_shared");
+}
+
+}  // namespace check_shared
@@ -0,0 +1,18 @@
+#include "src/hash_set_skiplist.h"
+
+namespace check_skiplist {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetSkiplist<int> hs(16);
+  hs.Add(1);
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  (void)hs.LowerBound(0);
+  hs.RangeForEach(0, 10, [](int) {});
+  hs.ForEach([](int) {});
+}
+
+}  // namespace check_skiplist
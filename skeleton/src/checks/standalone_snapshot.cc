@@ -0,0 +1,29 @@
+#include <optional>
+
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_striped.h"
+#include "src/snapshot.h"
+
+namespace check_snapshot {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetStriped<int> striped(16);
+  (void)striped.SaveSnapshot("check.snap");
+  (void)striped.LoadSnapshot("check.snap");
+
+  HashSetCoarseGrained<int> coarse(16);
+  (void)snapshot::Save<int>(coarse, "check.snap");
+  std::optional<snapshot::Image<int>> image =
+      snapshot::Image<int>::Open("check.snap");
+  if (image) {
+    (void)image->Size();
+    (void)image->Contains(1);
+    image->ForEach([](int) {});
+    (void)snapshot::LoadInto(*image, coarse);
+    striped.LoadImage(*image);
+  }
+}
+
+}  // namespace check_snapshot
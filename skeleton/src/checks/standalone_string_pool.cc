@@ -0,0 +1,16 @@
+#include "src/string_pool.h"
+
+namespace check_string_pool {
+
+void Placeholder();
+
+void Placeholder() {
+  StringPool pool(16, 4);
+  uint32_t id = pool.Intern("a");
+  (void)pool.Find("a");
+  (void)pool.View(id);
+  (void)pool.Size();
+  (void)pool.MemoryUsage();
+}
+
+}  // namespace check_string_pool
@@ -1,3 +1,6 @@
+#include <string>
+#include <string_view>
+
 #include "src/hash_set_striped.h"
 
 namespace check_striped {
@@ -10,6 +13,27 @@ void Placeholder() {
   hs.Remove(1);
   (void)hs.Size();
   (void)hs.Contains(1);
+
+  const int group[] = {1, 2, 3};
+  (void)hs.AddAll(group, 3);
+  (void)hs.Swap(1, 4);
+  (void)hs.RemoveAll(group, 3);
+
+  HashSetStriped<int> cached(16, StripedOptions{.hot_key_cache = true});
+  cached.Add(1);
+  (void)cached.Contains(1);
+  (void)HashSetStriped<int>::ThreadHotKeyStats();
+
+  HashSetStriped<int> adaptive(16, StripedOptions{.adaptive_stripes = true});
+  adaptive.Add(1);
+  adaptive.Remove(1);
+  (void)adaptive.StripeCount();
+
+  HashSetStriped<std::string, StringHash> strings(16);
+  strings.Emplace(size_t{3}, 'a');
+  (void)strings.Contains(std::string_view("aaa"));
+  (void)strings.Contains("aaa");
+  strings.Remove(std::string_view("aaa"));
 }
 
 }  // namespace check_striped
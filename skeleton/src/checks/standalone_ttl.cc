@@ -0,0 +1,27 @@
+#include <chrono>
+
+#include "src/hash_set_ttl.h"
+
+namespace check_ttl {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetTtl<int> hs(16, std::chrono::seconds(1));
+  hs.Add(1);
+  hs.Add(2, std::chrono::milliseconds(10));
+  hs.Remove(1);
+  (void)hs.Size();
+  (void)hs.Contains(1);
+  hs.ForEach([](int) {});
+
+  HashSetTtl<int> manual(
+      16, std::chrono::seconds(1),
+      TtlOptions{.tick = std::chrono::microseconds(100),
+                 .background_eviction = false});
+  manual.Add(1);
+  (void)manual.EvictExpired();
+  (void)manual.Stats();
+}
+
+}  // namespace check_ttl
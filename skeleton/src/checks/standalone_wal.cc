@@ -0,0 +1,32 @@
+#include <chrono>
+#include <memory>
+
+#include "src/hash_set_striped.h"
+#include "src/wal.h"
+
+namespace check_wal {
+
+void Placeholder();
+
+void Placeholder() {
+  HashSetStriped<int> striped(16);
+  if (striped.OpenLog("check_wal",
+                      wal::Options{std::chrono::microseconds(100)})) {
+    striped.Add(1);
+    striped.Remove(1);
+    (void)striped.Sync();
+    (void)striped.Checkpoint();
+    (void)striped.WriteAheadLog()->DurableLsn();
+  }
+
+  std::unique_ptr<wal::Log<int>> log = wal::Log<int>::Open("check_wal", 0);
+  if (log) {
+    (void)log->Append(wal::Op::kAdd, 1);
+    (void)log->Sync();
+    (void)log->Rotate();
+  }
+  (void)wal::Replay<int>("check_wal", 0, [](wal::Op, int) {});
+  wal::Destroy("check_wal");
+}
+
+}  // namespace check_wal
@@ -0,0 +1,285 @@
+#ifndef COUNTING_HASH_SET_H
+#define COUNTING_HASH_SET_H
+
+#include <algorithm>   // std::max, std::reverse
+#include <atomic>      // std::atomic
+#include <bit>         // std::bit_ceil
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <functional>  // std::hash, std::greater
+#include <memory>      // std::unique_ptr
+#include <mutex>       // std::mutex, std::unique_lock
+#include <queue>       // std::priority_queue
+#include <utility>     // std::move, std::pair
+#include <vector>      // std::vector
+
+#include "src/hash_set_params.h"
+
+// A concurrent multiset that counts occurrences of each key, with the
+// striped architecture: a fixed number of stripe locks over one bucket
+// table that doubles under all of them. Stripe and bucket counts are powers
+// of two with at least as many buckets as stripes, and a bucket's stripe is
+// its index modulo the stripe count, so every bucket has exactly one stripe
+// however often the table doubles.
+//
+// Each key has one node holding the key and its count. Nodes are chained
+// per bucket through atomic pointers and are never freed while the set
+// lives; a key whose count drops to zero keeps its node and is counted
+// again in place. That makes the common case lock-free: Increment,
+// Decrement and Count walk the chain without a lock and, if they find the
+// key, update or read its count atomically. Only an Increment of a key
+// never seen before takes its stripe lock, to link a new node.
+//
+// Resizing relinks the nodes into a new table while readers may be walking
+// the old chains. A reader can then miss its key, but never loops or
+// touches freed memory: the old tables stay allocated, and relinked nodes
+// only point at nodes relinked before them. A sequence counter, odd while a
+// resize runs, tells readers whether a miss can be trusted; if not, they
+// search again under the stripe lock.
+//
+// Memory grows with the number of distinct keys ever counted, not with the
+// number currently above zero.
+template <typename T, typename Hash = std::hash<T>>
+class CountingHashSet {
+ public:
+  explicit CountingHashSet(size_t initial_capacity, size_t stripes = 64,
+                           const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        stripes_(std::bit_ceil(std::max<size_t>(stripes, 1))) {
+    tables_.push_back(std::make_unique<Table>(std::bit_ceil(
+        std::max({initial_capacity, params_.min_buckets, stripes_.size()}))));
+    table_.store(tables_.back().get(), std::memory_order_release);
+  }
+
+  ~CountingHashSet() {
+    Table* table = table_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < table->size; ++i) {
+      Node* node = table->heads[i].load(std::memory_order_relaxed);
+      while (node != nullptr) {
+        Node* next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+      }
+    }
+  }
+
+  CountingHashSet(const CountingHashSet&) = delete;
+  CountingHashSet& operator=(const CountingHashSet&) = delete;
+
+  // Adds one occurrence of |key|. Returns its count afterwards.
+  uint64_t Increment(const T& key) {
+    size_t h = hasher_(key);
+    if (Node* node = Find(key, h)) {
+      return Bump(node);
+    }
+
+    std::unique_lock<std::mutex> lk(StripeOf(h).lock);
+    Table* table = table_.load(std::memory_order_acquire);
+    if (Node* node = FindIn(table, key, h)) {
+      return Bump(node);
+    }
+    auto& head = table->heads[h & (table->size - 1)];
+    auto* node = new Node{key, h, 1, head.load(std::memory_order_relaxed)};
+    head.store(node, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_relaxed);
+    size_t nodes = nodes_.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t cap = table->size;
+    lk.unlock();
+
+    if (static_cast<double>(nodes) >
+        params_.max_load_factor * static_cast<double>(cap)) {
+      Resize(cap);
+    }
+    return 1;
+  }
+
+  // Removes one occurrence of |key|. Returns false if its count was zero.
+  bool Decrement(const T& key) {
+    Node* node = FindOrLocked(key, hasher_(key));
+    if (node == nullptr) {
+      return false;
+    }
+    uint64_t count = node->count.load(std::memory_order_relaxed);
+    do {
+      if (count == 0) {
+        return false;
+      }
+    } while (!node->count.compare_exchange_weak(count, count - 1,
+                                                std::memory_order_relaxed));
+    if (count == 1) {
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Returns how many occurrences of |key| there are.
+  [[nodiscard]] uint64_t Count(const T& key) {
+    Node* node = FindOrLocked(key, hasher_(key));
+    return node == nullptr ? 0 : node->count.load(std::memory_order_relaxed);
+  }
+
+  // Returns the number of distinct keys with a nonzero count.
+  [[nodiscard]] size_t Size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Calls fn(key, count) for every key with a nonzero count, holding every
+  // stripe lock. Counts keep changing meanwhile, so each is a recent value
+  // rather than part of one snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    for (auto& stripe : stripes_) {
+      stripe.lock.lock();
+    }
+    Table* table = table_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < table->size; ++i) {
+      for (Node* node = table->heads[i].load(std::memory_order_acquire);
+           node != nullptr; node = node->next.load(std::memory_order_acquire)) {
+        uint64_t count = node->count.load(std::memory_order_relaxed);
+        if (count != 0) {
+          fn(node->key, count);
+        }
+      }
+    }
+    for (auto& stripe : stripes_) {
+      stripe.lock.unlock();
+    }
+  }
+
+  // Returns the |k| keys with the highest counts, highest first, keeping a
+  // k-element heap during one ForEach pass.
+  [[nodiscard]] std::vector<std::pair<T, uint64_t>> TopK(size_t k) {
+    using Item = std::pair<uint64_t, T>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+    if (k == 0) {
+      return {};
+    }
+    ForEach([&heap, k](const T& key, uint64_t count) {
+      if (heap.size() < k) {
+        heap.emplace(count, key);
+      } else if (count > heap.top().first) {
+        heap.pop();
+        heap.emplace(count, key);
+      }
+    });
+    std::vector<std::pair<T, uint64_t>> top;
+    top.reserve(heap.size());
+    while (!heap.empty()) {
+      top.emplace_back(heap.top().second, heap.top().first);
+      heap.pop();
+    }
+    std::reverse(top.begin(), top.end());
+    return top;
+  }
+
+ private:
+  struct Node {
+    const T key;
+    const size_t hash;
+    std::atomic<uint64_t> count;
+    std::atomic<Node*> next;
+  };
+
+  struct Table {
+    explicit Table(size_t n)
+        : size(n), heads(std::make_unique<std::atomic<Node*>[]>(n)) {}
+    const size_t size;
+    std::unique_ptr<std::atomic<Node*>[]> heads;
+  };
+
+  struct alignas(64) Stripe {
+    std::mutex lock;
+  };
+
+  const HashSetParams params_;
+  std::vector<Stripe> stripes_;
+  std::atomic<Table*> table_;
+  // Every table so far: readers may still be walking a replaced one.
+  std::vector<std::unique_ptr<Table>> tables_;
+  std::mutex resize_mutex_;
+  // Odd while a resize is relinking nodes.
+  std::atomic<uint64_t> resize_seq_{0};
+  std::atomic<size_t> size_{0};
+  std::atomic<size_t> nodes_{0};
+  Hash hasher_;
+
+  // The stripe guarding hash |h|'s bucket in every table: buckets are at
+  // least as many as stripes, and both are powers of two.
+  Stripe& StripeOf(size_t h) { return stripes_[h & (stripes_.size() - 1)]; }
+
+  // Counts one more occurrence in an existing node, which brings the key
+  // back if its count had dropped to zero.
+  uint64_t Bump(Node* node) {
+    uint64_t count = node->count.fetch_add(1, std::memory_order_relaxed);
+    if (count == 0) {
+      size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return count + 1;
+  }
+
+  static Node* FindIn(Table* table, const T& key, size_t h) {
+    for (Node* node = table->heads[h & (table->size - 1)].load(
+             std::memory_order_acquire);
+         node != nullptr; node = node->next.load(std::memory_order_acquire)) {
+      if (node->hash == h && node->key == key) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // Lock-free lookup. May miss a key while a resize runs.
+  Node* Find(const T& key, size_t h) {
+    return FindIn(table_.load(std::memory_order_acquire), key, h);
+  }
+
+  // Lock-free lookup whose miss is trusted only if no resize overlapped it;
+  // otherwise the key is searched for again under its stripe lock.
+  Node* FindOrLocked(const T& key, size_t h) {
+    uint64_t seq = resize_seq_.load(std::memory_order_acquire);
+    if (Node* node = Find(key, h)) {
+      return node;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq % 2 == 0 && resize_seq_.load(std::memory_order_relaxed) == seq) {
+      return nullptr;
+    }
+    std::unique_lock<std::mutex> lk(StripeOf(h).lock);
+    return Find(key, h);
+  }
+
+  void Resize(size_t old_capacity) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+    if (table_.load(std::memory_order_relaxed)->size != old_capacity) {
+      return;  // Another thread already resized
+    }
+    for (auto& stripe : stripes_) {
+      stripe.lock.lock();
+    }
+    resize_seq_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Table* old_table = table_.load(std::memory_order_relaxed);
+    auto new_table = std::make_unique<Table>(old_capacity * 2);
+    for (size_t i = 0; i < old_table->size; ++i) {
+      Node* node = old_table->heads[i].load(std::memory_order_relaxed);
+      while (node != nullptr) {
+        Node* next = node->next.load(std::memory_order_relaxed);
+        auto& head = new_table->heads[node->hash & (new_table->size - 1)];
+        node->next.store(head.load(std::memory_order_relaxed),
+                         std::memory_order_release);
+        head.store(node, std::memory_order_relaxed);
+        node = next;
+      }
+    }
+    table_.store(new_table.get(), std::memory_order_release);
+    tables_.push_back(std::move(new_table));
+
+    resize_seq_.fetch_add(1, std::memory_order_release);
+    for (auto& stripe : stripes_) {
+      stripe.lock.unlock();
+    }
+  }
+};
+
+#endif  // COUNTING_HASH_SET_H
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "src/hash_set_adaptive.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_striped.h"
+
+namespace {
+
+// The same set object runs through every phase in turn, so the adaptive set
+// has to follow the thread count up and back down.
+struct Phase {
+  const char* name;
+  size_t threads;
+};
+
+struct Round {
+  double mops = 0.0;
+  size_t found = 0;  // Tallied so the compiler cannot drop the lookups
+};
+
+// Every tenth operation removes and re-adds its key; the rest are lookups.
+Round RunPhase(HashSetBase<int>& hash_set, size_t num_threads,
+               size_t num_keys, size_t ops_per_thread) {
+  std::vector<size_t> found(num_threads, 0);
+  std::vector<std::vector<int>> streams(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    std::mt19937_64 engine(t + 1);
+    std::uniform_int_distribution<size_t> dist(0, num_keys - 1);
+    streams[t].reserve(ops_per_thread);
+    for (size_t i = 0; i < ops_per_thread; i++) {
+      streams[t].push_back(static_cast<int>(dist(engine)));
+    }
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &streams, &found, t] {
+      size_t local_found = 0;
+      for (size_t i = 0; i < streams[t].size(); i++) {
+        int key = streams[t][i];
+        if (i % 10 == 0 && hash_set.Remove(key)) {
+          hash_set.Add(key);
+        } else if (hash_set.Contains(key)) {
+          local_found++;
+        }
+      }
+      found[t] = local_found;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  Round round;
+  for (size_t f : found) {
+    round.found += f;
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  round.mops = static_cast<double>(num_threads * ops_per_thread) / micros;
+  return round;
+}
+
+template <typename HashSetType>
+bool RunPhases(const char* name, const std::vector<Phase>& phases,
+               size_t num_keys, size_t ops_per_thread) {
+  HashSetType hash_set(16);
+  for (size_t k = 0; k < num_keys; k++) {
+    hash_set.Add(static_cast<int>(k));
+  }
+
+  std::cout << name << ":" << std::endl;
+  for (const Phase& phase : phases) {
+    Round round = RunPhase(hash_set, phase.threads, num_keys, ops_per_thread);
+    std::cout << "  " << phase.name << ": " << round.mops << " Mops/s ("
+              << round.found << " hits)";
+    if constexpr (std::is_same_v<HashSetType, HashSetAdaptive<int>>) {
+      std::cout << (hash_set.IsFineGrained() ? ", striped" : ", coarse");
+    }
+    std::cout << std::endl;
+  }
+  if (hash_set.Size() != num_keys) {
+    std::cerr << name << " failed: size " << hash_set.Size()
+              << " does not match expected size " << num_keys << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  std::string parallel = std::to_string(num_threads) + " threads";
+  std::vector<Phase> phases = {
+      {"1 thread", 1},
+      {parallel.c_str(), num_threads},
+      {"1 thread", 1},
+  };
+
+  bool ok =
+      RunPhases<HashSetCoarseGrained<int>>("coarse_grained", phases, num_keys,
+                                           ops_per_thread) &&
+      RunPhases<HashSetStriped<int>>("striped", phases, num_keys,
+                                     ops_per_thread) &&
+      RunPhases<HashSetRefinable<int>>("refinable", phases, num_keys,
+                                       ops_per_thread) &&
+      RunPhases<HashSetAdaptive<int>>("adaptive", phases, num_keys,
+                                      ops_per_thread);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_striped.h"
+#include "src/zipf.h"
+
+namespace {
+
+using Set = HashSetStriped<int>;
+
+constexpr size_t kRounds = 6;
+
+struct Round {
+  double mops = 0.0;
+  size_t found = 0;  // Tallied so the compiler cannot drop the lookups
+};
+
+// Every tenth operation removes and re-adds its key; the rest are lookups.
+Round RunRound(Set& hash_set, const std::vector<std::vector<int>>& streams) {
+  std::vector<size_t> found(streams.size(), 0);
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < streams.size(); t++) {
+    threads.emplace_back([&hash_set, &streams, &found, t] {
+      size_t local_found = 0;
+      for (size_t i = 0; i < streams[t].size(); i++) {
+        int key = streams[t][i];
+        if (i % 10 == 0 && hash_set.Remove(key)) {
+          hash_set.Add(key);
+        } else if (hash_set.Contains(key)) {
+          local_found++;
+        }
+      }
+      found[t] = local_found;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  Round round;
+  size_t ops = 0;
+  for (size_t t = 0; t < streams.size(); t++) {
+    ops += streams[t].size();
+    round.found += found[t];
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  round.mops = static_cast<double>(ops) / micros;
+  return round;
+}
+
+// Returns false if the adaptive set allocated more stripe generations than
+// there are power-of-two stripe counts in [min_stripes, max_stripes].
+bool RunWorkload(const char* name, size_t num_keys,
+                 const std::vector<std::vector<int>>& streams) {
+  std::cout << name << ":" << std::endl;
+
+  Set fixed(num_keys, StripedOptions{});
+  Set adaptive(num_keys,
+               StripedOptions{.stripes = 4, .adaptive_stripes = true});
+  for (size_t k = 0; k < num_keys; k++) {
+    fixed.Add(static_cast<int>(k));
+    adaptive.Add(static_cast<int>(k));
+  }
+
+  for (size_t r = 0; r < kRounds; r++) {
+    Round fixed_round = RunRound(fixed, streams);
+    Round adaptive_round = RunRound(adaptive, streams);
+    std::cout << "  round " << r << ": fixed 64 stripes " << fixed_round.mops
+              << " Mops/s, adaptive " << adaptive_round.mops << " Mops/s at "
+              << adaptive.StripeCount() << " stripes ("
+              << fixed_round.found + adaptive_round.found << " hits)"
+              << std::endl;
+  }
+
+  StripedOptions defaults;
+  size_t counts = std::bit_width(defaults.max_stripes / defaults.min_stripes);
+  std::cout << "  " << adaptive.StripeGenerationCount()
+            << " stripe generations, at most " << counts << std::endl;
+  return adaptive.StripeGenerationCount() <= counts;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  std::vector<std::vector<int>> uniform(num_threads);
+  std::vector<std::vector<int>> skewed(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    std::mt19937_64 engine(t + 1);
+    std::uniform_int_distribution<size_t> dist(0, num_keys - 1);
+    benchmark::ZipfGenerator zipf(num_keys, 1.1, t + 1);
+    for (size_t i = 0; i < ops_per_thread; i++) {
+      uniform[t].push_back(static_cast<int>(dist(engine)));
+      skewed[t].push_back(static_cast<int>(zipf.Next()));
+    }
+  }
+
+  if (!RunWorkload("Uniform keys", num_keys, uniform) ||
+      !RunWorkload("Zipf 1.1 keys", num_keys, skewed)) {
+    std::cerr << argv[0] << " failed: stripe generations are not reused"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
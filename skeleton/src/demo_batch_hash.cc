@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_sequential.h"
+#include "src/hash_set_striped.h"
+
+namespace {
+
+// Only MixHasher has a vectorised batch kernel.
+using Hash = batch_hash::MixHasher<int>;
+
+template <typename Fn>
+double MillisOf(Fn&& fn) {
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  fn();
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - begin_time)
+      .count();
+}
+
+double MKeysPerSec(size_t keys, double millis) {
+  return static_cast<double>(keys) / (millis * 1000.0);
+}
+
+// Loads |keys| one Add at a time and through AddBatch, then looks up |probes|
+// (half hits) one Contains at a time and through ContainsBatch.
+template <typename HashSetType>
+bool CompareSet(const char* name, const std::vector<int>& keys,
+                const std::vector<int>& probes) {
+  std::unique_ptr<HashSetBase<int>> single(new HashSetType(16));
+  std::unique_ptr<HashSetBase<int>> batched(new HashSetType(16));
+
+  double add_ms = MillisOf([&] {
+    for (int key : keys) {
+      single->Add(key);
+    }
+  });
+  double add_batch_ms =
+      MillisOf([&] { batched->AddBatch(keys.data(), keys.size()); });
+
+  size_t hits = 0;
+  double contains_ms = MillisOf([&] {
+    for (int probe : probes) {
+      if (single->Contains(probe)) {
+        ++hits;
+      }
+    }
+  });
+  auto results = std::make_unique<bool[]>(probes.size());
+  double contains_batch_ms = MillisOf([&] {
+    batched->ContainsBatch(probes.data(), probes.size(), results.get());
+  });
+
+  size_t batch_hits = 0;
+  for (size_t i = 0; i < probes.size(); i++) {
+    if (results[i]) {
+      ++batch_hits;
+    }
+  }
+  if (single->Size() != keys.size() || batched->Size() != keys.size() ||
+      hits != batch_hits) {
+    std::cerr << name << " failed: batch and single-key paths disagree"
+              << std::endl;
+    return false;
+  }
+
+  std::cout << name << ":" << std::endl;
+  std::cout << "  Add           " << MKeysPerSec(keys.size(), add_ms)
+            << " Mkeys/s" << std::endl;
+  std::cout << "  AddBatch      " << MKeysPerSec(keys.size(), add_batch_ms)
+            << " Mkeys/s" << std::endl;
+  std::cout << "  Contains      " << MKeysPerSec(probes.size(), contains_ms)
+            << " Mkeys/s" << std::endl;
+  std::cout << "  ContainsBatch "
+            << MKeysPerSec(probes.size(), contains_batch_ms) << " Mkeys/s"
+            << std::endl;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " count" << std::endl;
+    return 1;
+  }
+  size_t count = std::stoul(std::string(argv[1]));
+
+  std::vector<int> keys(count);
+  std::vector<int> probes(count);
+  for (size_t i = 0; i < count; i++) {
+    keys[i] = static_cast<int>(i);
+    probes[i] = static_cast<int>(i * 2);
+  }
+
+  std::vector<size_t> scalar_out(count);
+  std::vector<size_t> batch_out(count);
+  Hash hasher;
+  double scalar_ms = MillisOf([&] {
+    batch_hash::HashScalar(hasher, keys.data(), count, scalar_out.data());
+  });
+  double batch_ms = MillisOf([&] {
+    batch_hash::HashBatch(hasher, keys.data(), count, batch_out.data());
+  });
+  if (scalar_out != batch_out) {
+    std::cerr << argv[0] << " failed: batch hashes differ from scalar hashes"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "Hashing " << count << " keys:" << std::endl;
+  std::cout << "  scalar " << MKeysPerSec(count, scalar_ms) << " Mkeys/s"
+            << std::endl;
+  std::cout << "  " << batch_hash::KernelName(batch_hash::ActiveKernel())
+            << " " << MKeysPerSec(count, batch_ms) << " Mkeys/s" << std::endl;
+
+  bool ok =
+      CompareSet<HashSetSequential<int, Hash>>("sequential", keys, probes) &&
+      CompareSet<HashSetCoarseGrained<int, Hash>>("coarse_grained", keys,
+                                                  probes) &&
+      CompareSet<HashSetStriped<int, Hash>>("striped", keys, probes) &&
+      CompareSet<HashSetRefinable<int, Hash>>("refinable", keys, probes);
+  return ok ? 0 : 1;
+}
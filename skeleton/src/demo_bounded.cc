@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/hash_set_bounded.h"
+#include "src/zipf.h"
+
+// HashSetBounded as a "recently seen" filter over Zipf-distributed keys,
+// against the textbook LRU set: one mutex around a hash map and a recency
+// list that every hit splices to the front. Each operation looks its key up
+// and adds it on a miss.
+
+namespace {
+
+// The LRU baseline.
+class LruSet {
+ public:
+  explicit LruSet(size_t capacity) : capacity_(capacity) {}
+
+  bool Contains(uint64_t key) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    order_.splice(order_.begin(), order_, it->second);
+    return true;
+  }
+
+  void Add(uint64_t key) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (index_.count(key) != 0) {
+      return;
+    }
+    if (index_.size() == capacity_) {
+      index_.erase(order_.back());
+      order_.pop_back();
+    }
+    order_.push_front(key);
+    index_[key] = order_.begin();
+  }
+
+  size_t Size() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    return index_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::list<uint64_t> order_;  // Most recently used first
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> index_;
+};
+
+struct Result {
+  double mops = 0.0;
+  double hit_ratio = 0.0;
+  size_t size = 0;
+};
+
+template <typename Set>
+Result RunWorkload(Set& set,
+                   const std::vector<std::vector<uint64_t>>& streams) {
+  std::vector<size_t> hits(streams.size(), 0);
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < streams.size(); t++) {
+    threads.emplace_back([&set, &streams, &hits, t] {
+      size_t local_hits = 0;
+      for (uint64_t key : streams[t]) {
+        if (set.Contains(key)) {
+          local_hits++;
+        } else {
+          set.Add(key);
+        }
+      }
+      hits[t] = local_hits;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  size_t ops = 0;
+  size_t total_hits = 0;
+  for (size_t t = 0; t < streams.size(); t++) {
+    ops += streams[t].size();
+    total_hits += hits[t];
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  Result result;
+  result.mops = static_cast<double>(ops) / micros;
+  result.hit_ratio =
+      static_cast<double>(total_hits) / static_cast<double>(ops);
+  result.size = set.Size();
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads capacity ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t capacity = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+  // Sixteen times more distinct keys than fit, so the policy matters.
+  size_t num_keys = 16 * capacity;
+
+  std::cout << "skew, threads, set, Mops/s, hit ratio %, size" << std::endl;
+  for (double skew : {0.6, 0.8, 1.0}) {
+    for (size_t threads : {size_t{1}, num_threads}) {
+      // Zipf draws are too slow to time, so the key streams are generated up
+      // front.
+      std::vector<std::vector<uint64_t>> streams(threads);
+      for (size_t t = 0; t < threads; t++) {
+        benchmark::ZipfGenerator zipf(num_keys, skew, t + 1);
+        streams[t].reserve(ops_per_thread);
+        for (size_t i = 0; i < ops_per_thread; i++) {
+          streams[t].push_back(zipf.Next());
+        }
+      }
+
+      HashSetBounded<uint64_t> clock(capacity);
+      Result clock_result = RunWorkload(clock, streams);
+      LruSet lru(capacity);
+      Result lru_result = RunWorkload(lru, streams);
+      // Both sets must hold at most |capacity| keys, not a rounded-up count.
+      if (clock.Capacity() != capacity || clock_result.size > capacity ||
+          lru_result.size > capacity) {
+        std::cerr << argv[0] << " failed: a set outgrew its capacity"
+                  << std::endl;
+        return 1;
+      }
+      for (const auto& [name, result] :
+           {std::pair{"clock", clock_result}, std::pair{"lru", lru_result}}) {
+        std::cout << skew << ", " << threads << ", " << name << ", "
+                  << result.mops << ", " << result.hit_ratio * 100.0 << ", "
+                  << result.size << std::endl;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <sys/resource.h>  // getrusage
+#include <sys/wait.h>      // waitpid
+#include <unistd.h>        // fork, _exit
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_chained.h"
+#include "src/hash_set_striped.h"
+
+// What a doubling costs HashSetChained, which splits its node chains in
+// place, against HashSetStriped, which copies every element into a new
+// vector of vectors. Each set is grown from 16 buckets to exactly its
+// maximum load, then one more Add triggers the measured resize. Every set
+// runs in its own child process, so peak RSS (ru_maxrss) is its own.
+
+namespace {
+
+using Hash = batch_hash::MixHasher<uint64_t>;
+
+// Key i of the workload; Mix64 is a bijection, so keys are distinct.
+uint64_t KeyOf(uint64_t i) { return batch_hash::Mix64(i + 1); }
+
+double PeakRssMiB() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+// Loads |num_keys| keys with |num_threads| threads, then times the Add of
+// one more. Returns false if the set lost or invented a key.
+template <typename Set>
+bool Measure(const char* name, Set& set, size_t num_threads,
+             size_t num_keys) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&set, num_threads, num_keys, t] {
+      for (size_t i = num_keys * t / num_threads;
+           i < num_keys * (t + 1) / num_threads; i++) {
+        set.Add(KeyOf(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto load_end = std::chrono::steady_clock::now();
+  double rss_before = PeakRssMiB();
+
+  auto resize_begin = std::chrono::steady_clock::now();
+  set.Add(KeyOf(num_keys));
+  auto resize_end = std::chrono::steady_clock::now();
+  double rss_peak = PeakRssMiB();
+
+  if (set.Size() != num_keys + 1 || !set.Contains(KeyOf(0)) ||
+      !set.Contains(KeyOf(num_keys)) || set.Contains(KeyOf(num_keys + 1))) {
+    std::cerr << name << ": wrong contents after resize" << std::endl;
+    return false;
+  }
+  double load_micros =
+      std::chrono::duration<double, std::micro>(load_end - begin_time).count();
+  std::cout << name << ", "
+            << static_cast<double>(num_keys) / load_micros << ", "
+            << std::chrono::duration<double, std::milli>(resize_end -
+                                                         resize_begin)
+                   .count()
+            << ", " << rss_before << ", " << rss_peak << std::endl;
+  return true;
+}
+
+// Runs fn() in a child process; returns whether it exited successfully.
+template <typename Fn>
+bool InChild(Fn&& fn) {
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid < 0) {
+    return false;
+  }
+  if (pid == 0) {
+    bool ok = fn();
+    std::cout.flush();
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  return waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+
+  // Both sets double from 16 buckets and resize once the load factor
+  // exceeds 4, so at buckets * 4 keys the next Add doubles the table.
+  HashSetParams params;
+  size_t buckets = std::bit_floor(
+      std::max<size_t>(num_keys / static_cast<size_t>(params.max_load_factor),
+                       64));
+  num_keys = buckets * static_cast<size_t>(params.max_load_factor);
+
+  std::cout << "set, load Mops/s, resize ms, RSS before MiB, peak RSS MiB"
+            << std::endl;
+  bool chained_ok = InChild([&] {
+    HashSetChained<uint64_t, Hash> set(16);
+    return Measure("chained", set, num_threads, num_keys);
+  });
+  bool striped_ok = InChild([&] {
+    HashSetStriped<uint64_t, Hash> set(16);
+    return Measure("striped", set, num_threads, num_keys);
+  });
+  if (!chained_ok || !striped_ok) {
+    std::cerr << argv[0] << " failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/counting_hash_set.h"
+#include "src/zipf.h"
+
+// Counting event ids under heavy-hitter skew: CountingHashSet against one
+// mutex around an unordered_map of counters. Every thread counts its own
+// Zipf stream, decrementing once in every kDecrementEvery events, then both
+// tallies' top keys are compared. First, every thread inserts new keys that
+// all land in the same bucket, which must all be counted.
+
+namespace {
+
+constexpr size_t kDecrementEvery = 8;
+constexpr size_t kTop = 10;
+
+// The baseline.
+class LockedCounts {
+ public:
+  void Increment(uint64_t key) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    ++counts_[key];
+  }
+
+  void Decrement(uint64_t key) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = counts_.find(key);
+    if (it != counts_.end() && --it->second == 0) {
+      counts_.erase(it);
+    }
+  }
+
+  uint64_t Count(uint64_t key) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = counts_.find(key);
+    return it == counts_.end() ? 0 : it->second;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, uint64_t> counts_;
+};
+
+template <typename Counts>
+double RunWorkload(Counts& counts,
+                   const std::vector<std::vector<uint64_t>>& streams) {
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < streams.size(); t++) {
+    threads.emplace_back([&counts, &streams, t] {
+      const auto& stream = streams[t];
+      for (size_t i = 0; i < stream.size(); i++) {
+        counts.Increment(stream[i]);
+        // Each thread only takes back its own events, so no count can drop
+        // below zero.
+        if (i % kDecrementEvery == kDecrementEvery - 1) {
+          counts.Decrement(stream[i]);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  size_t ops = 0;
+  for (const auto& stream : streams) {
+    ops += stream.size() + stream.size() / kDecrementEvery;
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(ops) / micros;
+}
+
+// Keys of the form k * 16 + 1 crowd into a few buckets (std::hash of an
+// integer is the identity) spread over several stripes' worth of hashes, so
+// the threads keep linking new nodes onto the same heads while the table
+// doubles. Returns false if a node or a count was lost.
+bool CollidingInserts(size_t num_threads) {
+  constexpr uint64_t kKeysPerThread = 2000;
+  CountingHashSet<uint64_t> counts(16);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&counts, num_threads, t] {
+      for (uint64_t i = 0; i < kKeysPerThread; i++) {
+        counts.Increment((i * num_threads + t) * 16 + 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (counts.Size() != num_threads * kKeysPerThread) {
+    return false;
+  }
+  for (uint64_t k = 0; k < num_threads * kKeysPerThread; k++) {
+    if (counts.Count(k * 16 + 1) != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  if (!CollidingInserts(num_threads)) {
+    std::cerr << argv[0] << " failed: colliding inserts lost a key"
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << "skew, counting Mops/s, locked map Mops/s, distinct keys, "
+            << "top key count" << std::endl;
+  for (double skew : {0.8, 1.0, 1.2, 1.5}) {
+    // Zipf draws are too slow to time, so the key streams are generated up
+    // front.
+    std::vector<std::vector<uint64_t>> streams(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      benchmark::ZipfGenerator zipf(num_keys, skew, t + 1);
+      streams[t].reserve(ops_per_thread);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        streams[t].push_back(zipf.Next());
+      }
+    }
+
+    CountingHashSet<uint64_t> counting(1024);
+    double counting_mops = RunWorkload(counting, streams);
+    LockedCounts locked;
+    double locked_mops = RunWorkload(locked, streams);
+
+    std::vector<std::pair<uint64_t, uint64_t>> top = counting.TopK(kTop);
+    if (top.empty()) {
+      std::cerr << argv[0] << " failed: nothing counted" << std::endl;
+      return 1;
+    }
+    for (const auto& [key, count] : top) {
+      if (count != locked.Count(key) || count != counting.Count(key)) {
+        std::cerr << argv[0] << " failed: key " << key << " counted " << count
+                  << " times, expected " << locked.Count(key) << std::endl;
+        return 1;
+      }
+    }
+    std::cout << skew << ", " << counting_mops << ", " << locked_mops << ", "
+              << counting.Size() << ", " << top.front().second << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,226 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_cuckoo_filter.h"
+#include "src/hash_set_striped.h"
+
+// HashSetCuckooFilter against HashSetStriped as a negative cache: both are
+// loaded with the same keys by every thread, then probed with half of them
+// and as many keys never added. Reports false-positive rate, bits per key
+// (live heap bytes, counted by replacing the global operator new) and
+// throughput. The filter is loaded to 94% of its slots, near its limit.
+// Half the keys are then removed from it to check that the rest are still
+// found, except twins of removed keys (see hash_set_cuckoo_filter.h).
+// First, one key is added over and over to check that Add is idempotent.
+
+namespace {
+
+// Each allocation is prefixed with its size so operator delete can subtract
+// it again. 16 bytes keep the block aligned for any fundamental type.
+constexpr size_t kHeader = 16;
+
+std::atomic<size_t> live_bytes{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  auto* p = static_cast<unsigned char*>(std::malloc(size + kHeader));
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(p) = size;
+  live_bytes.fetch_add(size, std::memory_order_relaxed);
+  return p + kHeader;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  unsigned char* p = static_cast<unsigned char*>(ptr) - kHeader;
+  live_bytes.fetch_sub(*reinterpret_cast<size_t*>(p),
+                       std::memory_order_relaxed);
+  std::free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace {
+
+// Key i of the workload; ids past the loaded range are never added.
+uint64_t KeyOf(uint64_t i) { return batch_hash::Mix64(i + 1) ^ 0x5555; }
+
+// Runs fn(t, begin, end) on |threads| threads over [0, n) split evenly.
+// Returns the elapsed time in microseconds.
+template <typename Fn>
+double Parallel(size_t threads, size_t n, Fn&& fn) {
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&fn, t, threads, n] {
+      fn(t, n * t / threads, n * (t + 1) / threads);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end_time - begin_time)
+      .count();
+}
+
+struct Result {
+  double add_mops = 0.0;
+  double lookup_mops = 0.0;
+  double false_positive_rate = 0.0;
+  double bits_per_key = 0.0;
+  size_t not_added = 0;  // Add returned false: the key had a twin
+  bool missed = false;   // Some added key was reported absent
+};
+
+// Adds keys [0, n), then looks up keys [n / 2, 3n / 2): the first half were
+// added and must be found, the second half were not.
+template <typename Set>
+Result Run(Set& set, size_t threads, size_t n, size_t bytes_before) {
+  Result result;
+  std::atomic<size_t> not_added{0};
+  double add_micros = Parallel(threads, n, [&](size_t, size_t b, size_t e) {
+    size_t local = 0;
+    for (size_t i = b; i < e; i++) {
+      if (!set.Add(KeyOf(i))) {
+        local++;
+      }
+    }
+    not_added.fetch_add(local, std::memory_order_relaxed);
+  });
+  result.not_added = not_added.load(std::memory_order_relaxed);
+  result.add_mops = static_cast<double>(n) / add_micros;
+  result.bits_per_key =
+      8.0 *
+      static_cast<double>(live_bytes.load(std::memory_order_relaxed) -
+                          bytes_before) /
+      static_cast<double>(n);
+
+  std::vector<size_t> false_positives(threads, 0);
+  std::atomic<bool> missed{false};
+  double lookup_micros =
+      Parallel(threads, n, [&](size_t t, size_t b, size_t e) {
+        size_t fp = 0;
+        for (size_t i = b; i < e; i++) {
+          bool added = n / 2 + i < n;
+          bool found = set.Contains(KeyOf(n / 2 + i));
+          if (added && !found) {
+            missed.store(true, std::memory_order_relaxed);
+          } else if (!added && found) {
+            fp++;
+          }
+        }
+        false_positives[t] = fp;
+      });
+  result.lookup_mops = static_cast<double>(n) / lookup_micros;
+  size_t total_fp = 0;
+  for (size_t fp : false_positives) {
+    total_fp += fp;
+  }
+  result.false_positive_rate =
+      static_cast<double>(total_fp) / static_cast<double>(n - n / 2);
+  result.missed = missed.load(std::memory_order_relaxed);
+  return result;
+}
+
+// A negative cache re-adds its hot keys all the time. Adding one key many
+// times must store it once, never throw, and leave it absent after a
+// single Remove. Returns false if it does not.
+bool RepeatedAddIsIdempotent() {
+  HashSetCuckooFilter filter(1000);
+  if (!filter.Add(42)) {
+    return false;
+  }
+  for (int i = 1; i < 100; i++) {
+    if (filter.Add(42) || filter.Size() != 1) {
+      return false;
+    }
+  }
+  return filter.Remove(42) && !filter.Contains(42) && filter.Size() == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t capacity = std::stoul(std::string(argv[2]));
+
+  if (!RepeatedAddIsIdempotent()) {
+    std::cerr << argv[0] << " failed: repeated Add of one key" << std::endl;
+    return 1;
+  }
+
+  std::cout << "set, Add Mops/s, Contains Mops/s, false positive %, bits/key"
+            << std::endl;
+
+  size_t bytes_before = live_bytes.load(std::memory_order_relaxed);
+  auto filter = std::make_unique<HashSetCuckooFilter>(capacity);
+  auto num_keys = static_cast<size_t>(
+      0.94 * static_cast<double>(filter->SlotCount()));
+  Result filter_result = Run(*filter, num_threads, num_keys, bytes_before);
+
+  bytes_before = live_bytes.load(std::memory_order_relaxed);
+  auto striped = std::make_unique<
+      HashSetStriped<uint64_t, batch_hash::MixHasher<uint64_t>>>(16);
+  Result striped_result = Run(*striped, num_threads, num_keys, bytes_before);
+  striped.reset();
+
+  for (const auto& [name, result] :
+       {std::pair{"cuckoo_filter", filter_result},
+        std::pair{"striped", striped_result}}) {
+    std::cout << name << ", " << result.add_mops << ", " << result.lookup_mops
+              << ", " << result.false_positive_rate * 100.0 << ", "
+              << result.bits_per_key << std::endl;
+  }
+  if (filter_result.missed || striped_result.missed ||
+      striped_result.false_positive_rate != 0.0 ||
+      striped_result.not_added != 0) {
+    std::cerr << argv[0] << " failed: a lookup was wrong" << std::endl;
+    return 1;
+  }
+
+  // Delete the first half of the keys. Of the second half, only twins of
+  // deleted keys may be lost, and there are at most as many twins as Adds
+  // that returned false.
+  Parallel(num_threads, num_keys / 2, [&filter](size_t, size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      filter->Remove(KeyOf(i));
+    }
+  });
+  size_t lost = 0;
+  for (size_t i = num_keys / 2; i < num_keys; i++) {
+    if (!filter->Contains(KeyOf(i))) {
+      lost++;
+    }
+  }
+  std::cout << "keys " << num_keys << ", twins " << filter_result.not_added
+            << ", lost after deleting half " << lost << std::endl;
+  if (lost > filter_result.not_added) {
+    std::cerr << argv[0] << " failed: deleting keys lost other keys"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
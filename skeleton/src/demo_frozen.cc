@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/frozen_hash_set.h"
+#include "src/hash_set_striped.h"
+
+// Read-only phase: the same lookups against a live striped set and against
+// its frozen copy, one batch of keys per thread. First, sets of small key
+// types that hold every value they can.
+
+namespace {
+
+constexpr size_t kBatch = 256;
+
+// Runs lookup(keys, n, results) over every thread's keys in batches of
+// kBatch. Returns Mops/s; |found| counts hits so the lookups are kept.
+template <typename Lookup>
+double Lookups(const std::vector<std::vector<int>>& keys, Lookup&& lookup,
+               size_t& found) {
+  std::vector<size_t> local_found(keys.size(), 0);
+  std::vector<std::thread> threads;
+  threads.reserve(keys.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < keys.size(); t++) {
+    threads.emplace_back([&keys, &lookup, &local_found, t] {
+      const std::vector<int>& mine = keys[t];
+      auto results = std::make_unique<bool[]>(kBatch);
+      size_t hits = 0;
+      for (size_t start = 0; start < mine.size(); start += kBatch) {
+        size_t n = std::min(kBatch, mine.size() - start);
+        lookup(mine.data() + start, n, results.get());
+        for (size_t i = 0; i < n; i++) {
+          if (results[i]) {
+            hits++;
+          }
+        }
+      }
+      local_found[t] = hits;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  found = 0;
+  size_t total = 0;
+  for (size_t t = 0; t < keys.size(); t++) {
+    found += local_found[t];
+    total += keys[t].size();
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(total) / micros;
+}
+
+template <typename Fn>
+double MillisOf(Fn&& fn) {
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  fn();
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - begin_time)
+      .count();
+}
+
+// Freezes every value of T, each twice, with the keys taken from |begin|
+// on, then checks every value is found and counted once. No value is left
+// over for the empty sentinel.
+template <typename T>
+bool EveryValueIsAKey(T begin) {
+  constexpr size_t kValues = size_t{1} << (sizeof(T) * 8);
+  std::vector<T> values;
+  for (size_t i = 0; i < 2 * kValues; i++) {
+    values.push_back(static_cast<T>(begin + static_cast<T>(i)));
+  }
+  FrozenHashSet<T> frozen(values.data(), values.size(), 2);
+  if (frozen.Size() != kValues) {
+    return false;
+  }
+  for (size_t i = 0; i < kValues; i++) {
+    if (!frozen.Contains(static_cast<T>(i))) {
+      return false;
+    }
+  }
+  // With one value missing, it becomes the sentinel and is not found.
+  FrozenHashSet<T> missing_one(values.data() + 1, kValues - 1, 2);
+  return missing_one.Size() == kValues - 1 && !missing_one.Contains(begin);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads num_keys lookups_per_thread" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t lookups_per_thread = std::stoul(std::string(argv[3]));
+
+  if (!EveryValueIsAKey<uint8_t>(7) || !EveryValueIsAKey<int8_t>(0)) {
+    std::cerr << argv[0] << " failed: a small key type lost a key"
+              << std::endl;
+    return 1;
+  }
+
+  // Even keys only, and lookups over twice the range: about half hit.
+  HashSetStriped<int> striped(num_keys);
+  for (size_t k = 0; k < num_keys; k++) {
+    striped.Add(static_cast<int>(2 * k));
+  }
+  std::vector<std::vector<int>> keys(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    std::mt19937_64 engine(t + 1);
+    std::uniform_int_distribution<size_t> dist(0, 2 * num_keys - 1);
+    keys[t].resize(lookups_per_thread);
+    for (auto& key : keys[t]) {
+      key = static_cast<int>(dist(engine));
+    }
+  }
+
+  std::unique_ptr<FrozenHashSet<int>> frozen;
+  double serial_ms = MillisOf([&] {
+    frozen = std::make_unique<FrozenHashSet<int>>(striped.Freeze(1));
+  });
+  double parallel_ms = MillisOf([&] {
+    frozen = std::make_unique<FrozenHashSet<int>>(striped.Freeze(num_threads));
+  });
+  if (frozen->Size() != striped.Size()) {
+    std::cerr << argv[0] << " failed: frozen size " << frozen->Size()
+              << " != " << striped.Size() << std::endl;
+    return 1;
+  }
+  std::cout << "Freeze " << num_keys << " keys: " << serial_ms
+            << " ms on 1 thread, " << parallel_ms << " ms on " << num_threads
+            << " threads" << std::endl;
+  std::cout << "Frozen size: " << frozen->MemoryBytes() << " bytes ("
+            << static_cast<double>(frozen->MemoryBytes()) /
+                   static_cast<double>(num_keys * sizeof(int))
+            << "x the raw keys)" << std::endl;
+
+  size_t striped_found = 0;
+  size_t striped_batch_found = 0;
+  size_t frozen_found = 0;
+  size_t frozen_batch_found = 0;
+  double striped_mops = Lookups(
+      keys,
+      [&](const int* elems, size_t n, bool* results) {
+        for (size_t i = 0; i < n; i++) {
+          results[i] = striped.Contains(elems[i]);
+        }
+      },
+      striped_found);
+  double striped_batch_mops = Lookups(
+      keys,
+      [&](const int* elems, size_t n, bool* results) {
+        striped.ContainsBatch(elems, n, results);
+      },
+      striped_batch_found);
+  double frozen_mops = Lookups(
+      keys,
+      [&](const int* elems, size_t n, bool* results) {
+        for (size_t i = 0; i < n; i++) {
+          results[i] = frozen->Contains(elems[i]);
+        }
+      },
+      frozen_found);
+  double frozen_batch_mops = Lookups(
+      keys,
+      [&](const int* elems, size_t n, bool* results) {
+        frozen->ContainsBatch(elems, n, results);
+      },
+      frozen_batch_found);
+  if (frozen_found != striped_found || frozen_batch_found != striped_found ||
+      striped_batch_found != striped_found) {
+    std::cerr << argv[0] << " failed: hit counts differ (" << striped_found
+              << ", " << striped_batch_found << ", " << frozen_found << ", "
+              << frozen_batch_found << ")" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Lookups (" << striped_found << " hits per run):" << std::endl;
+  std::cout << "  striped Contains       " << striped_mops << " Mops/s"
+            << std::endl;
+  std::cout << "  striped ContainsBatch  " << striped_batch_mops << " Mops/s"
+            << std::endl;
+  std::cout << "  frozen Contains        " << frozen_mops << " Mops/s"
+            << std::endl;
+  std::cout << "  frozen ContainsBatch   " << frozen_batch_mops << " Mops/s"
+            << std::endl;
+  return 0;
+}
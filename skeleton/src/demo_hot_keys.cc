@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_striped.h"
+#include "src/zipf.h"
+
+namespace {
+
+using Set = HashSetStriped<int>;
+
+// One in kWriteEvery operations re-adds a key it just removed, so cached
+// results keep getting invalidated.
+constexpr size_t kWriteEvery = 100;
+
+struct Result {
+  double mops = 0.0;
+  double hit_rate = 0.0;
+  size_t found = 0;
+};
+
+Result RunWorkload(bool hot_key_cache, size_t num_threads, size_t num_keys,
+                   const std::vector<std::vector<int>>& streams) {
+  Set hash_set(num_keys, StripedOptions{.hot_key_cache = hot_key_cache});
+  for (size_t k = 0; k < num_keys; k++) {
+    // A quarter of the key space is absent, so negative results get cached
+    // too.
+    if (k % 4 != 3) {
+      hash_set.Add(static_cast<int>(k));
+    }
+  }
+
+  std::vector<Set::HotKeyStats> stats(num_threads);
+  // Lookup results are tallied so the compiler cannot drop the bucket scans.
+  std::vector<size_t> found(num_threads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &streams, &stats, &found, t] {
+      size_t local_found = 0;
+      const auto& stream = streams[t];
+      for (size_t i = 0; i < stream.size(); i++) {
+        int key = stream[i];
+        if (i % kWriteEvery == 0 && hash_set.Remove(key)) {
+          hash_set.Add(key);
+        }
+        if (hash_set.Contains(key)) {
+          local_found++;
+        }
+      }
+      found[t] = local_found;
+      stats[t] = Set::ThreadHotKeyStats();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  size_t ops = 0;
+  size_t hits = 0;
+  for (size_t t = 0; t < num_threads; t++) {
+    ops += streams[t].size();
+    hits += stats[t].hits;
+  }
+  Result result;
+  for (size_t f : found) {
+    result.found += f;
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  result.mops = static_cast<double>(ops) / micros;
+  result.hit_rate = static_cast<double>(hits) / static_cast<double>(ops);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  for (double skew : {0.5, 0.8, 1.0, 1.2}) {
+    // Zipf draws are too slow to time, so the key streams are generated up
+    // front.
+    std::vector<std::vector<int>> streams(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      benchmark::ZipfGenerator zipf(num_keys, skew, t + 1);
+      streams[t].reserve(ops_per_thread);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        streams[t].push_back(static_cast<int>(zipf.Next()));
+      }
+    }
+
+    Result locked = RunWorkload(false, num_threads, num_keys, streams);
+    Result cached = RunWorkload(true, num_threads, num_keys, streams);
+    std::cout << "Zipf skew " << skew << ":" << std::endl;
+    std::cout << "  stripe locks    " << locked.mops << " Mops/s, "
+              << locked.found << " keys found" << std::endl;
+    std::cout << "  hot-key cache   " << cached.mops << " Mops/s, "
+              << cached.found << " keys found, hit rate "
+              << cached.hit_rate * 100.0 << "%" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <unistd.h>  // sysconf
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/hash_set_striped.h"
+
+// Startup cost of a huge initial capacity: constructing HashSetStriped<int>
+// with 1M, 10M and 100M buckets, whose BucketArray leaves untouched buckets
+// on zero pages, against value-initialising a std::vector of that many
+// std::vector<int> buckets, as the set used to. Reports construction time
+// and resident memory right after construction and after a few inserts.
+
+namespace {
+
+constexpr size_t kInserts = 1000;
+
+// Current resident set size, from /proc/self/statm.
+double RssMiB() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0;
+  size_t resident = 0;
+  statm >> pages >> resident;
+  return static_cast<double>(resident) *
+         static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+struct Result {
+  double construct_ms = 0.0;
+  double rss_constructed = 0.0;  // MiB over the RSS before construction
+  double rss_inserted = 0.0;     // Same, after kInserts inserts
+};
+
+template <typename Make, typename Insert>
+Result Measure(Make&& make, Insert&& insert) {
+  Result result;
+  double rss_before = RssMiB();
+  auto begin_time = std::chrono::steady_clock::now();
+  auto table = make();
+  auto end_time = std::chrono::steady_clock::now();
+  result.construct_ms =
+      std::chrono::duration<double, std::milli>(end_time - begin_time).count();
+  result.rss_constructed = RssMiB() - rss_before;
+  for (size_t i = 0; i < kInserts; i++) {
+    insert(*table, static_cast<int>(i * 7919));
+  }
+  result.rss_inserted = RssMiB() - rss_before;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " max_capacity" << std::endl;
+    return 1;
+  }
+  size_t max_capacity = std::stoul(std::string(argv[1]));
+
+  std::cout << "capacity, table, construct ms, RSS MiB, RSS after "
+            << kInserts << " adds MiB" << std::endl;
+  for (size_t capacity = 1000000; capacity <= max_capacity; capacity *= 10) {
+    Result lazy = Measure(
+        [capacity] { return std::make_unique<HashSetStriped<int>>(capacity); },
+        [](HashSetStriped<int>& set, int key) { set.Add(key); });
+    Result eager = Measure(
+        [capacity] {
+          return std::make_unique<std::vector<std::vector<int>>>(capacity);
+        },
+        [capacity](std::vector<std::vector<int>>& buckets, int key) {
+          buckets[std::hash<int>{}(key) % capacity].push_back(key);
+        });
+    for (const auto& [name, result] :
+         {std::pair{"striped", lazy}, std::pair{"vector<vector>", eager}}) {
+      std::cout << capacity << ", " << name << ", " << result.construct_ms
+                << ", " << result.rss_constructed << ", "
+                << result.rss_inserted << std::endl;
+    }
+  }
+  return 0;
+}
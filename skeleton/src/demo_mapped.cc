@@ -0,0 +1,114 @@
+#include <sys/resource.h>  // getrusage
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_mapped.h"
+
+// Lookup throughput of HashSetMapped as the table grows, with the table
+// resident and again right after evicting it, i.e. when every lookup has to
+// come from the file as it would for a set larger than memory.
+
+namespace {
+
+// Key i of the set; Mix64 is a bijection, so keys are distinct.
+uint64_t KeyOf(uint64_t i) { return batch_hash::Mix64(i + 1); }
+
+long MajorFaults() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_majflt;
+}
+
+// Random Contains over keys [0, 2 * num_keys): about half hit. Returns
+// Mops/s; |found| tallies hits so the lookups are kept.
+double Lookups(HashSetMapped<>& hash_set, size_t num_threads,
+               size_t num_keys, size_t ops_per_thread, size_t& found) {
+  std::vector<size_t> local_found(num_threads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &local_found, num_keys, ops_per_thread,
+                          t] {
+      std::mt19937_64 engine(t + 1);
+      std::uniform_int_distribution<uint64_t> dist(0, 2 * num_keys - 1);
+      size_t hits = 0;
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        if (hash_set.Contains(KeyOf(dist(engine)))) {
+          hits++;
+        }
+      }
+      local_found[t] = hits;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  found = 0;
+  for (size_t f : local_found) {
+    found += f;
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(num_threads * ops_per_thread) / micros;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads max_keys ops_per_thread table_path" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t max_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  HashSetMapped<> hash_set(argv[4], 1024);
+  std::cout << "keys, table MiB, warm Mops/s, cold Mops/s, "
+            << "major faults per cold lookup, resident MiB after" << std::endl;
+  size_t num_keys = 0;
+  for (size_t target = 1 << 16; target <= max_keys; target *= 4) {
+    for (; num_keys < target; num_keys++) {
+      hash_set.Add(KeyOf(num_keys));
+    }
+    if (hash_set.Size() != num_keys) {
+      std::cerr << argv[0] << " failed: size " << hash_set.Size()
+                << " != " << num_keys << std::endl;
+      return 1;
+    }
+    size_t warm_found = 0;
+    double warm = Lookups(hash_set, num_threads, num_keys, ops_per_thread,
+                          warm_found);
+    hash_set.Evict();
+    long faults_before = MajorFaults();
+    size_t cold_found = 0;
+    double cold = Lookups(hash_set, num_threads, num_keys, ops_per_thread,
+                          cold_found);
+    long faults = MajorFaults() - faults_before;
+    if (warm_found != cold_found) {
+      std::cerr << argv[0] << " failed: " << warm_found << " warm hits but "
+                << cold_found << " cold" << std::endl;
+      return 1;
+    }
+    constexpr double kMiB = 1024.0 * 1024.0;
+    std::cout << num_keys << ", "
+              << static_cast<double>(hash_set.FileBytes()) / kMiB << ", "
+              << warm << ", " << cold << ", "
+              << static_cast<double>(faults) /
+                     static_cast<double>(num_threads * ops_per_thread)
+              << ", " << static_cast<double>(hash_set.ResidentBytes()) / kMiB
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_skiplist.h"
+#include "src/hash_set_striped.h"
+
+namespace {
+
+constexpr size_t kRangeQueries = 200;
+constexpr int kRangeWidth = 1000;
+
+// Mixed point operations on keys in [0, num_keys): 80% Contains, 10% Add,
+// 10% Remove. Returns Mops/s; |found| tallies lookups so they are kept.
+double PointOps(HashSetBase<int>& hash_set, size_t num_threads,
+                size_t num_keys, size_t ops_per_thread, size_t& found) {
+  std::vector<size_t> local_found(num_threads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &local_found, num_keys, ops_per_thread,
+                          t] {
+      std::mt19937_64 engine(t + 1);
+      std::uniform_int_distribution<size_t> dist(0, num_keys - 1);
+      size_t hits = 0;
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        int key = static_cast<int>(dist(engine));
+        switch (i % 10) {
+          case 0:
+            hash_set.Add(key);
+            break;
+          case 1:
+            hash_set.Remove(key);
+            break;
+          default:
+            if (hash_set.Contains(key)) {
+              hits++;
+            }
+        }
+      }
+      local_found[t] = hits;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  for (size_t f : local_found) {
+    found += f;
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(num_threads * ops_per_thread) / micros;
+}
+
+template <typename Fn>
+double MillisOf(Fn&& fn) {
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  fn();
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - begin_time)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  HashSetSkiplist<int> skiplist(num_keys);
+  HashSetStriped<int> striped(num_keys);
+  for (size_t k = 0; k < num_keys; k += 2) {
+    skiplist.Add(static_cast<int>(k));
+    striped.Add(static_cast<int>(k));
+  }
+
+  size_t found = 0;
+  double striped_mops =
+      PointOps(striped, num_threads, num_keys, ops_per_thread, found);
+  double skiplist_mops =
+      PointOps(skiplist, num_threads, num_keys, ops_per_thread, found);
+  std::cout << "Point operations (" << found << " hits):" << std::endl;
+  std::cout << "  striped  " << striped_mops << " Mops/s" << std::endl;
+  std::cout << "  skiplist " << skiplist_mops << " Mops/s" << std::endl;
+
+  // Removed nodes must be freed as the set churns, not kept until it is
+  // destroyed: after many more removals than a reclamation batch, only
+  // about a batch may be left.
+  for (size_t i = 0; i < 100000; i++) {
+    int key = -1 - static_cast<int>(i % 1000);
+    skiplist.Add(key);
+    skiplist.Remove(key);
+  }
+  std::cout << "  skiplist nodes awaiting reclamation after 100000 removals: "
+            << skiplist.RetiredCount() << std::endl;
+  if (skiplist.RetiredCount() > 1000) {
+    std::cerr << argv[0] << " failed: removed nodes are not reclaimed"
+              << std::endl;
+    return 1;
+  }
+
+  // Both sets went through the same operations, but thread interleaving
+  // differs, so only the skiplist's own results are checked for order.
+  std::mt19937_64 engine(42);
+  std::uniform_int_distribution<size_t> dist(0, num_keys - 1);
+  std::vector<int> starts(kRangeQueries);
+  for (auto& start : starts) {
+    start = static_cast<int>(dist(engine));
+  }
+
+  size_t skiplist_hits = 0;
+  bool ordered = true;
+  double skiplist_ms = MillisOf([&] {
+    for (int lo : starts) {
+      int prev = lo - 1;
+      skiplist.RangeForEach(lo, lo + kRangeWidth, [&](int key) {
+        ordered = ordered && key > prev;
+        prev = key;
+        skiplist_hits++;
+      });
+    }
+  });
+  size_t striped_hits = 0;
+  double striped_ms = MillisOf([&] {
+    for (int lo : starts) {
+      striped.ForEach([&](int key) {
+        if (key >= lo && key < lo + kRangeWidth) {
+          striped_hits++;
+        }
+      });
+    }
+  });
+  if (!ordered) {
+    std::cerr << argv[0] << " failed: RangeForEach out of order" << std::endl;
+    return 1;
+  }
+  std::cout << kRangeQueries << " range queries of width " << kRangeWidth
+            << ":" << std::endl;
+  std::cout << "  striped full scan  " << striped_ms << " ms ("
+            << striped_hits << " keys)" << std::endl;
+  std::cout << "  skiplist range     " << skiplist_ms << " ms ("
+            << skiplist_hits << " keys)" << std::endl;
+  return 0;
+}
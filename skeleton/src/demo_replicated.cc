@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_replicated.h"
+#include "src/hash_set_striped.h"
+
+// Read-heavy workloads on HashSetReplicated against HashSetStriped. Thread t
+// is bound to replica t % num_groups, so groups can be formed on a
+// single-socket machine; on a multi-socket machine pass 0 groups to get one
+// replica per NUMA node. Each thread only writes keys it owns, which makes
+// the final contents independent of the interleaving, so both sets must end
+// up equal.
+
+namespace {
+
+using Hash = batch_hash::MixHasher<uint64_t>;
+
+struct Op {
+  bool write = false;
+  uint64_t key = 0;
+};
+
+// Thread t's operations: |read_percent| of them Contains on any key, the
+// rest Add or Remove (alternately) on a key t owns.
+std::vector<Op> MakeStream(size_t t, size_t num_threads, size_t num_keys,
+                           size_t read_percent, size_t ops) {
+  std::vector<Op> stream;
+  stream.reserve(ops);
+  uint64_t state = t + 1;
+  for (size_t i = 0; i < ops; i++) {
+    state = batch_hash::Mix64(state);
+    Op op;
+    op.write = state % 100 >= read_percent;
+    op.key = (state >> 8) % num_keys;
+    if (op.write) {
+      op.key = op.key - op.key % num_threads + t;
+    }
+    stream.push_back(op);
+  }
+  return stream;
+}
+
+template <typename Set>
+double RunWorkload(Set& set, size_t num_groups,
+                   const std::vector<std::vector<Op>>& streams) {
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < streams.size(); t++) {
+    threads.emplace_back([&set, &streams, num_groups, t] {
+      if (num_groups != 0) {
+        HashSetReplicated<uint64_t, Hash>::BindThisThread(t % num_groups);
+      }
+      size_t found = 0;
+      size_t writes = 0;
+      for (const Op& op : streams[t]) {
+        if (!op.write) {
+          found += set.Contains(op.key) ? size_t{1} : size_t{0};
+        } else if (writes++ % 2 == 0) {
+          set.Add(op.key);
+        } else {
+          set.Remove(op.key);
+        }
+      }
+      static_cast<void>(found);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  size_t ops = 0;
+  for (const auto& stream : streams) {
+    ops += stream.size();
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(ops) / micros;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads num_groups num_keys ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_groups = std::stoul(std::string(argv[2]));
+  size_t num_keys = std::stoul(std::string(argv[3]));
+  size_t ops_per_thread = std::stoul(std::string(argv[4]));
+  if (num_keys < num_threads) {
+    num_keys = num_threads;
+  }
+
+  ReplicatedOptions options;
+  for (size_t g = 0; g < num_groups; g++) {
+    // Placeholder CPU lists: every thread is bound explicitly, so only the
+    // number of groups matters.
+    options.cpu_groups.push_back({});
+  }
+
+  std::cout << "read %, replicated Mops/s, striped Mops/s, replicas"
+            << std::endl;
+  for (size_t read_percent : {size_t{90}, size_t{99}, size_t{100}}) {
+    std::vector<std::vector<Op>> streams;
+    streams.reserve(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      streams.push_back(MakeStream(t, num_threads, num_keys, read_percent,
+                                   ops_per_thread));
+    }
+
+    HashSetReplicated<uint64_t, Hash> replicated(num_keys, options);
+    HashSetStriped<uint64_t, Hash> striped(num_keys);
+    for (uint64_t k = 0; k < num_keys; k += 2) {
+      replicated.Add(k);
+      striped.Add(k);
+    }
+    double replicated_mops = RunWorkload(replicated, num_groups, streams);
+    double striped_mops = RunWorkload(striped, num_groups, streams);
+
+    if (replicated.Size() != striped.Size()) {
+      std::cerr << argv[0] << " failed: replicated size " << replicated.Size()
+                << ", striped size " << striped.Size() << std::endl;
+      return 1;
+    }
+    // Writes can reach just past num_keys; see MakeStream.
+    for (uint64_t k = 0; k < num_keys + num_threads; k++) {
+      if (replicated.Contains(k) != striped.Contains(k)) {
+        std::cerr << argv[0] << " failed: sets differ on key " << k
+                  << std::endl;
+        return 1;
+      }
+    }
+    std::cout << read_percent << ", " << replicated_mops << ", "
+              << striped_mops << ", " << replicated.ReplicaCount()
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_extendible.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_segmented.h"
+#include "src/hash_set_striped.h"
+
+namespace {
+
+// Per-operation Add latencies while the table grows from 16 buckets, which
+// is where whole-table resizes (HashSetRefinable::Resize and friends) show
+// up as tail latency. With more threads than cores, the maximum also counts
+// time spent descheduled; one thread shows the resize stalls alone.
+template <typename HashSetType>
+void MeasureLatency(const char* name, size_t num_threads,
+                    size_t ops_per_thread) {
+  HashSetType hash_set(16);
+  std::vector<std::vector<uint64_t>> latencies(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &latencies, ops_per_thread, t] {
+      auto& local = latencies[t];
+      local.reserve(ops_per_thread);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        int elem = static_cast<int>(t * ops_per_thread + i);
+        auto start = std::chrono::steady_clock::now();
+        hash_set.Add(elem);
+        auto end = std::chrono::steady_clock::now();
+        local.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count()));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::steady_clock::now();
+
+  std::vector<uint64_t> all;
+  for (const auto& local : latencies) {
+    all.insert(all.end(), local.begin(), local.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p) {
+    return all[static_cast<size_t>(p * static_cast<double>(all.size() - 1))];
+  };
+  double millis =
+      std::chrono::duration<double, std::milli>(end_time - begin_time).count();
+
+  std::cout << name << " (" << hash_set.Size() << " elements, " << millis
+            << " ms):" << std::endl;
+  std::cout << "  p50 " << percentile(0.5) << " ns, p99 " << percentile(0.99)
+            << " ns, p99.9 " << percentile(0.999) << " ns, max " << all.back()
+            << " ns" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_threads ops_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t ops_per_thread = std::stoul(std::string(argv[2]));
+  if (num_threads == 0 || ops_per_thread == 0) {
+    std::cerr << argv[0] << ": need at least one thread and one operation"
+              << std::endl;
+    return 1;
+  }
+
+  MeasureLatency<HashSetCoarseGrained<int>>("coarse_grained", num_threads,
+                                            ops_per_thread);
+  MeasureLatency<HashSetStriped<int>>("striped", num_threads, ops_per_thread);
+  MeasureLatency<HashSetRefinable<int>>("refinable", num_threads,
+                                        ops_per_thread);
+  MeasureLatency<HashSetSegmented<int>>("segmented", num_threads,
+                                        ops_per_thread);
+  MeasureLatency<HashSetExtendible<int>>("extendible", num_threads,
+                                         ops_per_thread);
+  return 0;
+}
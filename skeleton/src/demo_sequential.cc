@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 
 #include "src/hash_set_sequential.h"
@@ -12,6 +13,7 @@ int main(int argc, char** argv) {
 
   HashSetSequential<int> sequential_set(initial_capacity);
 
+  auto begin_time = std::chrono::high_resolution_clock::now();
   for (size_t i = 0; i < count; i++) {
     sequential_set.Add(static_cast<int>(i));
   }
@@ -32,13 +34,22 @@ int main(int argc, char** argv) {
     }
     sequential_set.Remove(expected_value);
   }
+  auto end_time = std::chrono::high_resolution_clock::now();
   if (sequential_set.Size() != 0) {
     std::cerr << "Expected empty set, got set with size "
               << sequential_set.Size() << std::endl;
     return 1;
   }
 
+  auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   end_time - begin_time)
+                   .count();
   std::cout << "Sequential hash set tests succeeded" << std::endl;
+  // Each key is added, looked up and removed once.
+  std::cout << "Single-threaded operation cost:" << std::endl;
+  std::cout << "  "
+            << static_cast<double>(nanos) / static_cast<double>(3 * count)
+            << " ns/op" << std::endl;
 
   return 0;
 }
@@ -0,0 +1,151 @@
+#include <sys/wait.h>  // waitpid
+#include <unistd.h>    // fork, getpid, _exit
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "src/hash_set_shared.h"
+
+// Several processes hammering one HashSetShared. Each child attaches by name
+// and works on its own key range: add every key, remove every fourth, then
+// check its range. The parent then checks the combined result, which only
+// exists if all of them really shared one table. First, a single process
+// checks that nodes freed under any stripe can be reused by any other.
+
+namespace {
+
+// Returns the child's exit status: 0 if every check passed.
+int RunChild(const std::string& name, size_t id, size_t keys_per_process) {
+  std::unique_ptr<HashSetShared<int>> hash_set =
+      HashSetShared<int>::Open(name);
+  if (!hash_set) {
+    return 2;
+  }
+  int first = static_cast<int>(id * keys_per_process);
+  int last = first + static_cast<int>(keys_per_process);
+  for (int k = first; k < last; k++) {
+    hash_set->Add(k);
+  }
+  for (int k = first; k < last; k += 4) {
+    hash_set->Remove(k);
+  }
+  for (int k = first; k < last; k++) {
+    if (hash_set->Contains(k) != ((k - first) % 4 != 0)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Fills a set to max_elements, empties it, then refills it with keys that
+// all share one stripe. The nodes freed across every stripe must serve the
+// refill: Add may only run out of room once the set is really full.
+bool RefillsFromEveryStripe(const std::string& name) {
+  constexpr int kMaxElements = 4096;
+  std::unique_ptr<HashSetShared<int>> hash_set =
+      HashSetShared<int>::Create(name, 1024, kMaxElements);
+  if (!hash_set) {
+    return false;
+  }
+  HashSetShared<int>::Unlink(name);
+  try {
+    for (int k = 0; k < kMaxElements; k++) {
+      hash_set->Add(k);
+    }
+    for (int k = 0; k < kMaxElements; k++) {
+      hash_set->Remove(k);
+    }
+    // Bucket counts are multiples of the 256 stripes, so multiples of 256
+    // all hash to stripe 0.
+    for (int k = 0; k < kMaxElements; k++) {
+      hash_set->Add(k * 256);
+    }
+  } catch (const std::length_error&) {
+    return false;
+  }
+  return hash_set->Size() == kMaxElements;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_processes keys_per_process"
+              << std::endl;
+    return 1;
+  }
+  size_t num_processes = std::stoul(std::string(argv[1]));
+  size_t keys_per_process = std::stoul(std::string(argv[2]));
+  std::string name = "/demo_shared_" + std::to_string(getpid());
+
+  size_t total_keys = num_processes * keys_per_process;
+  std::unique_ptr<HashSetShared<int>> hash_set =
+      HashSetShared<int>::Create(name, 1024, total_keys);
+  if (!hash_set) {
+    std::cerr << argv[0] << " failed: cannot create " << name << std::endl;
+    return 1;
+  }
+
+  if (!RefillsFromEveryStripe(name + "_refill")) {
+    std::cerr << argv[0] << " failed: Add ran out of nodes below max_elements"
+              << std::endl;
+    HashSetShared<int>::Unlink(name);
+    return 1;
+  }
+
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  std::vector<pid_t> children;
+  for (size_t id = 0; id < num_processes; id++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      _exit(RunChild(name, id, keys_per_process));
+    }
+    if (pid < 0) {
+      std::cerr << argv[0] << " failed: fork" << std::endl;
+      HashSetShared<int>::Unlink(name);
+      return 1;
+    }
+    children.push_back(pid);
+  }
+  bool ok = true;
+  for (pid_t pid : children) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  HashSetShared<int>::Unlink(name);
+
+  size_t expected = total_keys - num_processes * ((keys_per_process + 3) / 4);
+  if (!ok || hash_set->Size() != expected) {
+    std::cerr << argv[0] << " failed: " << (ok ? "" : "a child failed, ")
+              << "size " << hash_set->Size() << ", expected " << expected
+              << std::endl;
+    return 1;
+  }
+  size_t found = 0;
+  hash_set->ForEach([&found](int) { found++; });
+  if (found != expected) {
+    std::cerr << argv[0] << " failed: ForEach saw " << found << " of "
+              << expected << std::endl;
+    return 1;
+  }
+
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  // Each key is added, looked up and (one in four) removed.
+  double ops = static_cast<double>(total_keys) * 2.25;
+  constexpr double kMiB = 1024.0 * 1024.0;
+  std::cout << num_processes << " processes, " << total_keys << " keys: "
+            << ops / micros << " Mops/s" << std::endl;
+  std::cout << "One shared segment of "
+            << static_cast<double>(hash_set->SegmentBytes()) / kMiB
+            << " MiB instead of " << num_processes << " private copies"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_striped.h"
+#include "src/snapshot.h"
+
+// Restart cost: rebuilding a striped set by replaying its Adds, against
+// saving a snapshot and loading it back (bulk bucket copy, generic parallel
+// AddBatch into a refinable set, or serving lookups from the mapped file).
+
+namespace {
+
+template <typename Fn>
+double MillisOf(Fn&& fn) {
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  fn();
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - begin_time)
+      .count();
+}
+
+// Adds keys to |hash_set| one at a time from |num_threads| threads, each
+// taking a contiguous share.
+void Replay(HashSetBase<int>& hash_set, const std::vector<int>& keys,
+            size_t num_threads) {
+  size_t chunk = (keys.size() + num_threads - 1) / num_threads;
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &keys, chunk, t] {
+      size_t end = std::min(keys.size(), (t + 1) * chunk);
+      for (size_t i = t * chunk; i < end; i++) {
+        hash_set.Add(keys[i]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// Counts how many of |keys| (every |stride|-th) |contains| reports present.
+template <typename Contains>
+size_t CountPresent(const std::vector<int>& keys, size_t stride,
+                    Contains&& contains) {
+  size_t found = 0;
+  for (size_t i = 0; i < keys.size(); i += stride) {
+    if (contains(keys[i])) {
+      found++;
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads num_keys snapshot_path"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_keys = std::stoul(std::string(argv[2]));
+  std::string path = argv[3];
+
+  // Distinct keys in scrambled order: an odd multiplier is a bijection.
+  std::vector<int> keys(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    keys[i] = static_cast<int>(static_cast<unsigned>(i) * 2654435761u);
+  }
+  constexpr size_t kStride = 97;
+  size_t expected = (num_keys + kStride - 1) / kStride;
+
+  HashSetStriped<int> original(4);
+  double replay_ms = MillisOf([&] { Replay(original, keys, num_threads); });
+
+  bool saved = false;
+  double save_ms = MillisOf([&] { saved = original.SaveSnapshot(path); });
+  if (!saved) {
+    std::cerr << argv[0] << " failed: cannot write " << path << std::endl;
+    return 1;
+  }
+
+  HashSetStriped<int> loaded(4);
+  bool load_ok = false;
+  double load_ms =
+      MillisOf([&] { load_ok = loaded.LoadSnapshot(path, num_threads); });
+
+  HashSetRefinable<int> refinable(4);
+  size_t refinable_added = 0;
+  double refinable_ms = MillisOf([&] {
+    std::optional<snapshot::Image<int>> image =
+        snapshot::Image<int>::Open(path, /*verify=*/true, num_threads);
+    if (image) {
+      refinable_added = snapshot::LoadInto(*image, refinable, num_threads);
+    }
+  });
+
+  std::optional<snapshot::Image<int>> mapped;
+  double map_ms = MillisOf(
+      [&] { mapped = snapshot::Image<int>::Open(path, /*verify=*/false); });
+  if (!load_ok || !mapped || loaded.Size() != num_keys ||
+      refinable_added != num_keys) {
+    std::cerr << argv[0] << " failed: snapshot did not load back" << std::endl;
+    return 1;
+  }
+
+  size_t loaded_found = CountPresent(
+      keys, kStride, [&](int key) { return loaded.Contains(key); });
+  size_t mapped_found = 0;
+  double mapped_ms = MillisOf([&] {
+    mapped_found = CountPresent(
+        keys, kStride, [&](int key) { return mapped->Contains(key); });
+  });
+  if (loaded_found != expected || mapped_found != expected) {
+    std::cerr << argv[0] << " failed: keys missing after load (" << loaded_found
+              << ", " << mapped_found << " of " << expected << ")"
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << num_keys << " keys, " << num_threads << " threads:" << std::endl;
+  std::cout << "  replay Add               " << replay_ms << " ms" << std::endl;
+  std::cout << "  SaveSnapshot             " << save_ms << " ms" << std::endl;
+  std::cout << "  striped LoadSnapshot     " << load_ms << " ms" << std::endl;
+  std::cout << "  refinable LoadInto       " << refinable_ms << " ms"
+            << std::endl;
+  std::cout << "  map without verify       " << map_ms << " ms, then "
+            << expected << " lookups from the image in " << mapped_ms << " ms"
+            << std::endl;
+  std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_sequential.h"
+#include "src/hash_set_striped.h"
+
+// What copying std::string keys costs a caller that holds std::string_view:
+// the same lookups (half hits) through Contains(std::string(view)) and
+// through the heterogeneous Contains(view), for each set keyed on
+// std::string with StringHash. Heap allocations are counted by replacing
+// the global operator new.
+
+namespace {
+
+std::atomic<size_t> heap_allocations{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Long enough that std::string cannot keep it inline.
+std::string Key(size_t k) {
+  return "com.example.service.endpoint/" + std::to_string(k);
+}
+
+struct Result {
+  double millis = 0.0;
+  size_t hits = 0;
+  size_t allocations = 0;
+};
+
+template <typename Fn>
+Result Measure(const std::vector<std::string_view>& probes, Fn&& lookup) {
+  Result result;
+  size_t before = heap_allocations.load(std::memory_order_relaxed);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (std::string_view probe : probes) {
+    if (lookup(probe)) {
+      ++result.hits;
+    }
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  result.allocations =
+      heap_allocations.load(std::memory_order_relaxed) - before;
+  result.millis =
+      std::chrono::duration<double, std::milli>(end_time - begin_time).count();
+  return result;
+}
+
+template <typename HashSetType>
+bool Compare(const char* name, const std::vector<std::string>& keys,
+             const std::vector<std::string_view>& probes) {
+  HashSetType set(16);
+  for (const auto& key : keys) {
+    set.Emplace(key);
+  }
+  Result copying = Measure(probes, [&set](std::string_view s) {
+    return set.Contains(std::string(s));
+  });
+  Result heterogeneous =
+      Measure(probes, [&set](std::string_view s) { return set.Contains(s); });
+  if (copying.hits != heterogeneous.hits) {
+    std::cerr << name << ": " << copying.hits << " hits copying, "
+              << heterogeneous.hits << " heterogeneous" << std::endl;
+    return false;
+  }
+
+  double n = static_cast<double>(probes.size());
+  std::cout << name << ", " << n / (copying.millis * 1000.0) << ", "
+            << n / (heterogeneous.millis * 1000.0) << ", "
+            << static_cast<double>(copying.allocations) / n << ", "
+            << static_cast<double>(heterogeneous.allocations) / n << std::endl;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_keys num_lookups" << std::endl;
+    return 1;
+  }
+  size_t num_keys = std::stoul(std::string(argv[1]));
+  size_t num_lookups = std::stoul(std::string(argv[2]));
+
+  std::vector<std::string> keys;
+  keys.reserve(num_keys);
+  for (size_t k = 0; k < num_keys; k++) {
+    keys.push_back(Key(k));
+  }
+  // Probes alternate between keys in the set and keys outside it.
+  std::vector<std::string> absent;
+  absent.reserve(num_keys);
+  for (size_t k = 0; k < num_keys; k++) {
+    absent.push_back(Key(num_keys + k));
+  }
+  std::vector<std::string_view> probes;
+  probes.reserve(num_lookups);
+  for (size_t i = 0; i < num_lookups; i++) {
+    const auto& source = i % 2 == 0 ? keys : absent;
+    probes.push_back(source[(i * 7919) % num_keys]);
+  }
+
+  using Hash = StringHash;
+  std::cout << "set, copying Mops/s, heterogeneous Mops/s, "
+            << "copying allocs/op, heterogeneous allocs/op" << std::endl;
+  bool ok =
+      Compare<HashSetSequential<std::string, Hash>>("sequential", keys,
+                                                    probes) &&
+      Compare<HashSetCoarseGrained<std::string, Hash>>("coarse_grained", keys,
+                                                       probes) &&
+      Compare<HashSetStriped<std::string, Hash>>("striped", keys, probes) &&
+      Compare<HashSetRefinable<std::string, Hash>>("refinable", keys, probes);
+  return ok ? 0 : 1;
+}
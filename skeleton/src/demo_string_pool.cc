@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "src/hash_set_striped.h"
+#include "src/string_pool.h"
+#include "src/zipf.h"
+
+// Interning parser tokens: StringPool against the textbook interner, one
+// mutex around an unordered_map from std::string to id, and against
+// HashSetStriped<std::string>, which copies every token into a std::string
+// just to look it up. Every thread interns its own Zipf stream of
+// identifier-like tokens.
+
+namespace {
+
+// The baseline.
+class LockedInterner {
+ public:
+  uint32_t Intern(std::string_view s) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto [it, added] =
+        ids_.try_emplace(std::string(s), static_cast<uint32_t>(ids_.size()));
+    return it->second;
+  }
+
+  size_t Size() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    return ids_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, uint32_t> ids_;
+};
+
+// HashSetStriped has no ids; Add stands in for Intern.
+class StripedInterner {
+ public:
+  uint32_t Intern(std::string_view s) {
+    return set_.Add(std::string(s)) ? 1 : 0;
+  }
+
+  size_t Size() { return set_.Size(); }
+
+ private:
+  HashSetStriped<std::string> set_{1024};
+};
+
+// Token k, padded to between 4 and 35 characters so lengths vary.
+std::string Token(size_t k) {
+  std::string token = "tok_" + std::to_string(k);
+  token.append((k * 7) % 32, static_cast<char>('a' + k % 26));
+  return token;
+}
+
+template <typename Interner>
+double RunWorkload(Interner& interner,
+                   const std::vector<std::vector<std::string_view>>& streams) {
+  std::vector<std::thread> threads;
+  threads.reserve(streams.size());
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < streams.size(); t++) {
+    threads.emplace_back([&interner, &streams, t] {
+      uint32_t sink = 0;
+      for (std::string_view token : streams[t]) {
+        sink += interner.Intern(token);
+      }
+      static_cast<void>(sink);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+
+  size_t ops = 0;
+  for (const auto& stream : streams) {
+    ops += stream.size();
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  return static_cast<double>(ops) / micros;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads num_tokens ops_per_thread" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t num_tokens = std::stoul(std::string(argv[2]));
+  size_t ops_per_thread = std::stoul(std::string(argv[3]));
+
+  std::vector<std::string> vocabulary;
+  vocabulary.reserve(num_tokens);
+  for (size_t k = 0; k < num_tokens; k++) {
+    vocabulary.push_back(Token(k));
+  }
+
+  std::cout << "skew, pool Mops/s, locked map Mops/s, striped<string> Mops/s, "
+            << "distinct, avg length, pool bytes/string" << std::endl;
+  for (double skew : {0.6, 1.0, 1.4}) {
+    // Zipf draws are too slow to time, so the token streams are generated up
+    // front.
+    std::vector<std::vector<std::string_view>> streams(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      benchmark::ZipfGenerator zipf(num_tokens, skew, t + 1);
+      streams[t].reserve(ops_per_thread);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        streams[t].push_back(vocabulary[zipf.Next()]);
+      }
+    }
+
+    StringPool pool;
+    double pool_mops = RunWorkload(pool, streams);
+    LockedInterner locked;
+    double locked_mops = RunWorkload(locked, streams);
+    StripedInterner striped;
+    double striped_mops = RunWorkload(striped, streams);
+
+    if (pool.Size() != locked.Size() || pool.Size() != striped.Size()) {
+      std::cerr << argv[0] << " failed: interned " << pool.Size()
+                << " strings, expected " << locked.Size() << std::endl;
+      return 1;
+    }
+    size_t distinct_bytes = 0;
+    for (uint32_t id = 0; id < pool.Size(); id++) {
+      std::string_view s = pool.View(id);
+      if (pool.Find(s) != id) {
+        std::cerr << argv[0] << " failed: id " << id << " does not round-trip"
+                  << std::endl;
+        return 1;
+      }
+      distinct_bytes += s.size();
+    }
+    double distinct = static_cast<double>(pool.Size());
+    std::cout << skew << ", " << pool_mops << ", " << locked_mops << ", "
+              << striped_mops << ", " << pool.Size() << ", "
+              << static_cast<double>(distinct_bytes) / distinct << ", "
+              << static_cast<double>(pool.MemoryUsage()) / distinct
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/batch_hash.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_striped.h"
+
+// Multi-key transactions (AddAll, Swap, RemoveAll) on the striped and
+// refinable sets, which lock only the stripes or buckets involved, against
+// the same transactions serialized by one external mutex around a striped
+// set. Every transaction in the timed runs must commit. A second run has
+// threads fight over a small pool of key pairs, and checks with ForEach
+// snapshots that no pair is ever seen half added or half removed.
+
+namespace {
+
+// Wraps a set so that a transaction holds one global mutex, which is what
+// callers had to do before the sets supported transactions.
+class GloballyLocked {
+ public:
+  bool AddAll(const uint64_t* elems, size_t n) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    for (size_t i = 0; i < n; ++i) {
+      if (set_.Contains(elems[i])) {
+        return false;
+      }
+    }
+    set_.AddBatch(elems, n);
+    return true;
+  }
+
+  bool RemoveAll(const uint64_t* elems, size_t n) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    for (size_t i = 0; i < n; ++i) {
+      if (!set_.Contains(elems[i])) {
+        return false;
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      set_.Remove(elems[i]);
+    }
+    return true;
+  }
+
+  bool Swap(uint64_t from, uint64_t to) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!set_.Contains(from) || set_.Contains(to)) {
+      return false;
+    }
+    set_.Remove(from);
+    set_.Add(to);
+    return true;
+  }
+
+  [[nodiscard]] size_t Size() const { return set_.Size(); }
+
+ private:
+  std::mutex mutex_;
+  HashSetStriped<uint64_t> set_{1024};
+};
+
+// Each thread repeatedly adds a group of |group_size| fresh keys, swaps one
+// of them for another fresh key and removes the group. Returns millions of
+// keys moved per second, or a negative value if a transaction failed.
+template <typename Set>
+double RunGroups(Set& hash_set, size_t num_threads, size_t rounds,
+                 size_t group_size) {
+  std::vector<char> failed(num_threads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &failed, rounds, group_size, t] {
+      std::vector<uint64_t> group(group_size);
+      uint64_t next = uint64_t{t} << 40;
+      for (size_t r = 0; r < rounds; r++) {
+        for (auto& key : group) {
+          key = batch_hash::Mix64(next++);
+        }
+        uint64_t moved = batch_hash::Mix64(next++);
+        if (!hash_set.AddAll(group.data(), group.size()) ||
+            !hash_set.Swap(group[0], moved)) {
+          failed[t] = 1;
+          return;
+        }
+        group[0] = moved;
+        if (!hash_set.RemoveAll(group.data(), group.size())) {
+          failed[t] = 1;
+          return;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  for (char f : failed) {
+    if (f != 0 || hash_set.Size() != 0) {
+      return -1;
+    }
+  }
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  // Each round adds and removes the group and moves one key.
+  return static_cast<double>(num_threads * rounds * (2 * group_size + 1)) /
+         micros;
+}
+
+// Writers add and remove pairs {2p, 2p + 1} from a pool of |pairs| pairs
+// while one thread takes consistent snapshots with ForEach. Returns false
+// if a snapshot, or the final state, has a pair with only one key.
+template <typename Set>
+bool PairsStayWhole(Set& hash_set, size_t num_threads, size_t rounds,
+                    size_t pairs) {
+  auto whole = [&hash_set, pairs] {
+    std::vector<int> count(pairs, 0);
+    hash_set.ForEach([&count](uint64_t key) { ++count[key / 2]; });
+    for (int c : count) {
+      if (c == 1) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::atomic<size_t> running{num_threads};
+  std::atomic<bool> torn{false};
+  std::thread observer([&] {
+    while (running.load() != 0) {
+      if (!whole()) {
+        torn.store(true);
+      }
+      std::this_thread::yield();
+    }
+  });
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &running, rounds, pairs, t] {
+      for (size_t r = 0; r < rounds; r++) {
+        uint64_t p = batch_hash::Mix64(t * rounds + r) % pairs;
+        const uint64_t pair[] = {2 * p, 2 * p + 1};
+        if (!hash_set.AddAll(pair, 2)) {
+          hash_set.RemoveAll(pair, 2);
+        }
+      }
+      running.fetch_sub(1);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  observer.join();
+  return !torn.load() && whole();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " num_threads rounds_per_thread"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t rounds = std::stoul(std::string(argv[2]));
+
+  std::cout << "group size, striped, refinable, global mutex (M keys/s)"
+            << std::endl;
+  for (size_t group_size = 2; group_size <= 64; group_size *= 2) {
+    // Keep the keys moved per run about the same for every group size.
+    size_t group_rounds = std::max<size_t>(rounds * 2 / group_size, 1);
+    HashSetStriped<uint64_t> striped(1024);
+    HashSetRefinable<uint64_t> refinable(1024);
+    GloballyLocked global;
+    double striped_rate =
+        RunGroups(striped, num_threads, group_rounds, group_size);
+    double refinable_rate =
+        RunGroups(refinable, num_threads, group_rounds, group_size);
+    double global_rate =
+        RunGroups(global, num_threads, group_rounds, group_size);
+    if (striped_rate < 0 || refinable_rate < 0 || global_rate < 0) {
+      std::cerr << argv[0] << " failed: a transaction on fresh keys did not "
+                << "commit (group size " << group_size << ")" << std::endl;
+      return 1;
+    }
+    std::cout << group_size << ", " << striped_rate << ", " << refinable_rate
+              << ", " << global_rate << std::endl;
+  }
+
+  HashSetStriped<uint64_t> striped(16);
+  HashSetRefinable<uint64_t> refinable(16);
+  if (!PairsStayWhole(striped, num_threads, rounds, 64) ||
+      !PairsStayWhole(refinable, num_threads, rounds, 64)) {
+    std::cerr << argv[0] << " failed: saw a pair half added" << std::endl;
+    return 1;
+  }
+  return 0;
+}
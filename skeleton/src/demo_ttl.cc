@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_ttl.h"
+
+// HashSetTtl as a dedup window. First, the cost of evicting a burst of keys
+// as they expire. Then a steady stream of fresh keys, each added and its
+// recent predecessors looked up, with the background evictor running and
+// without it: the evictor keeps the set at one window of keys, and the
+// question is what that does to foreground latency.
+
+namespace {
+
+using Nanos = std::chrono::nanoseconds;
+
+double Percentile(std::vector<double>& samples, double p) {
+  if (samples.empty()) {
+    return 0;
+  }
+  size_t i = static_cast<size_t>(p * static_cast<double>(samples.size()));
+  std::nth_element(samples.begin(),
+                   samples.begin() + static_cast<std::ptrdiff_t>(
+                                         std::min(i, samples.size() - 1)),
+                   samples.end());
+  return samples[std::min(i, samples.size() - 1)];
+}
+
+struct StreamResult {
+  double mops = 0;
+  std::vector<double> latency_ns;  // Every 16th operation
+  bool ok = true;
+};
+
+// Each thread adds fresh keys for |duration| and checks that the key added
+// 64 operations ago is present, unless a TTL has passed since it was added.
+StreamResult Stream(HashSetTtl<uint64_t>& hash_set, size_t num_threads,
+                    std::chrono::milliseconds duration,
+                    std::chrono::milliseconds ttl) {
+  std::vector<StreamResult> local(num_threads);
+  std::vector<size_t> ops(num_threads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  auto begin_time = std::chrono::steady_clock::now();
+  auto end_time = begin_time + duration;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&hash_set, &local, &ops, end_time, ttl, t] {
+      StreamResult& result = local[t];
+      std::chrono::steady_clock::time_point added_at[64];
+      uint64_t next = uint64_t{t} << 48;
+      uint64_t first = next;
+      size_t n = 0;
+      while ((n & 1023) != 0 || std::chrono::steady_clock::now() < end_time) {
+        auto op_begin = std::chrono::steady_clock::now();
+        hash_set.Add(next);
+        // An Add that grows a stripe can stall this thread, so judge the
+        // key's age only after Contains has answered.
+        if (next - first >= 64 && !hash_set.Contains(next - 64) &&
+            std::chrono::steady_clock::now() - added_at[n & 63] < ttl) {
+          result.ok = false;
+        }
+        added_at[n & 63] = op_begin;
+        if ((n & 15) == 0) {
+          result.latency_ns.push_back(static_cast<double>(
+              std::chrono::duration_cast<Nanos>(
+                  std::chrono::steady_clock::now() - op_begin)
+                  .count()));
+        }
+        ++next;
+        ++n;
+      }
+      ops[t] = n;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double micros = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - begin_time)
+                      .count();
+  StreamResult total;
+  size_t total_ops = 0;
+  for (size_t t = 0; t < num_threads; t++) {
+    total.ok = total.ok && local[t].ok;
+    total.latency_ns.insert(total.latency_ns.end(),
+                            local[t].latency_ns.begin(),
+                            local[t].latency_ns.end());
+    total_ops += ops[t];
+  }
+  // Each iteration is one Add and one Contains.
+  total.mops = 2.0 * static_cast<double>(total_ops) / micros;
+  return total;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " num_threads duration_ms ttl_ms"
+              << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  std::chrono::milliseconds duration(std::stoul(std::string(argv[2])));
+  std::chrono::milliseconds ttl(std::stoul(std::string(argv[3])));
+
+  // A burst of keys that all expire together.
+  {
+    constexpr size_t kBurst = 1 << 20;
+    HashSetTtl<uint64_t> hash_set(kBurst, ttl);
+    std::vector<uint64_t> keys(kBurst);
+    for (size_t i = 0; i < kBurst; i++) {
+      keys[i] = i;
+    }
+    hash_set.AddBatch(keys.data(), keys.size());
+    std::this_thread::sleep_for(ttl + std::chrono::milliseconds(100));
+    HashSetTtl<uint64_t>::EvictionStats stats = hash_set.Stats();
+    if (hash_set.Size() != 0 || hash_set.Contains(0)) {
+      std::cerr << argv[0] << " failed: " << hash_set.Size()
+                << " keys left after they expired" << std::endl;
+      return 1;
+    }
+    std::cout << "Evicted a burst of " << stats.evicted << " keys: "
+              << static_cast<double>(stats.cpu.count()) /
+                     static_cast<double>(stats.evicted)
+              << " ns of CPU per key over " << stats.passes
+              << " passes, longest stripe hold "
+              << static_cast<double>(stats.longest_hold.count()) / 1e3
+              << " us" << std::endl;
+  }
+
+  std::cout << "evictor, Mops/s, p50 ns, p99 ns, p99.9 ns, keys held, "
+            << "evictor CPU %, longest stripe hold us" << std::endl;
+  for (bool background : {true, false}) {
+    HashSetTtl<uint64_t> hash_set(
+        1024, ttl, TtlOptions{.background_eviction = background});
+    StreamResult result = Stream(hash_set, num_threads, duration, ttl);
+    if (!result.ok) {
+      std::cerr << argv[0] << " failed: a key vanished before its TTL"
+                << std::endl;
+      return 1;
+    }
+    HashSetTtl<uint64_t>::EvictionStats stats = hash_set.Stats();
+    double cpu = static_cast<double>(stats.cpu.count()) /
+                 static_cast<double>(Nanos(duration).count()) * 100;
+    std::cout << (background ? "on" : "off") << ", " << result.mops << ", "
+              << Percentile(result.latency_ns, 0.5) << ", "
+              << Percentile(result.latency_ns, 0.99) << ", "
+              << Percentile(result.latency_ns, 0.999) << ", "
+              << hash_set.Size() << ", " << cpu << ", "
+              << static_cast<double>(stats.longest_hold.count()) / 1e3
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/hash_set_striped.h"
+#include "src/wal.h"
+
+// Throughput of a HashSetStriped whose Adds and Removes go through the
+// write-ahead log, for several group-commit intervals and with a Sync after
+// every operation, against the same set kept only in memory. The logged
+// sets are then recovered from disk and compared with what they held, also
+// after the newest snapshot is damaged.
+
+namespace {
+
+template <typename Fn>
+double MillisOf(Fn&& fn) {
+  auto begin_time = std::chrono::high_resolution_clock::now();
+  fn();
+  auto end_time = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end_time - begin_time)
+      .count();
+}
+
+// Random Adds and Removes over [0, key_range), optionally followed by a Sync
+// each. Returns Mops/s, counting the final Sync that makes them all durable.
+double Run(HashSetStriped<int>& hash_set, size_t num_threads,
+           size_t ops_per_thread, size_t key_range, bool sync_each) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  double ms = MillisOf([&] {
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&hash_set, ops_per_thread, key_range, sync_each,
+                            t] {
+        std::mt19937_64 engine(t + 1);
+        std::uniform_int_distribution<size_t> dist(0, key_range - 1);
+        for (size_t i = 0; i < ops_per_thread; i++) {
+          int key = static_cast<int>(dist(engine));
+          if (engine() & 1) {
+            hash_set.Add(key);
+          } else {
+            hash_set.Remove(key);
+          }
+          if (sync_each) {
+            hash_set.Sync();
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    hash_set.Sync();
+  });
+  return static_cast<double>(num_threads * ops_per_thread) / (ms * 1000.0);
+}
+
+std::vector<int> Contents(HashSetStriped<int>& hash_set) {
+  std::vector<int> keys;
+  hash_set.ForEach([&keys](int key) { keys.push_back(key); });
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+// Takes two checkpoints with keys logged after each, flips a byte in the
+// newest snapshot, then checks that OpenLog falls back to the older one and
+// replays every key from the log.
+bool DamagedSnapshotRecovers(const std::string& prefix) {
+  std::vector<int> expected;
+  {
+    HashSetStriped<int> hash_set(1024);
+    if (!hash_set.OpenLog(prefix) || !hash_set.Checkpoint()) {
+      return false;
+    }
+    hash_set.Add(-2);
+    if (!hash_set.Checkpoint()) {
+      return false;
+    }
+    hash_set.Add(-3);
+    hash_set.Sync();
+    expected = Contents(hash_set);
+  }
+  wal::Files files = wal::Scan(prefix);
+  if (files.snapshots.size() < 2) {
+    return false;
+  }
+  std::fstream file(wal::SnapshotPath(prefix, files.snapshots.back()),
+                    std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(-1, std::ios::end);
+  char last = static_cast<char>(file.get() ^ 0x5a);
+  file.seekp(-1, std::ios::end);
+  file.put(last);
+  file.close();
+  if (!file) {
+    return false;
+  }
+
+  HashSetStriped<int> recovered(1024);
+  return recovered.OpenLog(prefix) && Contents(recovered) == expected &&
+         recovered.Contains(-2) && recovered.Contains(-3);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads ops_per_thread log_prefix" << std::endl;
+    return 1;
+  }
+  size_t num_threads = std::stoul(std::string(argv[1]));
+  size_t ops_per_thread = std::stoul(std::string(argv[2]));
+  std::string prefix = argv[3];
+  size_t key_range = std::max<size_t>(num_threads * ops_per_thread / 2, 1);
+
+  HashSetStriped<int> in_memory(1024);
+  double base = Run(in_memory, num_threads, ops_per_thread, key_range, false);
+  std::cout << "mode, Mops/s, fdatasyncs, ops per fdatasync" << std::endl;
+  std::cout << "in memory, " << base << ", 0, -" << std::endl;
+
+  struct Mode {
+    const char* name;
+    std::chrono::microseconds interval;
+    bool sync_each;
+  };
+  const Mode modes[] = {
+      {"commit every 10 ms", std::chrono::microseconds(10000), false},
+      {"commit every 1 ms", std::chrono::microseconds(1000), false},
+      {"commit every 100 us", std::chrono::microseconds(100), false},
+      {"Sync every op", std::chrono::microseconds(1000), true},
+  };
+  for (const Mode& mode : modes) {
+    // Synchronous commits are far slower; keep the run short.
+    size_t ops = mode.sync_each ? std::max<size_t>(ops_per_thread / 100, 1)
+                                : ops_per_thread;
+    wal::Destroy(prefix);
+    std::vector<int> expected;
+    double mops = 0;
+    uint64_t syncs = 0;
+    {
+      HashSetStriped<int> logged(1024);
+      if (!logged.OpenLog(prefix, wal::Options{mode.interval})) {
+        std::cerr << argv[0] << " failed: cannot open log " << prefix
+                  << std::endl;
+        return 1;
+      }
+      mops = Run(logged, num_threads, ops, key_range, mode.sync_each);
+      syncs = logged.WriteAheadLog()->Syncs();
+      expected = Contents(logged);
+    }
+    std::cout << mode.name << ", " << mops << ", " << syncs << ", "
+              << static_cast<double>(num_threads * ops) /
+                     static_cast<double>(std::max<uint64_t>(syncs, 1))
+              << std::endl;
+
+    HashSetStriped<int> recovered(1024);
+    bool ok = false;
+    double replay_ms = MillisOf([&] { ok = recovered.OpenLog(prefix); });
+    if (!ok || Contents(recovered) != expected) {
+      std::cerr << argv[0] << " failed: log replay lost keys (" << mode.name
+                << ")" << std::endl;
+      return 1;
+    }
+    std::cout << "  recovered " << expected.size() << " keys from the log in "
+              << replay_ms << " ms" << std::endl;
+  }
+
+  // A checkpoint replaces the log with a snapshot, which bounds recovery.
+  {
+    HashSetStriped<int> hash_set(1024);
+    if (!hash_set.OpenLog(prefix) || !hash_set.Checkpoint()) {
+      std::cerr << argv[0] << " failed: checkpoint" << std::endl;
+      return 1;
+    }
+    hash_set.Add(-1);
+    hash_set.Sync();
+  }
+  HashSetStriped<int> recovered(1024);
+  bool ok = false;
+  double snapshot_ms = MillisOf([&] { ok = recovered.OpenLog(prefix); });
+  if (!ok || !recovered.Contains(-1)) {
+    std::cerr << argv[0] << " failed: recovery after checkpoint" << std::endl;
+    return 1;
+  }
+  std::cout << "  recovered " << recovered.Size()
+            << " keys from a checkpoint in " << snapshot_ms << " ms"
+            << std::endl;
+
+  if (!DamagedSnapshotRecovers(prefix)) {
+    std::cerr << argv[0] << " failed: recovery past a damaged snapshot"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "  recovered past a damaged snapshot" << std::endl;
+  wal::Destroy(prefix);
+  return 0;
+}
@@ -0,0 +1,272 @@
+#ifndef FROZEN_HASH_SET_H
+#define FROZEN_HASH_SET_H
+
+#include <algorithm>    // std::max, std::min, std::sort
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // std::hash
+#include <limits>       // std::numeric_limits
+#include <optional>     // std::optional
+#include <thread>       // std::thread
+#include <type_traits>  // std::is_integral_v, std::is_same_v
+#include <vector>       // std::vector
+
+#include "src/batch_hash.h"
+
+// Immutable set for read-only phases, built once from a key list (usually via
+// a live set's Freeze()). Lookups take no locks and write nothing.
+//
+// Layout: one flat array of keys split into power-of-two many regions. The
+// top bits of the remixed hash pick a region (through a small offset table
+// that stays in cache), the low 32 bits pick the home slot within it, and
+// collisions probe linearly, wrapping inside the region. Regions are filled
+// to kLoadFactor, so a lookup is normally one cache miss and the table takes
+// about sizeof(T) / kLoadFactor bytes per key. Empty slots hold a sentinel
+// value that is not in the set, hence integral keys only (not bool, whose
+// std::vector packs bits). When every value of T is a key, as a set of 8-bit
+// keys can hold, the sentinel is T{} and its membership is a flag outside the
+// table, as in HashSetMapped.
+//
+// Construction is parallel: keys are hashed and partitioned by region in
+// per-thread chunks, then whole regions are filled by different threads.
+template <typename T, typename Hash = std::hash<T>>
+class FrozenHashSet {
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "FrozenHashSet stores integral keys with an empty sentinel");
+
+ public:
+  // Builds from keys[0, n); duplicates are dropped. |threads| == 0 uses one
+  // thread per hardware thread.
+  FrozenHashSet(const T* keys, size_t n, size_t threads = 0) {
+    Build(keys, n, threads);
+  }
+
+  // Builds from every element a set's ForEach visits.
+  template <typename Set>
+  static FrozenHashSet FromSet(Set& set, size_t threads = 0) {
+    std::vector<T> keys;
+    keys.reserve(set.Size());
+    set.ForEach([&keys](const T& elem) { keys.push_back(elem); });
+    return FrozenHashSet(keys.data(), keys.size(), threads);
+  }
+
+  [[nodiscard]] bool Contains(const T& elem) const {
+    return ContainsMixed(elem, Mix(elem));
+  }
+
+  // Hashes a block of keys and prefetches their home slots before probing
+  // any of them, so the cache misses within a block overlap.
+  void ContainsBatch(const T* elems, size_t n, bool* results) const {
+    constexpr size_t kBlock = 16;
+    uint64_t mixed[kBlock];
+    for (size_t start = 0; start < n; start += kBlock) {
+      size_t len = std::min(kBlock, n - start);
+      for (size_t j = 0; j < len; ++j) {
+        mixed[j] = Mix(elems[start + j]);
+        size_t base;
+        size_t cap;
+        size_t home = Home(mixed[j], base, cap);
+        __builtin_prefetch(&slots_[base + home]);
+      }
+      for (size_t j = 0; j < len; ++j) {
+        results[start + j] = ContainsMixed(elems[start + j], mixed[j]);
+      }
+    }
+  }
+
+  [[nodiscard]] size_t Size() const { return size_; }
+
+  // Bytes used by the slot array and the region offsets.
+  [[nodiscard]] size_t MemoryBytes() const {
+    return slots_.size() * sizeof(T) + offsets_.size() * sizeof(size_t);
+  }
+
+ private:
+  static constexpr double kLoadFactor = 0.8;
+  // Regions are sized so that a parallel build has enough of them to share
+  // out, while the offset table stays a few KiB.
+  static constexpr size_t kKeysPerRegion = 16384;
+  static constexpr size_t kMaxRegionBits = 10;
+
+  std::vector<T> slots_;
+  std::vector<size_t> offsets_;  // Region r is slots_[offsets_[r], [r + 1])
+  size_t region_bits_ = 0;
+  size_t size_ = 0;
+  T empty_{};
+  bool has_empty_key_ = false;  // empty_ is a key, stored outside slots_
+  Hash hasher_;
+
+  uint64_t Mix(const T& elem) const {
+    return batch_hash::Mix64(static_cast<uint64_t>(hasher_(elem)));
+  }
+
+  size_t RegionOf(uint64_t mixed) const {
+    if (region_bits_ == 0) {
+      return 0;
+    }
+    return static_cast<size_t>(mixed >> (64 - region_bits_));
+  }
+
+  // Returns the home slot of |mixed| within its region and sets the region's
+  // first slot and size.
+  size_t Home(uint64_t mixed, size_t& base, size_t& cap) const {
+    size_t r = RegionOf(mixed);
+    base = offsets_[r];
+    cap = offsets_[r + 1] - base;
+    // Multiply-shift maps the low 32 bits onto [0, cap) without a division.
+    return static_cast<size_t>(((mixed & 0xffffffffu) * cap) >> 32);
+  }
+
+  bool ContainsMixed(const T& elem, uint64_t mixed) const {
+    if (elem == empty_) {
+      return has_empty_key_;
+    }
+    size_t base;
+    size_t cap;
+    size_t i = Home(mixed, base, cap);
+    while (true) {
+      const T& slot = slots_[base + i];
+      if (slot == elem) {
+        return true;
+      }
+      if (slot == empty_) {
+        return false;
+      }
+      if (++i == cap) {
+        i = 0;
+      }
+    }
+  }
+
+  // A value that is not among keys[0, n): one past the largest key, else one
+  // before the smallest, else the first gap in sorted order. nullopt if
+  // every value of T is a key.
+  static std::optional<T> PickEmpty(const T* keys, size_t n) {
+    if (n == 0) {
+      return T{};
+    }
+    T lo = *std::min_element(keys, keys + n);
+    T hi = *std::max_element(keys, keys + n);
+    if (hi < std::numeric_limits<T>::max()) {
+      return static_cast<T>(hi + 1);
+    }
+    if (lo > std::numeric_limits<T>::lowest()) {
+      return static_cast<T>(lo - 1);
+    }
+    std::vector<T> sorted(keys, keys + n);
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 1; i < n; ++i) {
+      if (sorted[i - 1] + 1 < sorted[i]) {
+        return static_cast<T>(sorted[i - 1] + 1);
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Runs fn(t) for t in [0, threads) on separate threads.
+  template <typename Fn>
+  static void ParallelFor(size_t threads, Fn&& fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+      workers.emplace_back(fn, t);
+    }
+    fn(size_t{0});
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  void Build(const T* keys, size_t n, size_t threads) {
+    if (threads == 0) {
+      threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    while (region_bits_ < kMaxRegionBits &&
+           (n >> region_bits_) > kKeysPerRegion) {
+      ++region_bits_;
+    }
+    size_t regions = size_t{1} << region_bits_;
+    threads = std::min(threads, std::max<size_t>(regions, 1));
+    std::optional<T> empty = PickEmpty(keys, n);
+    empty_ = empty.value_or(T{});
+    has_empty_key_ = !empty;
+
+    // Pass 1: hash each chunk and count its keys per region.
+    std::vector<uint64_t> mixed(n);
+    std::vector<std::vector<size_t>> counts(threads,
+                                            std::vector<size_t>(regions, 0));
+    size_t chunk = (n + threads - 1) / threads;
+    ParallelFor(threads, [&](size_t t) {
+      size_t end = std::min(n, (t + 1) * chunk);
+      for (size_t i = t * chunk; i < end; ++i) {
+        mixed[i] = Mix(keys[i]);
+        ++counts[t][RegionOf(mixed[i])];
+      }
+    });
+
+    // Each chunk's slice of each region in the partitioned order, and each
+    // region's share of the slot array.
+    std::vector<size_t> region_keys(regions + 1, 0);
+    for (size_t r = 0; r < regions; ++r) {
+      size_t cursor = region_keys[r];
+      for (size_t t = 0; t < threads; ++t) {
+        size_t count = counts[t][r];
+        counts[t][r] = cursor;
+        cursor += count;
+      }
+      region_keys[r + 1] = cursor;
+    }
+    offsets_.assign(regions + 1, 0);
+    for (size_t r = 0; r < regions; ++r) {
+      size_t count = region_keys[r + 1] - region_keys[r];
+      // At least one empty slot per region, so every probe terminates.
+      size_t cap =
+          static_cast<size_t>(static_cast<double>(count) / kLoadFactor) + 1;
+      offsets_[r + 1] = offsets_[r] + cap;
+    }
+    slots_.assign(offsets_[regions], empty_);
+
+    // Pass 2: scatter keys into region order.
+    std::vector<T> part_keys(n);
+    std::vector<uint64_t> part_mixed(n);
+    ParallelFor(threads, [&](size_t t) {
+      size_t end = std::min(n, (t + 1) * chunk);
+      for (size_t i = t * chunk; i < end; ++i) {
+        size_t pos = counts[t][RegionOf(mixed[i])]++;
+        part_keys[pos] = keys[i];
+        part_mixed[pos] = mixed[i];
+      }
+    });
+
+    // Pass 3: fill regions; thread t takes every threads-th region.
+    std::vector<size_t> inserted(threads, 0);
+    ParallelFor(threads, [&](size_t t) {
+      for (size_t r = t; r < regions; r += threads) {
+        for (size_t k = region_keys[r]; k < region_keys[r + 1]; ++k) {
+          if (part_keys[k] == empty_) {
+            continue;  // Only when has_empty_key_; counted below
+          }
+          size_t base;
+          size_t cap;
+          size_t i = Home(part_mixed[k], base, cap);
+          while (slots_[base + i] != empty_ &&
+                 slots_[base + i] != part_keys[k]) {
+            if (++i == cap) {
+              i = 0;
+            }
+          }
+          if (slots_[base + i] == empty_) {
+            slots_[base + i] = part_keys[k];
+            ++inserted[t];
+          }
+        }
+      }
+    });
+    size_ = has_empty_key_ ? 1 : 0;
+    for (size_t count : inserted) {
+      size_ += count;
+    }
+  }
+};
+
+#endif  // FROZEN_HASH_SET_H
@@ -0,0 +1,314 @@
+#ifndef HASH_SET_ADAPTIVE_H
+#define HASH_SET_ADAPTIVE_H
+
+#include <algorithm>   // std::max
+#include <array>       // std::array
+#include <atomic>      // std::atomic
+#include <cstddef>     // size_t
+#include <cstdint>     // uint8_t, uint64_t
+#include <functional>  // std::hash
+#include <memory>      // std::unique_ptr
+#include <mutex>       // std::mutex, std::scoped_lock, std::unique_lock
+#include <thread>      // std::this_thread::yield
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
+#include "src/hash_set_sequential.h"
+#include "src/hash_set_striped.h"
+
+// Starts out coarse-grained: a sequential table behind one mutex, which is
+// the cheapest option while a single thread uses the set. Every acquisition
+// tries the lock first; once several consecutive windows see too many failed
+// try_locks, the table is migrated online into a HashSetStriped with
+// adaptive striping. When only one thread has been using the striped table
+// for a while, it is migrated back.
+//
+// Operations on the striped table register in a small array of per-thread
+// gate slots instead of taking a shared lock, so the fine-grained mode keeps
+// scaling. Demotion closes the gate and waits for the slots to drain before
+// copying the elements out.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetAdaptive : public HashSetBase<T> {
+ public:
+  explicit HashSetAdaptive(size_t initial_capacity,
+                           const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        coarse_(std::make_unique<Coarse>(initial_capacity, params_)),
+        mode_(Mode::kCoarse),
+        acquisitions_(0),
+        contended_(0),
+        hot_windows_(0),
+        idle_checks_(0),
+        last_ops_{} {}
+
+  bool Add(T elem) final {
+    return Dispatch([&](auto& set) { return set.Add(std::move(elem)); });
+  }
+
+  bool Remove(T elem) final {
+    return Dispatch([&](auto& set) { return set.Remove(std::move(elem)); });
+  }
+
+  [[nodiscard]] bool Contains(T elem) final {
+    return Dispatch([&](auto& set) { return set.Contains(std::move(elem)); });
+  }
+
+  // Read under whichever representation is current; no sampling.
+  [[nodiscard]] size_t Size() const final {
+    while (true) {
+      Mode mode = mode_.load(std::memory_order_seq_cst);
+      if (mode == Mode::kCoarse) {
+        std::scoped_lock lock(mutex_);
+        if (mode_.load(std::memory_order_relaxed) == Mode::kCoarse) {
+          return coarse_->Size();
+        }
+      } else if (mode == Mode::kFine) {
+        GateSlot* slot = EnterFine();
+        if (slot != nullptr) {
+          size_t size = fine_->Size();
+          ExitFine(slot);
+          return size;
+        }
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  size_t AddBatch(const T* elems, size_t n) final {
+    return Dispatch([&](auto& set) { return set.AddBatch(elems, n); });
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    Dispatch([&](auto& set) {
+      set.ContainsBatch(elems, n, results);
+      return true;
+    });
+  }
+
+  // Calls fn(elem) for every element of the current representation, as a
+  // consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    Dispatch([&](auto& set) {
+      set.ForEach(fn);
+      return true;
+    });
+  }
+
+  // True while the striped representation is in use.
+  [[nodiscard]] bool IsFineGrained() const {
+    return mode_.load(std::memory_order_acquire) == Mode::kFine;
+  }
+
+ private:
+  using Coarse = HashSetSequential<T, Hash>;
+  using Fine = HashSetStriped<T, Hash>;
+
+  // kDraining is only seen while the set is being demoted; operations that
+  // observe it wait for the coarse table to be published.
+  enum class Mode : uint8_t { kCoarse, kDraining, kFine };
+
+  // Promotion samples windows of this many coarse lock acquisitions. A window
+  // is hot when more than kHighContention of them failed try_lock, and
+  // kHotWindows hot windows in a row promote the set.
+  static constexpr uint64_t kContentionWindow = 1024;
+  static constexpr double kHighContention = 1.0 / 32;
+  static constexpr uint64_t kHotWindows = 4;
+
+  // Every kIdleCheckInterval fine-grained operations a thread counts how many
+  // gate slots saw traffic since the previous check. kIdleChecks checks in a
+  // row with at most one active slot demote the set.
+  static constexpr uint64_t kIdleCheckInterval = uint64_t{1} << 14;
+  static constexpr uint64_t kIdleChecks = 8;
+
+  static constexpr size_t kGateSlots = 64;
+
+  // One cache line per slot. Threads are assigned slots round-robin, so up
+  // to kGateSlots threads never share one.
+  struct alignas(64) GateSlot {
+    std::atomic<uint64_t> in_flight{0};
+    std::atomic<uint64_t> ops{0};
+  };
+
+  const HashSetParams params_;      // Passed on to both representations
+  std::unique_ptr<Coarse> coarse_;  // Guarded by mutex_
+  std::unique_ptr<Fine> fine_;      // Valid while mode_ is kFine
+  std::atomic<Mode> mode_;
+  mutable std::mutex mutex_;  // Coarse-mode lock; also serialises migration
+  mutable std::array<GateSlot, kGateSlots> gate_;
+
+  // Contention sampling, guarded by mutex_.
+  uint64_t acquisitions_;
+  uint64_t contended_;
+  uint64_t hot_windows_;
+
+  // Idle detection, guarded by mutex_.
+  uint64_t idle_checks_;
+  std::array<uint64_t, kGateSlots> last_ops_;
+
+  static inline std::atomic<size_t> next_slot_{0};
+
+  static size_t ThreadSlot() {
+    thread_local size_t slot =
+        next_slot_.fetch_add(1, std::memory_order_relaxed) % kGateSlots;
+    return slot;
+  }
+
+  // Runs fn against the current representation. fn is called exactly once,
+  // with either the coarse or the striped table.
+  template <typename Fn>
+  auto Dispatch(Fn&& fn) {
+    while (true) {
+      Mode mode = mode_.load(std::memory_order_seq_cst);
+      if (mode == Mode::kCoarse) {
+        bool contended = !mutex_.try_lock();
+        if (contended) {
+          mutex_.lock();
+        }
+        std::unique_lock<std::mutex> lock(mutex_, std::adopt_lock);
+        if (mode_.load(std::memory_order_relaxed) != Mode::kCoarse) {
+          continue;  // Promoted while we waited.
+        }
+        if (SampleContention(contended)) {
+          Promote();
+          continue;
+        }
+        return fn(*coarse_);
+      }
+      if (mode == Mode::kFine) {
+        GateSlot* slot = EnterFine();
+        if (slot == nullptr) {
+          continue;
+        }
+        auto result = fn(*fine_);
+        ExitFine(slot);
+        MaybeDemote();
+        return result;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Registers the calling thread as running on the striped table. Returns
+  // nullptr if the set is no longer fine-grained.
+  GateSlot* EnterFine() const {
+    GateSlot& slot = gate_[ThreadSlot()];
+    slot.in_flight.fetch_add(1, std::memory_order_seq_cst);
+    if (mode_.load(std::memory_order_seq_cst) != Mode::kFine) {
+      slot.in_flight.fetch_sub(1, std::memory_order_release);
+      return nullptr;
+    }
+    return &slot;
+  }
+
+  static void ExitFine(GateSlot* slot) {
+    slot->ops.fetch_add(1, std::memory_order_relaxed);
+    slot->in_flight.fetch_sub(1, std::memory_order_release);
+  }
+
+  // Records one coarse acquisition; returns true once contention has been
+  // sustained long enough to promote. Caller holds mutex_.
+  bool SampleContention(bool contended) {
+    ++acquisitions_;
+    if (contended) {
+      ++contended_;
+    }
+    if (acquisitions_ < kContentionWindow) {
+      return false;
+    }
+    double rate =
+        static_cast<double>(contended_) / static_cast<double>(acquisitions_);
+    acquisitions_ = 0;
+    contended_ = 0;
+    if (rate <= kHighContention) {
+      hot_windows_ = 0;
+      return false;
+    }
+    return ++hot_windows_ >= kHotWindows;
+  }
+
+  // Table size for |count| elements at the maximum load factor.
+  size_t BucketsFor(size_t count) const {
+    return static_cast<size_t>(static_cast<double>(count) /
+                               params_.max_load_factor) +
+           1;
+  }
+
+  // Moves every element into a new striped table. Caller holds mutex_, so
+  // no coarse operation can run, and no fine one has started yet.
+  void Promote() {
+    std::vector<T> elems;
+    elems.reserve(coarse_->Size());
+    coarse_->ForEach([&](const T& v) { elems.push_back(v); });
+    auto fine = std::make_unique<Fine>(
+        BucketsFor(elems.size()),
+        StripedOptions{.adaptive_stripes = true, .params = params_});
+    fine->AddBatch(elems.data(), elems.size());
+    fine_ = std::move(fine);
+    coarse_.reset();
+    hot_windows_ = 0;
+    idle_checks_ = 0;
+    for (size_t s = 0; s < kGateSlots; ++s) {
+      last_ops_[s] = gate_[s].ops.load(std::memory_order_relaxed);
+    }
+    mode_.store(Mode::kFine, std::memory_order_seq_cst);
+  }
+
+  // Checks every so often whether a single thread is all that is left, and
+  // demotes the set if that has held for kIdleChecks checks. Called outside
+  // the gate.
+  void MaybeDemote() {
+    thread_local uint64_t ops = 0;
+    if (++ops % kIdleCheckInterval != 0) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() ||
+        mode_.load(std::memory_order_relaxed) != Mode::kFine) {
+      return;
+    }
+    size_t active = 0;
+    for (size_t s = 0; s < kGateSlots; ++s) {
+      uint64_t now = gate_[s].ops.load(std::memory_order_relaxed);
+      if (now != last_ops_[s]) {
+        ++active;
+        last_ops_[s] = now;
+      }
+    }
+    if (active > 1) {
+      idle_checks_ = 0;
+      return;
+    }
+    if (++idle_checks_ >= kIdleChecks) {
+      Demote();
+    }
+  }
+
+  // Closes the gate, waits for in-flight striped operations, and moves every
+  // element back into a coarse table. Caller holds mutex_.
+  void Demote() {
+    mode_.store(Mode::kDraining, std::memory_order_seq_cst);
+    for (auto& slot : gate_) {
+      while (slot.in_flight.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+    }
+    std::vector<T> elems;
+    elems.reserve(fine_->Size());
+    fine_->ForEach([&](const T& v) { elems.push_back(v); });
+    auto coarse = std::make_unique<Coarse>(BucketsFor(elems.size()), params_);
+    coarse->AddBatch(elems.data(), elems.size());
+    coarse_ = std::move(coarse);
+    fine_.reset();
+    acquisitions_ = 0;
+    contended_ = 0;
+    hot_windows_ = 0;
+    idle_checks_ = 0;
+    mode_.store(Mode::kCoarse, std::memory_order_seq_cst);
+  }
+};
+
+#endif  // HASH_SET_ADAPTIVE_H
@@ -1,7 +1,30 @@
 #ifndef HASH_SET_BASE_H
 #define HASH_SET_BASE_H
 
-#include <cstddef>
+#include <concepts>     // std::convertible_to
+#include <cstddef>      // size_t
+#include <functional>   // std::hash
+#include <string_view>  // std::string_view
+
+// Lets a set of T be queried with a K without building a T: Hash must be
+// transparent (declare is_transparent), hash a K to the value it gives the
+// equal T, and T must compare equal to K.
+template <typename Hash, typename T, typename K>
+concept HeterogeneousKey = requires(const Hash& hash, const T& elem,
+                                    const K& key) {
+  typename Hash::is_transparent;
+  { hash(key) } -> std::convertible_to<size_t>;
+  { elem == key } -> std::convertible_to<bool>;
+};
+
+// Transparent hash for std::string keys, so sets can be queried with
+// std::string_view or string literals. Hashes the same as std::hash.
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const {
+    return std::hash<std::string_view>{}(s);
+  }
+};
 
 template <typename T>
 class HashSetBase {
@@ -21,6 +44,25 @@ class HashSetBase {
 
   // Returns the size of the hash set.
   [[nodiscard]] virtual size_t Size() const = 0;
+
+  // Adds elems[0, n) to the hash set. Returns how many of them were absent.
+  // Implementations hash the whole batch up front (see src/batch_hash.h).
+  virtual size_t AddBatch(const T* elems, size_t n) {
+    size_t added = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (Add(elems[i])) {
+        ++added;
+      }
+    }
+    return added;
+  }
+
+  // Sets results[i] to whether elems[i] is present, for i in [0, n).
+  virtual void ContainsBatch(const T* elems, size_t n, bool* results) {
+    for (size_t i = 0; i < n; ++i) {
+      results[i] = Contains(elems[i]);
+    }
+  }
 };
 
 #endif  // HASH_SET_BASE_H
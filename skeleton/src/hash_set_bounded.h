@@ -0,0 +1,272 @@
+#ifndef HASH_SET_BOUNDED_H
+#define HASH_SET_BOUNDED_H
+
+#include <algorithm>     // std::max
+#include <atomic>        // std::atomic
+#include <cstddef>       // size_t
+#include <cstdint>       // uint8_t, uint32_t
+#include <functional>    // std::hash
+#include <memory>        // std::unique_ptr
+#include <mutex>         // std::unique_lock
+#include <shared_mutex>  // std::shared_mutex, std::shared_lock
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+
+struct BoundedOptions {
+  // Number of stripes, rounded up to a power of two but no more than the
+  // capacity. The capacity is split between them as evenly as it divides,
+  // so each stripe evicts on its own.
+  size_t stripes = 64;
+};
+
+// A concurrent set that holds at most a fixed number of elements, evicting
+// with CLOCK once full: a "recently seen" filter that cannot grow without
+// limit.
+//
+// The low bits of the hash pick a stripe. Each stripe owns an array of
+// capacity / stripes slots (one more for the first capacity % stripes
+// stripes), a fixed table of buckets indexing them, and a clock hand over
+// the slots. A hit in Contains takes the stripe's lock shared and sets the
+// slot's referenced bit with a relaxed store; nothing is reordered, so
+// concurrent hits on a stripe do not exclude each other.
+// An Add into a full stripe sweeps the hand forward, clearing referenced
+// bits, and evicts the first slot whose bit was already clear.
+//
+// Eviction is per stripe, so the set evicts once any one stripe is full and
+// may hold somewhat fewer than Capacity() elements when keys hash unevenly.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetBounded : public HashSetBase<T> {
+ public:
+  // Holds at most |capacity| elements (at least one).
+  HashSetBounded(size_t capacity, const BoundedOptions& options = {})
+      : capacity_(std::max<size_t>(capacity, 1)),
+        stripe_mask_(StripesFor(capacity_, options.stripes) - 1),
+        stripe_shift_(Log2(stripe_mask_ + 1)),
+        stripes_(std::make_unique<Stripe[]>(stripe_mask_ + 1)) {
+    size_t stripes = stripe_mask_ + 1;
+    for (size_t s = 0; s < stripes; ++s) {
+      size_t slots = capacity_ / stripes + (s < capacity_ % stripes ? 1 : 0);
+      stripes_[s].capacity = slots;
+      stripes_[s].slots = std::make_unique<Slot[]>(slots);
+      stripes_[s].buckets.resize(slots);
+    }
+  }
+
+  HashSetBounded(const HashSetBounded&) = delete;
+  HashSetBounded& operator=(const HashSetBounded&) = delete;
+
+  // Adds |elem|, evicting another element of its stripe if the stripe is
+  // full. An element already present is marked referenced instead.
+  bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
+
+  bool Remove(T elem) final {
+    size_t h = hasher_(elem);
+    Stripe& stripe = StripeOf(h);
+    std::unique_lock<std::shared_mutex> lk(stripe.lock);
+    auto& b = stripe.buckets[BucketOf(stripe, h)];
+    for (size_t i = 0; i < b.size(); ++i) {
+      if (stripe.slots[b[i]].key == elem) {
+        uint32_t slot = b[i];
+        b[i] = b.back();
+        b.pop_back();
+        stripe.slots[slot].used = false;
+        stripe.free.push_back(slot);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // A hit marks the element referenced, which spares it from the next
+  // sweep of the clock hand.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Calls fn(elem) for every element, one stripe at a time under that
+  // stripe's lock held shared. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    for (size_t s = 0; s <= stripe_mask_; ++s) {
+      std::shared_lock<std::shared_mutex> lk(stripes_[s].lock);
+      for (size_t i = 0; i < stripes_[s].next_unused; ++i) {
+        if (stripes_[s].slots[i].used) {
+          fn(stripes_[s].slots[i].key);
+        }
+      }
+    }
+  }
+
+  // The most elements the set holds: the capacity it was constructed with.
+  [[nodiscard]] size_t Capacity() const { return capacity_; }
+
+  // Elements evicted to make room so far.
+  [[nodiscard]] size_t Evictions() const {
+    return evictions_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    T key{};
+    size_t hash = 0;
+    bool used = false;  // Guarded by the stripe lock held exclusively
+    // Set by hits under the stripe lock held shared, cleared by the hand
+    // under it held exclusively.
+    std::atomic<uint8_t> referenced{0};
+  };
+
+  struct alignas(64) Stripe {
+    std::shared_mutex lock;
+    std::unique_ptr<Slot[]> slots;
+    // Each bucket lists the slots whose elements hash to it.
+    std::vector<std::vector<uint32_t>> buckets;
+    std::vector<uint32_t> free;  // Slots emptied by Remove
+    size_t capacity = 0;         // Number of slots, and of buckets
+    size_t next_unused = 0;      // slots[next_unused, end) were never used
+    size_t hand = 0;
+  };
+
+  const size_t capacity_;
+  const size_t stripe_mask_;
+  const size_t stripe_shift_;
+  std::unique_ptr<Stripe[]> stripes_;
+  std::atomic<size_t> size_{0};
+  std::atomic<size_t> evictions_{0};
+  Hash hasher_;
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  // The requested stripe count as a power of two, lowered until every
+  // stripe gets at least one slot.
+  static size_t StripesFor(size_t capacity, size_t stripes) {
+    size_t n = RoundUpToPowerOfTwo(stripes);
+    while (n > capacity) {
+      n >>= 1;
+    }
+    return n;
+  }
+
+  static size_t Log2(size_t n) {
+    size_t log = 0;
+    while ((size_t{1} << log) < n) {
+      ++log;
+    }
+    return log;
+  }
+
+  Stripe& StripeOf(size_t h) { return stripes_[h & stripe_mask_]; }
+
+  size_t BucketOf(const Stripe& stripe, size_t h) const {
+    return (h >> stripe_shift_) % stripe.capacity;
+  }
+
+  static void Reference(Slot& slot) {
+    // Skip the store when the bit is already set, so hot elements do not
+    // keep writing their cache line.
+    if (slot.referenced.load(std::memory_order_relaxed) == 0) {
+      slot.referenced.store(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool ContainsHashed(const T& elem, size_t h) {
+    Stripe& stripe = StripeOf(h);
+    std::shared_lock<std::shared_mutex> lk(stripe.lock);
+    for (uint32_t slot : stripe.buckets[BucketOf(stripe, h)]) {
+      if (stripe.slots[slot].key == elem) {
+        Reference(stripe.slots[slot]);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool AddHashed(T elem, size_t h) {
+    Stripe& stripe = StripeOf(h);
+    std::unique_lock<std::shared_mutex> lk(stripe.lock);
+    auto& b = stripe.buckets[BucketOf(stripe, h)];
+    for (uint32_t slot : b) {
+      if (stripe.slots[slot].key == elem) {
+        Reference(stripe.slots[slot]);
+        return false;
+      }
+    }
+
+    uint32_t slot;
+    if (!stripe.free.empty()) {
+      slot = stripe.free.back();
+      stripe.free.pop_back();
+      size_.fetch_add(1, std::memory_order_relaxed);
+    } else if (stripe.next_unused < stripe.capacity) {
+      slot = static_cast<uint32_t>(stripe.next_unused++);
+      size_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      slot = Evict(stripe);
+    }
+    Slot& s = stripe.slots[slot];
+    s.key = std::move(elem);
+    s.hash = h;
+    s.used = true;
+    s.referenced.store(0, std::memory_order_relaxed);
+    b.push_back(slot);
+    return true;
+  }
+
+  // Sweeps the hand to the first slot not referenced since the last sweep,
+  // clearing the bits it passes, and unlinks that slot's element. Every
+  // slot is in use when this runs. Caller holds stripe.lock exclusively.
+  uint32_t Evict(Stripe& stripe) {
+    while (stripe.slots[stripe.hand].referenced.load(
+               std::memory_order_relaxed) != 0) {
+      stripe.slots[stripe.hand].referenced.store(0, std::memory_order_relaxed);
+      stripe.hand = (stripe.hand + 1) % stripe.capacity;
+    }
+    auto victim = static_cast<uint32_t>(stripe.hand);
+    stripe.hand = (stripe.hand + 1) % stripe.capacity;
+
+    auto& b = stripe.buckets[BucketOf(stripe, stripe.slots[victim].hash)];
+    for (size_t i = 0; i < b.size(); ++i) {
+      if (b[i] == victim) {
+        b[i] = b.back();
+        b.pop_back();
+        break;
+      }
+    }
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    return victim;
+  }
+};
+
+#endif  // HASH_SET_BOUNDED_H
@@ -0,0 +1,349 @@
+#ifndef HASH_SET_CHAINED_H
+#define HASH_SET_CHAINED_H
+
+#include <algorithm>   // std::max, std::min
+#include <atomic>      // std::atomic
+#include <bit>         // std::bit_ceil
+#include <cstddef>     // size_t, std::byte
+#include <functional>  // std::hash
+#include <memory>      // std::unique_ptr
+#include <mutex>       // std::mutex, std::unique_lock
+#include <new>         // placement new
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
+
+// Striped locking over intrusive chains: each element lives in a node that
+// also holds its hash and the link to the next node of its bucket, and the
+// table is an array of chain heads.
+//
+// Bucket and stripe counts are powers of two with at least as many buckets
+// as stripes, so bucket i and its partner i + n in a table of 2n buckets are
+// guarded by the same stripe. Doubling the table therefore only appends n
+// empty heads and splits each chain into its lo and hi halves by testing
+// bit n of the stored hash: nothing is rehashed or copied, and the only
+// allocation is the head array. Halving splices the hi chain back onto the
+// lo one.
+//
+// Nodes come from a pool per stripe, which its lock guards. Since a chain
+// never leaves its stripe, neither does a node, so the pools need no
+// synchronization of their own. Removed nodes are recycled through the
+// pool's free list and memory returns to the system only when the set is
+// destroyed.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetChained : public HashSetBase<T> {
+ public:
+  explicit HashSetChained(size_t initial_capacity, size_t stripes = 64,
+                          const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        stripes_(std::bit_ceil(std::max<size_t>(stripes, 1))),
+        buckets_(NormalizeCapacity(initial_capacity), nullptr),
+        bucket_count_(buckets_.size()),
+        size_(0) {}
+
+  HashSetChained(const HashSetChained&) = delete;
+  HashSetChained& operator=(const HashSetChained&) = delete;
+
+  ~HashSetChained() override {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      NodePool& pool = stripes_[i & (stripes_.size() - 1)].pool;
+      for (Node* node = buckets_[i]; node != nullptr;) {
+        Node* next = node->next;
+        pool.Free(node);
+        node = next;
+      }
+    }
+  }
+
+  // Insert using the corresponding stripe lock.
+  bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
+
+  // Remove under the corresponding stripe lock.
+  bool Remove(T elem) final { return RemoveHashed(elem, hasher_(elem)); }
+
+  // Lookup under the corresponding stripe lock.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // Atomic size is sufficient; stripe locks protect structural changes.
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Keys are hashed in bulk; each one then takes only its own stripe lock.
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Calls fn(elem) for every element, holding every stripe lock.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+    LockAll();
+    for (Node* head : buckets_) {
+      for (Node* node = head; node != nullptr; node = node->next) {
+        fn(node->value);
+      }
+    }
+    UnlockAll();
+  }
+
+  // Number of buckets; a power of two.
+  [[nodiscard]] size_t BucketCount() const {
+    return bucket_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Node {
+    Node* next;
+    size_t hash;
+    T value;
+  };
+
+  // Hands out nodes from chunks that double in size up to kMaxChunkNodes,
+  // reusing freed nodes first.
+  class NodePool {
+   public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    Node* Allocate(Node* next, size_t hash, T value) {
+      void* slot;
+      if (free_ != nullptr) {
+        slot = free_;
+        free_ = free_->next;
+      } else {
+        if (used_ == chunk_nodes_) {
+          chunk_nodes_ = chunks_.empty() ? kMinChunkNodes
+                                         : std::min(chunk_nodes_ * 2,
+                                                    kMaxChunkNodes);
+          chunks_.push_back(
+              std::make_unique_for_overwrite<Slot[]>(chunk_nodes_));
+          used_ = 0;
+        }
+        slot = &chunks_.back()[used_++];
+      }
+      return new (slot) Node{next, hash, std::move(value)};
+    }
+
+    void Free(Node* node) {
+      node->~Node();
+      auto* slot = reinterpret_cast<FreeSlot*>(node);
+      slot->next = free_;
+      free_ = slot;
+    }
+
+   private:
+    static constexpr size_t kMinChunkNodes = 16;
+    static constexpr size_t kMaxChunkNodes = 4096;
+
+    struct alignas(Node) Slot {
+      std::byte bytes[sizeof(Node)];
+    };
+    struct FreeSlot {
+      FreeSlot* next;
+    };
+    static_assert(sizeof(FreeSlot) <= sizeof(Slot));
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    size_t chunk_nodes_ = 0;  // Slots in chunks_.back()
+    size_t used_ = 0;         // Slots of chunks_.back() handed out
+    FreeSlot* free_ = nullptr;
+  };
+
+  // One cache line per stripe, so locks do not falsely share.
+  struct alignas(64) Stripe {
+    std::mutex lock;
+    NodePool pool;  // Nodes of this stripe's buckets; guarded by lock
+  };
+
+  const HashSetParams params_;
+  std::vector<Stripe> stripes_;
+  std::vector<Node*> buckets_;  // Chain heads; guarded by the stripe locks
+  // buckets_.size(), readable before taking a stripe lock.
+  std::atomic<size_t> bucket_count_;
+  std::atomic<size_t> size_;  // Updated inside stripe CS; relaxed is OK
+  Hash hasher_;
+  std::mutex resize_mutex_;  // Protects resize operations
+
+  size_t NormalizeCapacity(size_t cap) const {
+    return std::bit_ceil(
+        std::max({cap, params_.min_buckets, stripes_.size()}));
+  }
+
+  // Approximate load factor; exactness not required for triggering resize.
+  double LoadFactor() const {
+    return static_cast<double>(size_.load(std::memory_order_relaxed)) /
+           static_cast<double>(bucket_count_.load(std::memory_order_relaxed));
+  }
+
+  // Locks the stripe of hash |h| and sets |index| to its bucket. A resize
+  // never moves a hash to another stripe, so unlike HashSetStriped there is
+  // nothing to re-check once the lock is held.
+  Stripe& LockStripe(size_t h, size_t& index) {
+    Stripe& stripe = stripes_[h & (stripes_.size() - 1)];
+    stripe.lock.lock();
+    index = h & (buckets_.size() - 1);
+    return stripe;
+  }
+
+  bool AddHashed(T elem, size_t h) {
+    {
+      size_t i;
+      Stripe& stripe = LockStripe(h, i);
+      std::unique_lock<std::mutex> lk(stripe.lock, std::adopt_lock);
+      if (FindNode(buckets_[i], elem, h) != nullptr) {
+        return false;
+      }
+      buckets_[i] = stripe.pool.Allocate(buckets_[i], h, std::move(elem));
+      size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (LoadFactor() > params_.max_load_factor) {
+      Resize(BucketCount() * 2);
+    }
+    return true;
+  }
+
+  bool RemoveHashed(const T& elem, size_t h) {
+    {
+      size_t i;
+      Stripe& stripe = LockStripe(h, i);
+      std::unique_lock<std::mutex> lk(stripe.lock, std::adopt_lock);
+      Node** link = &buckets_[i];
+      while (*link != nullptr &&
+             !((*link)->hash == h && (*link)->value == elem)) {
+        link = &(*link)->next;
+      }
+      if (*link == nullptr) {
+        return false;
+      }
+      Node* node = *link;
+      *link = node->next;
+      stripe.pool.Free(node);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    if (params_.min_load_factor > 0 && LoadFactor() < params_.min_load_factor &&
+        BucketCount() / 2 >= NormalizeCapacity(0)) {
+      Resize(BucketCount() / 2);
+    }
+    return true;
+  }
+
+  bool ContainsHashed(const T& elem, size_t h) {
+    size_t i;
+    Stripe& stripe = LockStripe(h, i);
+    std::unique_lock<std::mutex> lk(stripe.lock, std::adopt_lock);
+    return FindNode(buckets_[i], elem, h) != nullptr;
+  }
+
+  // The stored hash screens out most mismatches before comparing keys.
+  static Node* FindNode(Node* node, const T& elem, size_t h) {
+    for (; node != nullptr; node = node->next) {
+      if (node->hash == h && node->value == elem) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  void LockAll() {
+    for (auto& stripe : stripes_) {
+      stripe.lock.lock();
+    }
+  }
+
+  void UnlockAll() {
+    for (auto& stripe : stripes_) {
+      stripe.lock.unlock();
+    }
+  }
+
+  // Doubles or halves the table in place; see the class comment.
+  void Resize(size_t new_capacity) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+
+    new_capacity = NormalizeCapacity(new_capacity);
+    size_t old_capacity = buckets_.size();
+
+    // Check if another thread already resized.
+    bool grow = new_capacity > old_capacity;
+    if (new_capacity == old_capacity ||
+        (grow && LoadFactor() <= params_.max_load_factor) ||
+        (!grow && LoadFactor() >= params_.min_load_factor)) {
+      return;
+    }
+
+    LockAll();
+    if (grow) {
+      for (size_t cap = old_capacity; cap < new_capacity; cap *= 2) {
+        Split(cap);
+      }
+    } else {
+      for (size_t cap = old_capacity; cap > new_capacity; cap /= 2) {
+        Merge(cap);
+      }
+    }
+    bucket_count_.store(buckets_.size(), std::memory_order_release);
+    UnlockAll();
+  }
+
+  // Doubles the table from |cap| buckets: chain i keeps the nodes whose hash
+  // has bit |cap| clear and hands the rest, in order, to chain i + cap.
+  void Split(size_t cap) {
+    buckets_.resize(cap * 2, nullptr);
+    for (size_t i = 0; i < cap; ++i) {
+      Node** lo = &buckets_[i];
+      Node** hi = &buckets_[i + cap];
+      for (Node* node = buckets_[i]; node != nullptr; node = node->next) {
+        if ((node->hash & cap) == 0) {
+          *lo = node;
+          lo = &node->next;
+        } else {
+          *hi = node;
+          hi = &node->next;
+        }
+      }
+      *lo = nullptr;
+      *hi = nullptr;
+    }
+  }
+
+  // Halves the table from |cap| buckets by appending chain i + cap / 2 to
+  // chain i.
+  void Merge(size_t cap) {
+    size_t half = cap / 2;
+    for (size_t i = 0; i < half; ++i) {
+      Node** tail = &buckets_[i];
+      while (*tail != nullptr) {
+        tail = &(*tail)->next;
+      }
+      *tail = buckets_[i + half];
+    }
+    buckets_.resize(half);
+    buckets_.shrink_to_fit();
+  }
+};
+
+#endif  // HASH_SET_CHAINED_H
@@ -1,7 +1,7 @@
 #ifndef HASH_SET_COARSE_GRAINED_H
 #define HASH_SET_COARSE_GRAINED_H
 
-#include <algorithm>  // std::find
+#include <algorithm>  // std::max
 #include <cassert>
 #include <cstddef>     // size_t
 #include <functional>  // std::hash
@@ -9,55 +9,64 @@
 #include <utility>     // std::move
 #include <vector>      // std::vector
 
+#include "src/batch_hash.h"
+#include "src/bucket.h"
 #include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
 
 // One global mutex protects the entire table for Add/Remove/Contains/Size.
-template <typename T>
+template <typename T, typename Hash = std::hash<T>>
 class HashSetCoarseGrained : public HashSetBase<T> {
  public:
-  explicit HashSetCoarseGrained(size_t initial_capacity)
-      : buckets_(
-            std::max<size_t>(NormalizeCapacity(initial_capacity), kMinBuckets)),
+  explicit HashSetCoarseGrained(size_t initial_capacity,
+                                const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        buckets_(NormalizeCapacity(initial_capacity)),
         size_(0) {}
 
-  // Entire operation under the global lock.
+  // Entire operation under the global lock; hashing happens before it.
   bool Add(T elem) final {
+    size_t h = hasher_(elem);
     std::scoped_lock lock(mutex_);
-    size_t i = Index(elem);
-    auto& b = buckets_[i];
-    if (std::find(b.begin(), b.end(), elem) != b.end()) {
-      return false;
-    }
-    b.push_back(std::move(elem));
-    ++size_;
-    if (LoadFactor() > 4.0) {
-      Resize(buckets_.size() * 2);
-    }
-    return true;
+    return AddHashed(std::move(elem), h);
   }
 
-  // Entire operation under the global lock.
+  // Constructs the element from |args| and adds it as Add does.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Add(T(std::forward<Args>(args)...));
+  }
+
+  // Entire operation under the global lock; hashing happens before it.
   bool Remove(T elem) final {
+    size_t h = hasher_(elem);
     std::scoped_lock lock(mutex_);
-    size_t i = Index(elem);
-    auto& b = buckets_[i];
-    auto it = std::find(b.begin(), b.end(), elem);
-    if (it == b.end()) {
-      return false;
-    }
-    b.erase(it);
-    --size_;
-    if (LoadFactor() < 1.0) {
-      Resize(buckets_.size() / 2);
-    }
-    return true;
+    return RemoveHashed(elem, h);
   }
-  // Entire operation under the global lock.
+
+  // Heterogeneous Remove: finds |key| without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  bool Remove(const K& key) {
+    size_t h = hasher_(key);
+    std::scoped_lock lock(mutex_);
+    return RemoveHashed(key, h);
+  }
+
+  // Entire operation under the global lock; hashing happens before it.
   [[nodiscard]] bool Contains(T elem) final {
+    size_t h = hasher_(elem);
     std::scoped_lock lock(mutex_);
-    size_t i = Index(elem);
-    auto& b = buckets_[i];
-    return std::find(b.begin(), b.end(), elem) != b.end();
+    return ContainsHashed(elem, h);
+  }
+
+  // Heterogeneous Contains: looks |key| up without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  [[nodiscard]] bool Contains(const K& key) {
+    size_t h = hasher_(key);
+    std::scoped_lock lock(mutex_);
+    return ContainsHashed(key, h);
   }
   // Entire operation under the global lock.
   [[nodiscard]] size_t Size() const final {
@@ -65,27 +74,117 @@ class HashSetCoarseGrained : public HashSetBase<T> {
     return size_;
   }
 
+  // Each block of the batch is hashed outside the lock and then inserted
+  // under one acquisition; the table is grown once up front.
+  size_t AddBatch(const T* elems, size_t n) final {
+    {
+      std::scoped_lock lock(mutex_);
+      Reserve(size_ + n);
+    }
+    size_t added = 0;
+    batch_hash::ForEachHashedBlock(
+        hasher_, elems, n, [&](size_t base, size_t len, const size_t* hashes) {
+          std::scoped_lock lock(mutex_);
+          for (size_t j = 0; j < len; ++j) {
+            if (AddHashed(elems[base + j], hashes[j])) {
+              ++added;
+            }
+          }
+        });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashedBlock(
+        hasher_, elems, n, [&](size_t base, size_t len, const size_t* hashes) {
+          std::scoped_lock lock(mutex_);
+          for (size_t j = 0; j < len; ++j) {
+            results[base + j] = ContainsHashed(elems[base + j], hashes[j]);
+          }
+        });
+  }
+
+  // Calls fn(elem) for every element under the global lock. fn must not call
+  // back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::scoped_lock lock(mutex_);
+    for (const auto& b : buckets_) {
+      for (const auto& v : b) {
+        fn(v);
+      }
+    }
+  }
+
  private:
   mutable std::mutex mutex_;  // Global lock guarding all state
+  const HashSetParams params_;
   std::vector<std::vector<T>> buckets_;
   size_t size_;
-  std::hash<T> hasher_;
-
-  static constexpr size_t kMinBuckets = 4;
-  static constexpr double kMaxLoadFactor = 4.0;
+  Hash hasher_;
 
-  static size_t NormalizeCapacity(size_t cap) {
-    return cap == 0 ? kMinBuckets : cap;
+  size_t NormalizeCapacity(size_t cap) const {
+    return std::max(cap, params_.min_buckets);
   }
 
-  size_t Index(const T& elem) const { return hasher_(elem) % buckets_.size(); }
+  size_t IndexOfHash(size_t h) const { return h % buckets_.size(); }
 
   double LoadFactor() const {
     return static_cast<double>(size_) / static_cast<double>(buckets_.size());
   }
 
+  // The *Hashed helpers assume the caller already holds mutex_.
+  bool AddHashed(T elem, size_t h) {
+    auto& b = buckets_[IndexOfHash(h)];
+    if (bucket::Find(b, elem) != b.end()) {
+      return false;
+    }
+    b.push_back(std::move(elem));
+    ++size_;
+    if (LoadFactor() > params_.max_load_factor) {
+      Resize(buckets_.size() * 2);
+    }
+    return true;
+  }
+
+  template <typename K>
+  bool RemoveHashed(const K& elem, size_t h) {
+    auto& b = buckets_[IndexOfHash(h)];
+    auto it = bucket::Find(b, elem);
+    if (it == b.end()) {
+      return false;
+    }
+    b.erase(it);
+    --size_;
+    if (LoadFactor() < params_.min_load_factor &&
+        buckets_.size() > params_.min_buckets) {
+      Resize(buckets_.size() / 2);
+    }
+    return true;
+  }
+
+  template <typename K>
+  bool ContainsHashed(const K& elem, size_t h) const {
+    const auto& b = buckets_[IndexOfHash(h)];
+    return bucket::Find(b, elem) != b.end();
+  }
+
+  // Doubles the table until |count| elements fit under max_load_factor.
+  // Caller holds mutex_.
+  void Reserve(size_t count) {
+    size_t cap = buckets_.size();
+    while (static_cast<double>(count) >
+           params_.max_load_factor * static_cast<double>(cap)) {
+      cap *= 2;
+    }
+    if (cap != buckets_.size()) {
+      Resize(cap);
+    }
+  }
+
   // Resize assumes the caller already holds mutex_ (no re-entrant locking).
   void Resize(size_t new_capacity) {
+    new_capacity = NormalizeCapacity(new_capacity);
     std::vector<std::vector<T>> new_buckets(new_capacity);
     for (auto& bucket : buckets_) {
       for (auto& v : bucket) {
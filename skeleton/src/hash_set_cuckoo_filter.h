@@ -0,0 +1,346 @@
+#ifndef HASH_SET_CUCKOO_FILTER_H
+#define HASH_SET_CUCKOO_FILTER_H
+
+#include <algorithm>  // std::max, std::min
+#include <atomic>     // std::atomic
+#include <cstddef>    // size_t
+#include <cstdint>    // uint8_t, uint16_t, uint64_t
+#include <memory>     // std::unique_ptr, std::make_unique
+#include <mutex>      // std::mutex, std::unique_lock
+#include <stdexcept>  // std::length_error
+#include <utility>    // std::swap
+#include <vector>     // std::vector
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+
+// An approximate set of uint64_t keys in about 12.6 bits per key: a cuckoo
+// filter storing a 12-bit fingerprint of each key instead of the key.
+//
+// Approximate semantics:
+// - Contains returns true for about 0.2% of keys that were never added
+//   (8 / 4095: two buckets of four fingerprints, each matching with
+//   probability 1/4095).
+// - Add is idempotent, as HashSetBase requires: a key whose fingerprint is
+//   already in one of its buckets is not stored again, and Add returns
+//   false. Re-adding hot keys therefore costs no space.
+// - Known trade-off: two keys are indistinguishable when they share a
+//   fingerprint and a bucket pair (twins). Add of the second returns false
+//   as if it were present, and Remove of either removes their shared entry,
+//   after which Contains of the other returns false. So Contains never
+//   misses a key that was added and not removed unless a twin of it was
+//   removed since. Remove a key only if it was added.
+// - Size() is the number of stored fingerprints, which is at most the
+//   number of distinct keys added.
+//
+// Capacity is fixed: each key has two candidate buckets of four slots,
+// i1 = hash & mask and i2 = i1 ^ Mix64(fingerprint) & mask, so i1 can be
+// recovered from i2 and the fingerprint alone. Add puts the fingerprint in
+// an empty slot of either bucket, or makes room by relocating fingerprints
+// to their alternate buckets. Past about 95% occupancy that stops
+// succeeding and Add throws std::length_error.
+//
+// Buckets are guarded by stripe locks (stripe = bucket & (stripes - 1)).
+// Every operation locks the stripes of both of its buckets in ascending
+// order, so it sees a fingerprint that moves between them in exactly one.
+// Room is made one kicker at a time: the kicker finds a path of
+// fingerprints ending at an empty slot, locking one bucket at a time, then
+// moves them back to front. Each move holds both buckets' locks, so no
+// lookup can miss the fingerprint in flight. A move whose slots changed
+// since the search sends the kicker back to search again.
+class HashSetCuckooFilter : public HashSetBase<uint64_t> {
+ public:
+  // Sized so |capacity| keys fill at most 95% of the slots. The number of
+  // buckets is a power of two.
+  explicit HashSetCuckooFilter(size_t capacity, size_t stripes = 64)
+      : bucket_mask_(BucketsFor(capacity) - 1),
+        stripe_mask_(std::min(RoundUpToPowerOfTwo(stripes), bucket_mask_ + 1) -
+                     1),
+        table_(std::make_unique<uint8_t[]>((bucket_mask_ + 1) * kBucketBytes)),
+        stripes_(std::make_unique<Stripe[]>(stripe_mask_ + 1)) {}
+
+  HashSetCuckooFilter(const HashSetCuckooFilter&) = delete;
+  HashSetCuckooFilter& operator=(const HashSetCuckooFilter&) = delete;
+
+  // Returns false if the fingerprint is already in one of its buckets.
+  // Throws std::length_error if no room can be made.
+  bool Add(uint64_t elem) final { return AddHashed(hasher_(elem)); }
+
+  // Removes one copy of the fingerprint. Returns false if neither bucket
+  // has it.
+  bool Remove(uint64_t elem) final {
+    size_t h = hasher_(elem);
+    uint16_t fp = Fingerprint(h);
+    size_t i1 = h & bucket_mask_;
+    size_t i2 = AltIndex(i1, fp);
+    PairLock lk(*this, i1, i2);
+    for (size_t b : {i1, i2}) {
+      int slot = FindSlot(b, fp);
+      if (slot >= 0) {
+        SetSlot(b, slot, 0);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // May return true for a key never added; see the class comment.
+  [[nodiscard]] bool Contains(uint64_t elem) final {
+    return ContainsHashed(hasher_(elem));
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  size_t AddBatch(const uint64_t* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t, size_t h) {
+      if (AddHashed(h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const uint64_t* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(h);
+    });
+  }
+
+  // The number of fingerprint slots.
+  [[nodiscard]] size_t SlotCount() const {
+    return (bucket_mask_ + 1) * kSlots;
+  }
+
+  // Bytes of fingerprint storage, for bits-per-key accounting.
+  [[nodiscard]] size_t MemoryUsage() const {
+    return (bucket_mask_ + 1) * kBucketBytes;
+  }
+
+ private:
+  static constexpr size_t kSlots = 4;
+  static constexpr size_t kFingerprintBits = 12;
+  static constexpr uint64_t kFingerprintMask = (1u << kFingerprintBits) - 1;
+  static constexpr size_t kBucketBytes = kSlots * kFingerprintBits / 8;
+  static constexpr double kMaxOccupancy = 0.95;
+  // Longest relocation path searched, and searches tried, before Add gives
+  // up.
+  static constexpr size_t kMaxPath = 500;
+  static constexpr size_t kMaxSearches = 8;
+
+  struct alignas(64) Stripe {
+    std::mutex lock;
+  };
+
+  // Holds the stripe locks of two buckets, taken in ascending order.
+  class PairLock {
+   public:
+    PairLock(HashSetCuckooFilter& filter, size_t b1, size_t b2)
+        : first_(&filter.StripeOf(b1)), second_(&filter.StripeOf(b2)) {
+      if (first_ > second_) {
+        std::swap(first_, second_);
+      }
+      first_->lock.lock();
+      if (second_ != first_) {
+        second_->lock.lock();
+      }
+    }
+
+    ~PairLock() {
+      if (second_ != first_) {
+        second_->lock.unlock();
+      }
+      first_->lock.unlock();
+    }
+
+    PairLock(const PairLock&) = delete;
+    PairLock& operator=(const PairLock&) = delete;
+
+   private:
+    Stripe* first_;
+    Stripe* second_;
+  };
+
+  // One step of a relocation path: the fingerprint in bucket[slot] moves to
+  // its alternate bucket.
+  struct Step {
+    size_t bucket;
+    int slot;
+    uint16_t fp;
+  };
+
+  const size_t bucket_mask_;
+  const size_t stripe_mask_;
+  // Buckets of four 12-bit fingerprints packed into six bytes; zero marks
+  // an empty slot.
+  std::unique_ptr<uint8_t[]> table_;
+  std::unique_ptr<Stripe[]> stripes_;
+  std::mutex kick_mutex_;  // One thread relocates at a time
+  uint64_t kick_state_ = 0x9e3779b97f4a7c15ull;  // Guarded by kick_mutex_
+  std::atomic<size_t> size_{0};
+  batch_hash::MixHasher<uint64_t> hasher_;
+
+  static size_t BucketsFor(size_t capacity) {
+    double buckets = static_cast<double>(capacity) / (kSlots * kMaxOccupancy);
+    return RoundUpToPowerOfTwo(static_cast<size_t>(buckets));
+  }
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  // The top bits of the hash, which do not pick the bucket; never zero.
+  static uint16_t Fingerprint(size_t h) {
+    auto fp = static_cast<uint16_t>(static_cast<uint64_t>(h) >>
+                                    (64 - kFingerprintBits));
+    return fp == 0 ? 1 : fp;
+  }
+
+  size_t AltIndex(size_t b, uint16_t fp) const {
+    return (b ^ static_cast<size_t>(batch_hash::Mix64(fp))) & bucket_mask_;
+  }
+
+  Stripe& StripeOf(size_t b) { return stripes_[b & stripe_mask_]; }
+
+  // Caller holds the bucket's stripe lock. Only the bucket's own six bytes
+  // are read and written: the neighbours' may be changing under other locks.
+  uint64_t LoadBucket(size_t b) const {
+    const uint8_t* p = &table_[b * kBucketBytes];
+    uint64_t word = 0;
+    for (size_t i = 0; i < kBucketBytes; ++i) {
+      word |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return word;
+  }
+
+  void StoreBucket(size_t b, uint64_t word) {
+    uint8_t* p = &table_[b * kBucketBytes];
+    for (size_t i = 0; i < kBucketBytes; ++i) {
+      p[i] = static_cast<uint8_t>(word >> (8 * i));
+    }
+  }
+
+  uint16_t GetSlot(size_t b, int slot) const {
+    return static_cast<uint16_t>(
+        (LoadBucket(b) >> (kFingerprintBits * static_cast<size_t>(slot))) &
+        kFingerprintMask);
+  }
+
+  void SetSlot(size_t b, int slot, uint16_t fp) {
+    size_t shift = kFingerprintBits * static_cast<size_t>(slot);
+    uint64_t word = LoadBucket(b) & ~(kFingerprintMask << shift);
+    StoreBucket(b, word | (static_cast<uint64_t>(fp) << shift));
+  }
+
+  // Returns the first slot of bucket |b| holding |fp|, or -1.
+  int FindSlot(size_t b, uint16_t fp) const {
+    uint64_t word = LoadBucket(b);
+    for (size_t s = 0; s < kSlots; ++s) {
+      if (((word >> (kFingerprintBits * s)) & kFingerprintMask) == fp) {
+        return static_cast<int>(s);
+      }
+    }
+    return -1;
+  }
+
+  bool ContainsHashed(size_t h) {
+    uint16_t fp = Fingerprint(h);
+    size_t i1 = h & bucket_mask_;
+    size_t i2 = AltIndex(i1, fp);
+    PairLock lk(*this, i1, i2);
+    return FindSlot(i1, fp) >= 0 || FindSlot(i2, fp) >= 0;
+  }
+
+  // Adds |fp| to bucket i1 or i2 if it is in neither. Returns 1 if added, 0
+  // if already present, -1 if both buckets are full.
+  int TryAdd(uint16_t fp, size_t i1, size_t i2) {
+    PairLock lk(*this, i1, i2);
+    if (FindSlot(i1, fp) >= 0 || FindSlot(i2, fp) >= 0) {
+      return 0;
+    }
+    for (size_t b : {i1, i2}) {
+      int slot = FindSlot(b, 0);
+      if (slot >= 0) {
+        SetSlot(b, slot, fp);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return 1;
+      }
+    }
+    return -1;
+  }
+
+  bool AddHashed(size_t h) {
+    uint16_t fp = Fingerprint(h);
+    size_t i1 = h & bucket_mask_;
+    size_t i2 = AltIndex(i1, fp);
+    int added = TryAdd(fp, i1, i2);
+    if (added >= 0) {
+      return added == 1;
+    }
+
+    std::unique_lock<std::mutex> kick_lock(kick_mutex_);
+    for (size_t search = 0; search < kMaxSearches; ++search) {
+      added = TryAdd(fp, i1, i2);  // Room may have appeared meanwhile
+      if (added >= 0) {
+        return added == 1;
+      }
+      std::vector<Step> path;
+      if (FindPath(search % 2 == 0 ? i1 : i2, path)) {
+        MovePath(path);
+      }
+    }
+    throw std::length_error("HashSetCuckooFilter: filter full");
+  }
+
+  uint64_t NextRandom() {
+    kick_state_ ^= kick_state_ << 13;
+    kick_state_ ^= kick_state_ >> 7;
+    kick_state_ ^= kick_state_ << 17;
+    return kick_state_;
+  }
+
+  // Random walk from bucket |b| through full buckets until one with an empty
+  // slot is reached. Each bucket is read under its own stripe lock only, so
+  // the path may be stale by the time it is moved. Caller holds
+  // kick_mutex_.
+  bool FindPath(size_t b, std::vector<Step>& path) {
+    path.clear();
+    for (size_t depth = 0; depth < kMaxPath; ++depth) {
+      std::unique_lock<std::mutex> lk(StripeOf(b).lock);
+      if (FindSlot(b, 0) >= 0) {
+        return !path.empty();
+      }
+      auto slot = static_cast<int>(NextRandom() % kSlots);
+      uint16_t fp = GetSlot(b, slot);
+      path.push_back(Step{b, slot, fp});
+      b = AltIndex(b, fp);
+    }
+    return false;
+  }
+
+  // Moves the path's fingerprints to their alternate buckets, last first,
+  // so each lands in the slot the step after it emptied. Stops at the first
+  // step whose slots changed since FindPath. Caller holds kick_mutex_.
+  void MovePath(const std::vector<Step>& path) {
+    for (size_t i = path.size(); i-- > 0;) {
+      const Step& step = path[i];
+      size_t to = AltIndex(step.bucket, step.fp);
+      PairLock lk(*this, step.bucket, to);
+      int free_slot = FindSlot(to, 0);
+      if (free_slot < 0 || GetSlot(step.bucket, step.slot) != step.fp) {
+        return;
+      }
+      SetSlot(to, free_slot, step.fp);
+      SetSlot(step.bucket, step.slot, 0);
+    }
+  }
+};
+
+#endif  // HASH_SET_CUCKOO_FILTER_H
@@ -0,0 +1,241 @@
+#ifndef HASH_SET_EXTENDIBLE_H
+#define HASH_SET_EXTENDIBLE_H
+
+#include <algorithm>  // std::max
+#include <array>      // std::array
+#include <atomic>     // std::atomic
+#include <cassert>
+#include <cstddef>       // size_t
+#include <functional>    // std::hash
+#include <memory>        // std::unique_ptr
+#include <mutex>         // std::mutex, std::scoped_lock, std::unique_lock
+#include <shared_mutex>  // std::shared_mutex, std::shared_lock
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+#include "src/batch_hash.h"
+#include "src/bucket.h"
+#include "src/hash_set_base.h"
+
+// Extendible hashing: a directory of 2^global_depth pointers to fixed-size,
+// cache-line-aligned buckets, indexed by the low global_depth bits of the
+// hash. A bucket with local depth d is shared by the 2^(global_depth - d)
+// directory entries that agree on its low d bits. A full bucket splits in
+// two on bit d; the directory only doubles (by copying pointers) when a
+// bucket with d == global_depth splits. Nothing is ever rehashed globally.
+//
+// Operations hold the directory lock shared plus their bucket's lock. A
+// split takes the directory lock exclusively, which moves at most kSlots keys
+// and, when doubling, copies the directory's pointers.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetExtendible : public HashSetBase<T> {
+ public:
+  explicit HashSetExtendible(size_t initial_capacity) : size_(0) {
+    // Enough buckets to hold initial_capacity keys half full.
+    size_t depth = 0;
+    while ((size_t{1} << depth) * kSlots < initial_capacity * 2 &&
+           depth < kMaxGlobalDepth) {
+      ++depth;
+    }
+    global_depth_ = depth;
+    directory_.resize(size_t{1} << depth);
+    for (auto& entry : directory_) {
+      buckets_.push_back(std::make_unique<Bucket>(depth));
+      entry = buckets_.back().get();
+    }
+  }
+
+  // Insert under the bucket lock; split and retry if the bucket is full.
+  bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
+
+  // Remove under the bucket lock. Buckets are never merged.
+  bool Remove(T elem) final {
+    size_t h = hasher_(elem);
+    std::shared_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    Bucket& b = *directory_[h & Mask()];
+    std::scoped_lock lock(b.lock);
+    size_t i = bucket::FindIndex(b.slots.data(), b.count, elem);
+    if (i < b.count) {
+      b.slots[i] = std::move(b.slots[b.count - 1]);
+      --b.count;
+    } else {
+      auto it = bucket::Find(b.overflow, elem);
+      if (it == b.overflow.end()) {
+        return false;
+      }
+      b.overflow.erase(it);
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Lookup under the bucket lock.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // No synchronization needed; size_ is atomic.
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Keys are hashed in bulk; each one then takes only its own bucket lock.
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Calls fn(elem) for every element with the directory locked exclusively,
+  // so it sees a consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::unique_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    for (const auto& b : buckets_) {
+      for (size_t i = 0; i < b->count; ++i) {
+        fn(b->slots[i]);
+      }
+      for (const auto& v : b->overflow) {
+        fn(v);
+      }
+    }
+  }
+
+  // Number of hash bits the directory currently indexes by.
+  [[nodiscard]] size_t GlobalDepth() const {
+    std::shared_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    return global_depth_;
+  }
+
+  // Number of distinct buckets.
+  [[nodiscard]] size_t BucketCount() const {
+    std::shared_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    return buckets_.size();
+  }
+
+ private:
+  // Keys per bucket: one cache line's worth, but at least four.
+  static constexpr size_t kSlots = std::max<size_t>(4, 64 / sizeof(T));
+  // The directory stops doubling here (16M entries). Keys whose hashes
+  // agree on all of these bits go to the bucket's overflow list instead.
+  static constexpr size_t kMaxGlobalDepth = 24;
+
+  struct alignas(64) Bucket {
+    explicit Bucket(size_t depth) : local_depth(depth) {}
+
+    std::mutex lock;
+    size_t local_depth;  // Written under the exclusive directory lock
+    size_t count = 0;    // Used slots, guarded by lock
+    std::array<T, kSlots> slots{};
+    std::vector<T> overflow;  // Only used at kMaxGlobalDepth
+  };
+
+  mutable std::shared_mutex directory_mutex_;
+  std::vector<Bucket*> directory_;  // Guarded by directory_mutex_
+  size_t global_depth_;             // Guarded by directory_mutex_
+  std::vector<std::unique_ptr<Bucket>> buckets_;  // Owns every bucket
+  std::atomic<size_t> size_;
+  Hash hasher_;
+
+  size_t Mask() const { return (size_t{1} << global_depth_) - 1; }
+
+  // Whether a full bucket can still split. Caller holds directory_mutex_.
+  bool CanSplit(const Bucket& b) const {
+    return b.local_depth < global_depth_ || global_depth_ < kMaxGlobalDepth;
+  }
+
+  static bool BucketContains(const Bucket& b, const T& elem) {
+    return bucket::FindIndex(b.slots.data(), b.count, elem) < b.count ||
+           bucket::Find(b.overflow, elem) != b.overflow.end();
+  }
+
+  bool AddHashed(T elem, size_t h) {
+    while (true) {
+      {
+        std::shared_lock<std::shared_mutex> directory_lock(directory_mutex_);
+        Bucket& b = *directory_[h & Mask()];
+        std::scoped_lock lock(b.lock);
+        if (BucketContains(b, elem)) {
+          return false;
+        }
+        if (b.count < kSlots) {
+          b.slots[b.count++] = std::move(elem);
+          size_.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+        if (!CanSplit(b)) {
+          b.overflow.push_back(std::move(elem));
+          size_.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+      Split(h);
+    }
+  }
+
+  bool ContainsHashed(const T& elem, size_t h) const {
+    std::shared_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    Bucket& b = *directory_[h & Mask()];
+    std::scoped_lock lock(b.lock);
+    return BucketContains(b, elem);
+  }
+
+  // Splits the bucket that |h| maps to, doubling the directory first if the
+  // bucket is already at the global depth. Every other operation holds the
+  // directory lock shared while it touches a bucket, so with it held
+  // exclusively no bucket lock is needed.
+  void Split(size_t h) {
+    std::unique_lock<std::shared_mutex> directory_lock(directory_mutex_);
+    Bucket* old_bucket = directory_[h & Mask()];
+    if (old_bucket->count < kSlots || !CanSplit(*old_bucket)) {
+      return;  // Another thread split it first.
+    }
+
+    if (old_bucket->local_depth == global_depth_) {
+      size_t n = directory_.size();
+      directory_.reserve(n * 2);
+      for (size_t i = 0; i < n; ++i) {
+        directory_.push_back(directory_[i]);
+      }
+      ++global_depth_;
+    }
+
+    size_t bit = size_t{1} << old_bucket->local_depth;
+    auto new_bucket = std::make_unique<Bucket>(old_bucket->local_depth + 1);
+    ++old_bucket->local_depth;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < old_bucket->count; ++i) {
+      if ((hasher_(old_bucket->slots[i]) & bit) != 0) {
+        new_bucket->slots[new_bucket->count++] =
+            std::move(old_bucket->slots[i]);
+      } else {
+        old_bucket->slots[kept++] = std::move(old_bucket->slots[i]);
+      }
+    }
+    old_bucket->count = kept;
+
+    // Directory entries that agree with h on the old bucket's bits and have
+    // |bit| set now point at the new bucket.
+    size_t first = (h & (bit - 1)) | bit;
+    for (size_t j = first; j < directory_.size(); j += bit * 2) {
+      directory_[j] = new_bucket.get();
+    }
+    buckets_.push_back(std::move(new_bucket));
+  }
+};
+
+#endif  // HASH_SET_EXTENDIBLE_H
@@ -0,0 +1,537 @@
+#ifndef HASH_SET_MAPPED_H
+#define HASH_SET_MAPPED_H
+
+#include <fcntl.h>     // open, posix_fadvise
+#include <sys/mman.h>  // mmap, munmap, madvise, mincore, msync
+#include <unistd.h>    // close, ftruncate, unlink, sysconf
+
+#include <atomic>        // std::atomic
+#include <cerrno>        // errno
+#include <cstddef>       // size_t
+#include <cstdint>       // uint8_t, uint64_t
+#include <functional>    // std::hash
+#include <mutex>         // std::mutex, std::scoped_lock, std::unique_lock
+#include <shared_mutex>  // std::shared_mutex, std::shared_lock
+#include <stdexcept>     // std::length_error
+#include <string>        // std::string, std::to_string
+#include <system_error>  // std::system_error, std::generic_category
+#include <vector>        // std::vector
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+
+// Open-addressing set of uint64_t keys whose table lives in a memory-mapped
+// file, so it can grow past RAM and let the kernel page it.
+//
+// The table is an array of page-sized groups of kSlotsPerGroup slots. A key's
+// home group comes from the high half of its remixed hash and it never leaves
+// that group: probing starts at a slot picked by the low half and wraps
+// within the page. A lookup therefore touches exactly one page, which is at
+// most one page fault when the table is not resident. Tables are kept at most
+// half full, so a group overflowing is vanishingly unlikely; if one does
+// fill, the table grows.
+//
+// Stripe locks live in memory; stripe = home group mod the stripe count,
+// and since group counts are powers of two no smaller than the stripe count,
+// a key keeps its stripe across resizes. Growing maps a new file with twice
+// the groups and migrates incrementally: an update first moves its key's old
+// group, and every operation moves one more, so no caller pays for the whole
+// rehash. Migrated pages of the old file are released as they go.
+//
+// Empty slots hold 0 and removed slots hold ~0; those two keys are tracked
+// outside the table. Table files are |path|.0, |path|.1, ...; they are
+// scratch space, truncated on creation and deleted with the set. Failing to
+// create or map one throws std::system_error.
+template <typename Hash = std::hash<uint64_t>>
+class HashSetMapped : public HashSetBase<uint64_t> {
+ public:
+  HashSetMapped(const std::string& path, size_t initial_capacity,
+                size_t stripes = 256)
+      : path_(path),
+        stripes_(RoundUpToPowerOfTwo(stripes)),
+        stripe_mask_(stripes_.size() - 1),
+        size_(0),
+        tombstones_(0),
+        capacity_(0),
+        migrating_(false),
+        next_group_(0),
+        migrated_count_(0) {
+    size_t groups = stripes_.size();
+    while (static_cast<double>(groups * kSlotsPerGroup) * kMaxLoad <
+           static_cast<double>(initial_capacity)) {
+      groups *= 2;
+    }
+    current_ = Map(groups);
+    capacity_.store(groups * kSlotsPerGroup, std::memory_order_relaxed);
+  }
+
+  ~HashSetMapped() override {
+    Unmap(old_);
+    Unmap(current_);
+  }
+
+  HashSetMapped(const HashSetMapped&) = delete;
+  HashSetMapped& operator=(const HashSetMapped&) = delete;
+
+  bool Add(uint64_t elem) final {
+    if (IsReserved(elem)) {
+      return AddReserved(elem);
+    }
+    uint64_t mixed = Mix(elem);
+    while (true) {
+      Probe result;
+      {
+        std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+        std::scoped_lock lock(StripeOf(mixed).lock);
+        result = Insert(WritableTable(mixed), elem, mixed);
+      }
+      if (result == Probe::kFull) {
+        Grow(/*forced=*/true);
+        continue;
+      }
+      if (result == Probe::kAbsent) {
+        size_.fetch_add(1, std::memory_order_relaxed);
+      }
+      AfterOperation();
+      return result == Probe::kAbsent;
+    }
+  }
+
+  bool Remove(uint64_t elem) final {
+    if (IsReserved(elem)) {
+      return RemoveReserved(elem);
+    }
+    uint64_t mixed = Mix(elem);
+    bool removed = false;
+    {
+      std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+      std::scoped_lock lock(StripeOf(mixed).lock);
+      Table& table = WritableTable(mixed);
+      uint64_t* slot = Find(table, elem, mixed);
+      if (slot != nullptr) {
+        *slot = kTombstone;
+        removed = true;
+      }
+    }
+    if (removed) {
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      tombstones_.fetch_add(1, std::memory_order_relaxed);
+    }
+    AfterOperation();
+    return removed;
+  }
+
+  // Looks in the old table while the key's group has not been migrated.
+  [[nodiscard]] bool Contains(uint64_t elem) final {
+    if (IsReserved(elem)) {
+      return ContainsReserved(elem);
+    }
+    uint64_t mixed = Mix(elem);
+    bool present;
+    {
+      std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+      std::scoped_lock lock(StripeOf(mixed).lock);
+      present = Find(ReadableTable(mixed), elem, mixed) != nullptr;
+    }
+    AfterOperation();
+    return present;
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Calls fn(elem) for every element with all operations excluded, so it
+  // sees a consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
+    for (uint64_t key : {kEmpty, kTombstone}) {
+      if (ContainsReserved(key)) {
+        fn(key);
+      }
+    }
+    auto visit = [&fn](const Table& table, size_t group) {
+      const uint64_t* slots = GroupSlots(table, group);
+      for (size_t i = 0; i < kSlotsPerGroup; ++i) {
+        if (!IsReserved(slots[i])) {
+          fn(slots[i]);
+        }
+      }
+    };
+    if (migrating_.load(std::memory_order_relaxed)) {
+      for (size_t g = 0; g < old_.groups; ++g) {
+        if (migrated_[g] == 0) {
+          visit(old_, g);
+        }
+      }
+    }
+    for (size_t g = 0; g < current_.groups; ++g) {
+      visit(current_, g);
+    }
+  }
+
+  // Bytes of table file currently mapped (both tables while migrating).
+  [[nodiscard]] size_t FileBytes() {
+    std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+    return (current_.groups + old_.groups) * kGroupBytes;
+  }
+
+  // Bytes of the mapped tables that are resident in memory.
+  [[nodiscard]] size_t ResidentBytes() {
+    std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+    return Resident(current_) + Resident(old_);
+  }
+
+  // Writes back every table page and drops it from memory, as if memory
+  // pressure had evicted them; later accesses fault them back in from the
+  // file. Used to measure the set when it does not fit in memory.
+  void Evict() {
+    std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
+    for (Table* table : {&current_, &old_}) {
+      if (table->slots != nullptr) {
+        size_t bytes = table->groups * kGroupBytes;
+        ::msync(table->slots, bytes, MS_SYNC);
+        ::madvise(table->slots, bytes, MADV_DONTNEED);  // Drop our mappings
+        ::posix_fadvise(table->fd, 0, static_cast<off_t>(bytes),
+                        POSIX_FADV_DONTNEED);  // and the page cache copies.
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kGroupBytes = 4096;
+  static constexpr size_t kSlotsPerGroup = kGroupBytes / sizeof(uint64_t);
+  static constexpr double kMaxLoad = 0.5;  // Live keys plus tombstones
+  static constexpr uint64_t kEmpty = 0;
+  static constexpr uint64_t kTombstone = ~uint64_t{0};
+
+  enum class Probe { kPresent, kAbsent, kFull };
+
+  struct Table {
+    std::string path;
+    int fd = -1;  // Kept open for Evict
+    uint64_t* slots = nullptr;
+    size_t groups = 0;  // Power of two; 0 when unmapped
+  };
+
+  struct alignas(64) Stripe {
+    std::mutex lock;
+  };
+
+  const std::string path_;
+  std::vector<Stripe> stripes_;
+  const size_t stripe_mask_;
+  Hash hasher_;
+  size_t next_file_ = 0;  // Suffix of the next table file, under table_mutex_
+
+  // Held shared by every operation and exclusively to replace a table.
+  std::shared_mutex table_mutex_;
+  Table current_;
+  Table old_;  // Being migrated from; unmapped otherwise
+  std::vector<uint8_t> migrated_;  // Per old group; under its stripe lock
+
+  std::atomic<size_t> size_;
+  std::atomic<size_t> tombstones_;  // In whichever table holds them
+  std::atomic<size_t> capacity_;    // Slots in current_
+  std::atomic<bool> migrating_;
+  std::atomic<size_t> next_group_;  // Next old group for a migration step
+  std::atomic<size_t> migrated_count_;
+  std::atomic<bool> has_empty_key_{false};
+  std::atomic<bool> has_tombstone_key_{false};
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p *= 2;
+    }
+    return p;
+  }
+
+  static bool IsReserved(uint64_t elem) {
+    return elem == kEmpty || elem == kTombstone;
+  }
+
+  std::atomic<bool>& ReservedFlag(uint64_t elem) {
+    return elem == kEmpty ? has_empty_key_ : has_tombstone_key_;
+  }
+
+  bool AddReserved(uint64_t elem) {
+    if (ReservedFlag(elem).exchange(true, std::memory_order_relaxed)) {
+      return false;
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool RemoveReserved(uint64_t elem) {
+    if (!ReservedFlag(elem).exchange(false, std::memory_order_relaxed)) {
+      return false;
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool ContainsReserved(uint64_t elem) {
+    return ReservedFlag(elem).load(std::memory_order_relaxed);
+  }
+
+  uint64_t Mix(uint64_t elem) const {
+    return batch_hash::Mix64(static_cast<uint64_t>(hasher_(elem)));
+  }
+
+  // The high half of the remixed hash picks the group, the low half the
+  // first slot probed within it.
+  static size_t GroupOf(const Table& table, uint64_t mixed) {
+    return static_cast<size_t>(mixed >> 32) & (table.groups - 1);
+  }
+
+  Stripe& StripeOf(uint64_t mixed) {
+    return stripes_[static_cast<size_t>(mixed >> 32) & stripe_mask_];
+  }
+
+  static uint64_t* GroupSlots(const Table& table, size_t group) {
+    return table.slots + group * kSlotsPerGroup;
+  }
+
+  // The slot holding |elem|, or nullptr. Caller holds the key's stripe lock.
+  static uint64_t* Find(const Table& table, uint64_t elem, uint64_t mixed) {
+    uint64_t* slots = GroupSlots(table, GroupOf(table, mixed));
+    size_t i = static_cast<size_t>(mixed) % kSlotsPerGroup;
+    for (size_t n = 0; n < kSlotsPerGroup; ++n) {
+      if (slots[i] == elem) {
+        return &slots[i];
+      }
+      if (slots[i] == kEmpty) {
+        return nullptr;
+      }
+      i = (i + 1) % kSlotsPerGroup;
+    }
+    return nullptr;
+  }
+
+  // Inserts |elem| into its group, reusing the first tombstone on the probe
+  // path. Caller holds the key's stripe lock.
+  Probe Insert(const Table& table, uint64_t elem, uint64_t mixed) {
+    uint64_t* slots = GroupSlots(table, GroupOf(table, mixed));
+    uint64_t* reusable = nullptr;
+    size_t i = static_cast<size_t>(mixed) % kSlotsPerGroup;
+    for (size_t n = 0; n < kSlotsPerGroup; ++n) {
+      if (slots[i] == elem) {
+        return Probe::kPresent;
+      }
+      if (slots[i] == kEmpty) {
+        if (reusable == nullptr) {
+          reusable = &slots[i];
+        }
+        break;
+      }
+      if (slots[i] == kTombstone && reusable == nullptr) {
+        reusable = &slots[i];
+      }
+      i = (i + 1) % kSlotsPerGroup;
+    }
+    if (reusable == nullptr) {
+      return Probe::kFull;
+    }
+    if (*reusable == kTombstone) {
+      tombstones_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    *reusable = elem;
+    return Probe::kAbsent;
+  }
+
+  // The table a lookup of |mixed| must read. Caller holds table_mutex_
+  // (shared) and the key's stripe lock.
+  Table& ReadableTable(uint64_t mixed) {
+    if (migrating_.load(std::memory_order_relaxed) &&
+        migrated_[GroupOf(old_, mixed)] == 0) {
+      return old_;
+    }
+    return current_;
+  }
+
+  // The table an update of |mixed| must write: the current one, after moving
+  // the key's old group over if that has not happened yet.
+  Table& WritableTable(uint64_t mixed) {
+    if (migrating_.load(std::memory_order_relaxed)) {
+      size_t group = GroupOf(old_, mixed);
+      if (migrated_[group] == 0) {
+        MigrateGroup(group);
+      }
+    }
+    return current_;
+  }
+
+  // Moves one old group into the current table and releases its page.
+  // Caller holds the group's stripe lock, or table_mutex_ exclusively.
+  void MigrateGroup(size_t group) {
+    uint64_t* slots = GroupSlots(old_, group);
+    size_t dropped = 0;
+    for (size_t i = 0; i < kSlotsPerGroup; ++i) {
+      uint64_t key = slots[i];
+      if (key == kTombstone) {
+        ++dropped;
+      } else if (key != kEmpty) {
+        if (Insert(current_, key, Mix(key)) == Probe::kFull) {
+          // The new table is at most a quarter full on average.
+          throw std::length_error("HashSetMapped: group overflow on resize");
+        }
+      }
+    }
+    tombstones_.fetch_sub(dropped, std::memory_order_relaxed);
+    migrated_[group] = 1;
+    // Punch the page out of the old file; harmless where unsupported.
+    ::madvise(slots, kGroupBytes, MADV_REMOVE);
+    migrated_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Called after every operation, with no lock held: one step of a running
+  // migration, or the start of a new one.
+  void AfterOperation() {
+    if (migrating_.load(std::memory_order_acquire)) {
+      MigrateStep();
+    } else if (Overloaded()) {
+      Grow(/*forced=*/false);
+    }
+  }
+
+  bool Overloaded() const {
+    return static_cast<double>(size_.load(std::memory_order_relaxed) +
+                               tombstones_.load(std::memory_order_relaxed)) >
+           static_cast<double>(capacity_.load(std::memory_order_relaxed)) *
+               kMaxLoad;
+  }
+
+  void MigrateStep() {
+    bool done;
+    {
+      std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+      if (!migrating_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      size_t group = next_group_.fetch_add(1, std::memory_order_relaxed);
+      if (group < old_.groups) {
+        std::scoped_lock lock(stripes_[group & stripe_mask_].lock);
+        if (migrated_[group] == 0) {
+          MigrateGroup(group);
+        }
+      }
+      done = migrated_count_.load(std::memory_order_relaxed) == old_.groups;
+    }
+    if (done) {
+      std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
+      FinishMigration();
+    }
+  }
+
+  // Caller holds table_mutex_ exclusively.
+  void FinishMigration() {
+    if (!migrating_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    for (size_t g = 0; g < old_.groups; ++g) {
+      if (migrated_[g] == 0) {
+        MigrateGroup(g);
+      }
+    }
+    Unmap(old_);
+    migrated_.clear();
+    migrating_.store(false, std::memory_order_release);
+  }
+
+  // Starts migrating into a new table: twice the groups if the live keys
+  // alone overload half the current one (or a group is full), otherwise the
+  // same size, which just drops tombstones. A running migration is finished
+  // first.
+  void Grow(bool forced) {
+    std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
+    FinishMigration();
+    if (!forced && !Overloaded()) {
+      return;  // Another thread got here first.
+    }
+    size_t groups = current_.groups;
+    if (forced || static_cast<double>(size_.load(std::memory_order_relaxed)) >
+                      static_cast<double>(groups * kSlotsPerGroup) * kMaxLoad /
+                          2) {
+      groups *= 2;
+    }
+    Table next = Map(groups);
+    old_ = current_;
+    current_ = next;
+    capacity_.store(groups * kSlotsPerGroup, std::memory_order_relaxed);
+    migrated_.assign(old_.groups, 0);
+    next_group_.store(0, std::memory_order_relaxed);
+    migrated_count_.store(0, std::memory_order_relaxed);
+    // The old table is now read front to back by the migration steps.
+    ::madvise(old_.slots, old_.groups * kGroupBytes, MADV_SEQUENTIAL);
+    migrating_.store(true, std::memory_order_release);
+  }
+
+  // Creates, sizes and maps a zero-filled (all-empty) table file. Caller
+  // holds table_mutex_ exclusively, or is the constructor.
+  Table Map(size_t groups) {
+    Table table;
+    table.path = path_ + "." + std::to_string(next_file_++);
+    table.groups = groups;
+    int fd = ::open(table.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0600);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "HashSetMapped: open " + table.path);
+    }
+    size_t bytes = groups * kGroupBytes;
+    // A sparse file: untouched groups cost neither disk nor memory.
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      int error = errno;
+      ::close(fd);
+      ::unlink(table.path.c_str());
+      throw std::system_error(error, std::generic_category(),
+                              "HashSetMapped: ftruncate " + table.path);
+    }
+    void* data =
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      int error = errno;
+      ::close(fd);
+      ::unlink(table.path.c_str());
+      throw std::system_error(error, std::generic_category(),
+                              "HashSetMapped: mmap " + table.path);
+    }
+    // Lookups hit one random page each; readahead would only evict others.
+    ::madvise(data, bytes, MADV_RANDOM);
+    table.fd = fd;
+    table.slots = static_cast<uint64_t*>(data);
+    return table;
+  }
+
+  static void Unmap(Table& table) {
+    if (table.slots != nullptr) {
+      ::munmap(table.slots, table.groups * kGroupBytes);
+      ::close(table.fd);
+      ::unlink(table.path.c_str());
+    }
+    table = Table{};
+  }
+
+  static size_t Resident(const Table& table) {
+    if (table.slots == nullptr) {
+      return 0;
+    }
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t bytes = table.groups * kGroupBytes;
+    std::vector<unsigned char> pages((bytes + page - 1) / page);
+    if (::mincore(table.slots, bytes, pages.data()) != 0) {
+      return 0;
+    }
+    size_t resident = 0;
+    for (unsigned char p : pages) {
+      if ((p & 1) != 0) {
+        resident += page;
+      }
+    }
+    return resident;
+  }
+};
+
+#endif  // HASH_SET_MAPPED_H
@@ -0,0 +1,31 @@
+#ifndef HASH_SET_PARAMS_H
+#define HASH_SET_PARAMS_H
+
+#include <algorithm>  // std::max, std::min
+#include <cstddef>    // size_t
+
+// Table-shape parameters shared by the hash sets. The defaults are the values
+// the sets have always used; tune_hash_set searches over them.
+struct HashSetParams {
+  // The table doubles once size / buckets exceeds this.
+  double max_load_factor = 4.0;
+  // The sets that shrink on Remove halve the table once size / buckets drops
+  // below this. Zero disables shrinking.
+  double min_load_factor = 1.0;
+  // The table never has fewer buckets than this.
+  size_t min_buckets = 4;
+
+  // Returns a copy with every field in range. The shrink threshold is kept at
+  // most a quarter of the grow threshold, so a table that has just doubled
+  // (halving its load factor) cannot immediately shrink back.
+  HashSetParams Normalized() const {
+    HashSetParams p = *this;
+    p.max_load_factor = std::max(p.max_load_factor, 0.25);
+    p.min_load_factor =
+        std::min(std::max(p.min_load_factor, 0.0), p.max_load_factor / 4);
+    p.min_buckets = std::max<size_t>(p.min_buckets, 1);
+    return p;
+  }
+};
+
+#endif  // HASH_SET_PARAMS_H
@@ -1,7 +1,7 @@
 #ifndef HASH_SET_REFINABLE_H
 #define HASH_SET_REFINABLE_H
 
-#include <algorithm>  // std::find
+#include <algorithm>  // std::max
 #include <atomic>     // std::atomic
 #include <cassert>
 #include <cstddef>     // size_t
@@ -11,16 +11,20 @@
 #include <utility>     // std::move
 #include <vector>      // std::vector
 
+#include "src/batch_hash.h"
+#include "src/bucket.h"
 #include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
 
 // Refinable hash set: one lock per bucket.
 // Lock array is resized along with the bucket array.
-template <typename T>
+template <typename T, typename Hash = std::hash<T>>
 class HashSetRefinable : public HashSetBase<T> {
  public:
-  explicit HashSetRefinable(size_t initial_capacity)
-      : buckets_(
-            std::max<size_t>(NormalizeCapacity(initial_capacity), kMinBuckets)),
+  explicit HashSetRefinable(size_t initial_capacity,
+                            const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        buckets_(NormalizeCapacity(initial_capacity)),
         size_(0),
         locks_(buckets_.size()),
         version_(0),
@@ -29,13 +33,183 @@ class HashSetRefinable : public HashSetBase<T> {
 
   // Insert by locking the bucket; retry if a resize intervenes.
   bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
+
+  // Constructs the element from |args| and adds it as Add does.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Add(T(std::forward<Args>(args)...));
+  }
+
+  // Remove by locking the bucket; retry if a resize intervenes.
+  bool Remove(T elem) final { return RemoveHashed(elem, hasher_(elem)); }
+
+  // Heterogeneous Remove: finds |key| without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  bool Remove(const K& key) {
+    return RemoveHashed(key, hasher_(key));
+  }
+
+  // Check elem by locking the bucket; retry if a resize intervenes.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // Heterogeneous Contains: looks |key| up without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  [[nodiscard]] bool Contains(const K& key) {
+    return ContainsHashed(key, hasher_(key));
+  }
+
+  // No synchronization needed; size_ is atomic.
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Keys are hashed in bulk; each one then takes only its own bucket lock.
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Adds every element of elems[0, n) if none of them is present, and
+  // otherwise changes nothing. Other threads see all of them appear at
+  // once. Returns whether they were added.
+  bool AddAll(const T* elems, size_t n) {
+    std::vector<size_t> hashes = HashAll(elems, n);
+    size_t used_cap = 0;
+    bool added = Transaction(hashes, used_cap, [&] {
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) != b.end()) {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) == b.end()) {  // Repeated in elems
+          b.push_back(elems[i]);
+          size_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      return true;
+    });
+    double lf = static_cast<double>(size_.load(std::memory_order_relaxed)) /
+                static_cast<double>(used_cap);
+    if (added && !resizing_.load(std::memory_order_acquire) &&
+        lf > params_.max_load_factor) {
+      Resize(used_cap * 2);
+    }
+    return added;
+  }
+
+  // Removes every element of elems[0, n) if all of them are present, and
+  // otherwise changes nothing. Returns whether they were removed.
+  bool RemoveAll(const T* elems, size_t n) {
+    std::vector<size_t> hashes = HashAll(elems, n);
+    size_t used_cap = 0;
+    return Transaction(hashes, used_cap, [&] {
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) == b.end()) {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        auto it = bucket::Find(b, elems[i]);
+        if (it != b.end()) {  // Repeated in elems
+          b.erase(it);
+          size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+      return true;
+    });
+  }
+
+  // Replaces |from| with |to| if |from| is present and |to| is not, as one
+  // step. Returns whether it did.
+  bool Swap(const T& from, const T& to) {
+    std::vector<size_t> hashes = {hasher_(from), hasher_(to)};
+    size_t used_cap = 0;
+    return Transaction(hashes, used_cap, [&] {
+      auto& from_bucket = buckets_[IndexOfHash(hashes[0])];
+      auto& to_bucket = buckets_[IndexOfHash(hashes[1])];
+      auto it = bucket::Find(from_bucket, from);
+      if (it == from_bucket.end() ||
+          bucket::Find(to_bucket, to) != to_bucket.end()) {
+        return false;
+      }
+      from_bucket.erase(it);
+      to_bucket.push_back(to);
+      return true;
+    });
+  }
+
+  // Calls fn(elem) for every element while holding every bucket lock, so it
+  // sees a consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    // Holding resize_mutex_ keeps locks_ from being replaced under us.
+    std::unique_lock<std::mutex> resizer_lock(resize_mutex_);
+    for (auto& lock : locks_) {
+      lock.lock();
+    }
+    for (const auto& b : buckets_) {
+      for (const auto& v : b) {
+        fn(v);
+      }
+    }
+    for (auto& lock : locks_) {
+      lock.unlock();
+    }
+  }
+
+ private:
+  const HashSetParams params_;  // Never shrinks, so min_load_factor is unused
+  std::vector<std::vector<T>> buckets_;
+  std::atomic<size_t> size_;
+  Hash hasher_;
+  std::vector<std::mutex>
+      locks_;  // One lock per bucket; size always equals buckets_.size().
+
+  std::mutex resize_mutex_;      // Separate mutex exclusively for resizing.
+  std::atomic<size_t> version_;  // version stamp for resize detection
+  std::atomic<bool> resizing_;   // resizing flag
+  std::atomic<size_t> owner_tid_hash_;  // resizing operation owner
+
+  // Keep old lock arrays alive to avoid premature mutex destruction.
+  std::vector<std::vector<std::mutex>> old_lock_arrays_;
+
+  size_t NormalizeCapacity(size_t cap) const {
+    return std::max(cap, params_.min_buckets);
+  }
+
+  size_t IndexOfHash(size_t h) const { return h % buckets_.size(); }
+
+  bool AddHashed(T elem, size_t h) {
     size_t used_cap = 0;
     while (true) {
       // Avoid starting an operation while another thread is resizing.
       WaitIfResizingByOther();
       size_t ver_before = version_.load(std::memory_order_acquire);
       size_t cap = buckets_.size();
-      size_t i = Index(elem);
+      size_t i = IndexOfHash(h);
 
       std::unique_lock<std::mutex> bucket_lk(locks_[i]);
 
@@ -46,7 +220,7 @@ class HashSetRefinable : public HashSetBase<T> {
 
       // Hash set add logic.
       auto& b = buckets_[i];
-      if (std::find(b.begin(), b.end(), elem) != b.end()) {
+      if (bucket::Find(b, elem) != b.end()) {
         return false;
       }
       b.push_back(std::move(elem));
@@ -59,20 +233,71 @@ class HashSetRefinable : public HashSetBase<T> {
     // resizes.
     double lf = static_cast<double>(size_.load(std::memory_order_relaxed)) /
                 static_cast<double>(used_cap);
-    if (!resizing_.load(std::memory_order_acquire) && lf > kMaxLoadFactor) {
+    if (!resizing_.load(std::memory_order_acquire) &&
+        lf > params_.max_load_factor) {
       Resize(used_cap * 2);
     }
 
     return true;
   }
 
-  // Remove by locking the bucket; retry if a resize intervenes.
-  bool Remove(T elem) final {
+  std::vector<size_t> HashAll(const T* elems, size_t n) const {
+    std::vector<size_t> hashes(n);
+    batch_hash::ForEachHashed(hasher_, elems, n,
+                              [&](size_t i, size_t h) { hashes[i] = h; });
+    return hashes;
+  }
+
+  // Runs fn() holding the locks of every bucket the hashes map to, taken in
+  // ascending bucket order like Resize takes them all, so transactions
+  // cannot deadlock with a resize or with each other. Reports the capacity
+  // fn ran under in |used_cap|. Returns fn's result.
+  template <typename Fn>
+  bool Transaction(const std::vector<size_t>& hashes, size_t& used_cap,
+                   Fn&& fn) {
+    std::vector<size_t> order;
+    std::vector<std::mutex*> held;
+    order.reserve(hashes.size());
+    held.reserve(hashes.size());
+    while (true) {
+      // Avoid starting an operation while another thread is resizing.
+      WaitIfResizingByOther();
+      size_t ver_before = version_.load(std::memory_order_acquire);
+      size_t cap = buckets_.size();
+      order.clear();
+      for (size_t h : hashes) {
+        order.push_back(h % cap);
+      }
+      std::sort(order.begin(), order.end());
+      order.erase(std::unique(order.begin(), order.end()), order.end());
+      // Remember each mutex: a resize may swap in a new lock array while we
+      // are still locking.
+      held.clear();
+      for (size_t i : order) {
+        held.push_back(&locks_[i]);
+        held.back()->lock();
+      }
+
+      // Retry if a resize happened before we held every lock.
+      bool stale = version_.load(std::memory_order_acquire) != ver_before;
+      bool result = !stale && fn();
+      for (std::mutex* lock : held) {
+        lock->unlock();
+      }
+      if (!stale) {
+        used_cap = cap;
+        return result;
+      }
+    }
+  }
+
+  template <typename K>
+  bool RemoveHashed(const K& elem, size_t h) {
     while (true) {
       // Avoid starting an operation while another thread is resizing.
       WaitIfResizingByOther();
       size_t ver_before = version_.load(std::memory_order_acquire);
-      size_t i = Index(elem);
+      size_t i = IndexOfHash(h);
 
       std::unique_lock<std::mutex> bucket_lk(locks_[i]);
 
@@ -83,24 +308,23 @@ class HashSetRefinable : public HashSetBase<T> {
 
       // Hash set remove logic.
       auto& b = buckets_[i];
-      auto item = std::find(b.begin(), b.end(), elem);
+      auto item = bucket::Find(b, elem);
       if (item == b.end()) {
         return false;
       }
       b.erase(item);
       size_.fetch_sub(1, std::memory_order_relaxed);
-      break;
+      return true;
     }
-    return true;
   }
 
-  // Check elem by locking the bucket; retry if a resize intervenes.
-  [[nodiscard]] bool Contains(T elem) final {
+  template <typename K>
+  bool ContainsHashed(const K& elem, size_t h) {
     while (true) {
       // Avoid starting an operation while another thread is resizing.
       WaitIfResizingByOther();
       size_t ver_before = version_.load(std::memory_order_acquire);
-      size_t i = Index(elem);
+      size_t i = IndexOfHash(h);
 
       std::unique_lock<std::mutex> bucket_lk(locks_[i]);
 
@@ -110,46 +334,16 @@ class HashSetRefinable : public HashSetBase<T> {
       }
 
       auto& b = buckets_[i];
-      return std::find(b.begin(), b.end(), elem) != b.end();
+      return bucket::Find(b, elem) != b.end();
     }
   }
 
-  // No synchronization needed; size_ is atomic.
-  [[nodiscard]] size_t Size() const final {
-    return size_.load(std::memory_order_relaxed);
-  }
-
- private:
-  std::vector<std::vector<T>> buckets_;
-  std::atomic<size_t> size_;
-  std::hash<T> hasher_;
-  std::vector<std::mutex>
-      locks_;  // One lock per bucket; size always equals buckets_.size().
-
-  std::mutex resize_mutex_;      // Separate mutex exclusively for resizing.
-  std::atomic<size_t> version_;  // version stamp for resize detection
-  std::atomic<bool> resizing_;   // resizing flag
-  std::atomic<size_t> owner_tid_hash_;  // resizing operation owner
-
-  // Keep old lock arrays alive to avoid premature mutex destruction.
-  std::vector<std::vector<std::mutex>> old_lock_arrays_;
-
-  static constexpr size_t kMinBuckets = 4;
-  static constexpr double kMaxLoadFactor = 4.0;
-  static constexpr double kMinLoadFactor = 1.0;
-
-  static size_t NormalizeCapacity(size_t cap) {
-    return cap == 0 ? kMinBuckets : cap;
-  }
-
-  size_t Index(const T& elem) const { return hasher_(elem) % buckets_.size(); }
-
   void Resize(size_t new_capacity) {
     // Ensure only one resizer runs; normal ops will spin while a
     // resizer owned by another thread is active.
     std::unique_lock<std::mutex> resizer_lock(resize_mutex_);
 
-    new_capacity = std::max(kMinBuckets, NormalizeCapacity(new_capacity));
+    new_capacity = NormalizeCapacity(new_capacity);
 
     // Check if another thread already resized to the desired capacity.
     if (new_capacity == buckets_.size()) {
@@ -0,0 +1,321 @@
+#ifndef HASH_SET_REPLICATED_H
+#define HASH_SET_REPLICATED_H
+
+#include <sched.h>  // sched_getcpu
+
+#include <algorithm>     // std::max, std::min
+#include <atomic>        // std::atomic
+#include <cstddef>       // size_t
+#include <cstdint>       // uint32_t, uint64_t
+#include <fstream>       // std::ifstream
+#include <functional>    // std::hash
+#include <memory>        // std::unique_ptr
+#include <mutex>         // std::unique_lock
+#include <shared_mutex>  // std::shared_mutex, std::shared_lock
+#include <sstream>       // std::istringstream
+#include <string>        // std::string, std::getline
+#include <thread>        // std::this_thread::yield
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
+#include "src/hash_set_sequential.h"
+
+struct ReplicatedOptions {
+  // CPUs served by each replica: replica i serves the threads running on
+  // the CPUs in cpu_groups[i]. Empty means one replica per NUMA node, as
+  // listed under /sys/devices/system/node, or a single replica if that
+  // cannot be read. Threads on CPUs in no group use replica cpu % replicas.
+  std::vector<std::vector<int>> cpu_groups;
+  // Operation log entries, rounded up to a power of two. Writers wait once
+  // the slowest replica is this many operations behind.
+  size_t log_entries = 1 << 14;
+  // Load factors and minimum table size of each replica.
+  HashSetParams params{};
+};
+
+// Node replication: one HashSetSequential per socket (or per configured CPU
+// group), kept in step through a shared operation log, so lookups read
+// only memory local to their socket.
+//
+// Add and Remove append the operation to the log, a ring of entries
+// claimed in order by a CAS on the tail. The writer then takes its
+// replica's lock exclusively and applies every log entry the replica has
+// not seen yet, its own included. Whoever applies an entry on the replica
+// it came from records its result for the waiting writer, so writers on
+// one replica share the work of catching up. The log order is the order of
+// all writes; every replica applies the same sequence, so each reaches the
+// same state.
+//
+// Contains reads the log tail, then, under its replica's lock held shared,
+// answers from the replica if that has applied everything up to the tail.
+// Otherwise it catches the replica up under the lock held exclusively.
+// Either way the answer reflects every write completed before the call.
+//
+// A log slot is reused only once every replica has applied its entry. A
+// writer that finds the log full catches the lagging replicas up itself,
+// so a replica with no active threads cannot stall the others.
+//
+// Threads can be tied to a replica with BindThisThread, which overrides
+// the CPU mapping; tests on a single-socket machine use it to form groups.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetReplicated : public HashSetBase<T> {
+ public:
+  explicit HashSetReplicated(size_t initial_capacity,
+                             const ReplicatedOptions& options = {})
+      : log_mask_(RoundUpToPowerOfTwo(std::max<size_t>(options.log_entries,
+                                                       2)) -
+                  1),
+        log_(std::make_unique<Entry[]>(log_mask_ + 1)) {
+    std::vector<std::vector<int>> groups = options.cpu_groups;
+    if (groups.empty()) {
+      groups = NumaNodeCpus();
+    }
+    size_t replicas = std::max<size_t>(groups.size(), 1);
+    replicas_.reserve(replicas);
+    for (size_t r = 0; r < replicas; ++r) {
+      replicas_.push_back(std::make_unique<Replica>(
+          static_cast<uint32_t>(r), initial_capacity, options.params));
+    }
+    for (size_t r = 0; r < groups.size(); ++r) {
+      for (int cpu : groups[r]) {
+        if (cpu < 0) {
+          continue;
+        }
+        auto c = static_cast<size_t>(cpu);
+        if (cpu_to_replica_.size() <= c) {
+          cpu_to_replica_.resize(c + 1, kUnmapped);
+        }
+        cpu_to_replica_[c] = static_cast<uint32_t>(r);
+      }
+    }
+  }
+
+  HashSetReplicated(const HashSetReplicated&) = delete;
+  HashSetReplicated& operator=(const HashSetReplicated&) = delete;
+
+  bool Add(T elem) final { return Execute(Op::kAdd, std::move(elem)); }
+
+  bool Remove(T elem) final { return Execute(Op::kRemove, std::move(elem)); }
+
+  // Served from the calling thread's replica.
+  [[nodiscard]] bool Contains(T elem) final {
+    Replica& replica = *replicas_[ReplicaOfThisThread()];
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    {
+      std::shared_lock<std::shared_mutex> lk(replica.lock);
+      if (replica.applied.load(std::memory_order_relaxed) >= tail) {
+        return replica.set.Contains(elem);
+      }
+    }
+    std::unique_lock<std::shared_mutex> lk(replica.lock);
+    CatchUp(replica, tail);
+    return replica.set.Contains(elem);
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Number of replicas.
+  [[nodiscard]] size_t ReplicaCount() const { return replicas_.size(); }
+
+  // Routes the calling thread's operations on every set of this type to
+  // replica |replica| (modulo the replica count), whatever CPU it runs on.
+  static void BindThisThread(size_t replica) { BoundReplica() = replica; }
+
+  // Returns the calling thread to the CPU-based mapping.
+  static void UnbindThisThread() { BoundReplica() = kUnbound; }
+
+ private:
+  enum class Op : uint32_t { kAdd, kRemove };
+
+  static constexpr uint32_t kUnmapped = UINT32_MAX;
+  static constexpr size_t kUnbound = SIZE_MAX;
+
+  struct Entry {
+    // index + 1 once the entry for log index |index| is written.
+    std::atomic<uint64_t> seq{0};
+    Op op = Op::kAdd;
+    uint32_t origin = 0;     // Replica of the writer
+    bool* result = nullptr;  // Writer's result, set when origin applies it
+    T key{};
+  };
+
+  struct alignas(64) Replica {
+    Replica(uint32_t index, size_t initial_capacity,
+            const HashSetParams& params)
+        : id(index), set(initial_capacity, params) {}
+
+    const uint32_t id;
+    std::shared_mutex lock;
+    HashSetSequential<T, Hash> set;    // Guarded by lock
+    std::atomic<uint64_t> applied{0};  // Log entries applied; under lock
+  };
+
+  const size_t log_mask_;
+  std::unique_ptr<Entry[]> log_;
+  alignas(64) std::atomic<uint64_t> tail_{0};  // Log entries claimed
+  alignas(64) std::atomic<size_t> size_{0};
+  std::vector<std::unique_ptr<Replica>> replicas_;
+  std::vector<uint32_t> cpu_to_replica_;
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  static size_t& BoundReplica() {
+    thread_local size_t replica = kUnbound;
+    return replica;
+  }
+
+  size_t ReplicaOfThisThread() const {
+    size_t bound = BoundReplica();
+    if (bound != kUnbound) {
+      return bound % replicas_.size();
+    }
+    if (replicas_.size() == 1) {
+      return 0;
+    }
+    int cpu = sched_getcpu();
+    if (cpu < 0) {
+      return 0;
+    }
+    auto c = static_cast<size_t>(cpu);
+    if (c < cpu_to_replica_.size() && cpu_to_replica_[c] != kUnmapped) {
+      return cpu_to_replica_[c];
+    }
+    return c % replicas_.size();
+  }
+
+  // Parses a sysfs CPU list such as "0-7,16-23".
+  static std::vector<int> ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+      size_t dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first
+                                           : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  // CPUs of each NUMA node with any, or nothing if sysfs has no nodes.
+  static std::vector<std::vector<int>> NumaNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; ++node) {
+      std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) +
+                       "/cpulist");
+      if (!in) {
+        break;
+      }
+      std::string list;
+      std::getline(in, list);
+      std::vector<int> cpus = ParseCpuList(list);
+      if (!cpus.empty()) {
+        nodes.push_back(std::move(cpus));
+      }
+    }
+    return nodes;
+  }
+
+  // Appends the operation to the log, then catches the writer's replica up
+  // to and including it.
+  bool Execute(Op op, T elem) {
+    size_t origin = ReplicaOfThisThread();
+    bool result = false;
+    uint64_t index = Claim();
+    Entry& entry = log_[index & log_mask_];
+    entry.op = op;
+    entry.origin = static_cast<uint32_t>(origin);
+    entry.result = &result;
+    entry.key = std::move(elem);
+    entry.seq.store(index + 1, std::memory_order_release);
+
+    Replica& replica = *replicas_[origin];
+    std::unique_lock<std::shared_mutex> lk(replica.lock);
+    CatchUp(replica, index + 1);
+    // Whoever applied the entry did so under this lock, so |result| is set.
+    return result;
+  }
+
+  // Claims the next log index once its slot is free, helping any replica
+  // that is a whole log behind.
+  uint64_t Claim() {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      uint64_t oldest = MinApplied();
+      if (tail - oldest > log_mask_) {
+        for (auto& replica : replicas_) {
+          if (replica->applied.load(std::memory_order_acquire) == oldest) {
+            std::unique_lock<std::shared_mutex> lk(replica->lock);
+            CatchUp(*replica, tail_.load(std::memory_order_acquire),
+                    /*wait=*/false);
+          }
+        }
+        std::this_thread::yield();
+        tail = tail_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (tail_.compare_exchange_weak(tail, tail + 1,
+                                      std::memory_order_acq_rel)) {
+        return tail;
+      }
+    }
+  }
+
+  uint64_t MinApplied() const {
+    uint64_t oldest = UINT64_MAX;
+    for (const auto& replica : replicas_) {
+      oldest =
+          std::min(oldest, replica->applied.load(std::memory_order_acquire));
+    }
+    return oldest;
+  }
+
+  // Applies log entries to |replica| until it has applied |target| of them.
+  // Entries claimed but not yet written are waited for; their writers hold
+  // no lock while writing them. With wait false, stops at the first such
+  // entry instead. Caller holds replica.lock exclusively.
+  void CatchUp(Replica& replica, uint64_t target, bool wait = true) {
+    uint64_t index = replica.applied.load(std::memory_order_relaxed);
+    for (; index < target; ++index) {
+      Entry& entry = log_[index & log_mask_];
+      while (entry.seq.load(std::memory_order_acquire) != index + 1) {
+        if (!wait) {
+          replica.applied.store(index, std::memory_order_release);
+          return;
+        }
+        std::this_thread::yield();
+      }
+      bool changed = entry.op == Op::kAdd ? replica.set.Add(entry.key)
+                                          : replica.set.Remove(entry.key);
+      if (entry.origin == replica.id) {
+        *entry.result = changed;
+        if (changed) {
+          if (entry.op == Op::kAdd) {
+            size_.fetch_add(1, std::memory_order_relaxed);
+          } else {
+            size_.fetch_sub(1, std::memory_order_relaxed);
+          }
+        }
+      }
+    }
+    replica.applied.store(index, std::memory_order_release);
+  }
+};
+
+#endif  // HASH_SET_REPLICATED_H
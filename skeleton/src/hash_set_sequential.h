@@ -8,67 +8,139 @@
 #include <utility>
 #include <vector>
 
+#include "src/batch_hash.h"
+#include "src/bucket.h"
 #include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
 
 // All operations share the same lock; inefficient but simple.
-template <typename T>
+template <typename T, typename Hash = std::hash<T>>
 class HashSetSequential : public HashSetBase<T> {
  public:
-  explicit HashSetSequential(size_t initial_capacity)
-      : buckets_(
-            std::max<size_t>(NormalizeCapacity(initial_capacity), kMinBuckets)),
+  explicit HashSetSequential(size_t initial_capacity,
+                             const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        buckets_(NormalizeCapacity(initial_capacity)),
         size_(0) {}
 
   // Returns true if elem was newly inserted.
   bool Add(T elem) final {
-    size_t i = Index(elem);
-    auto& b = buckets_[i];
-    if (std::find(b.begin(), b.end(), elem) != b.end()) {
-      return false;
-    }
-    b.push_back(std::move(elem));
-    ++size_;
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
 
-    if (LoadFactor() > kMaxLoadFactor) {
-      Resize(buckets_.size() * 2);
-    }
-    return true;
+  // Constructs the element from |args| and adds it as Add does.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Add(T(std::forward<Args>(args)...));
   }
 
   // Returns true if elem existed and was removed.
-  bool Remove(T elem) final {
-    size_t i = Index(elem);
-    auto& b = buckets_[i];
-    auto it = std::find(b.begin(), b.end(), elem);
-    if (it == b.end()) return false;
-    b.erase(it);
-    --size_;
-    return true;
+  bool Remove(T elem) final { return RemoveHashed(elem, hasher_(elem)); }
+
+  // Heterogeneous Remove: finds |key| without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  bool Remove(const K& key) {
+    return RemoveHashed(key, hasher_(key));
   }
 
   // Returns true if elem is present.
   [[nodiscard]] bool Contains(T elem) final {
-    size_t i = Index(elem);
-    const auto& b = buckets_[i];
-    return std::find(b.begin(), b.end(), elem) != b.end();
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // Heterogeneous Contains: looks |key| up without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  [[nodiscard]] bool Contains(const K& key) {
+    return ContainsHashed(key, hasher_(key));
   }
 
   // Returns the size of the hash set.
   [[nodiscard]] size_t Size() const final { return size_; }
 
- private:
-  static constexpr size_t kMinBuckets = 4;
-  static constexpr double kMaxLoadFactor = 4.0;
+  // Bulk load: grows the table once for the whole batch, then inserts with
+  // hashes computed by the batch kernel.
+  size_t AddBatch(const T* elems, size_t n) final {
+    Reserve(size_ + n);
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
 
-  static size_t NormalizeCapacity(size_t cap) {
-    return cap == 0 ? kMinBuckets : cap;
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
   }
 
-  size_t Index(const T& x) const { return hasher_(x) % buckets_.size(); }
+  // Calls fn(elem) for every element, in bucket order.
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const auto& b : buckets_) {
+      for (const auto& v : b) {
+        fn(v);
+      }
+    }
+  }
+
+ private:
+  size_t NormalizeCapacity(size_t cap) const {
+    return std::max(cap, params_.min_buckets);
+  }
+
+  size_t IndexOfHash(size_t h) const { return h % buckets_.size(); }
   double LoadFactor() const {
     return static_cast<double>(size_) / static_cast<double>(buckets_.size());
   }
 
+  bool AddHashed(T elem, size_t h) {
+    auto& b = buckets_[IndexOfHash(h)];
+    if (bucket::Find(b, elem) != b.end()) {
+      return false;
+    }
+    b.push_back(std::move(elem));
+    ++size_;
+
+    if (LoadFactor() > params_.max_load_factor) {
+      Resize(buckets_.size() * 2);
+    }
+    return true;
+  }
+
+  template <typename K>
+  bool RemoveHashed(const K& elem, size_t h) {
+    auto& b = buckets_[IndexOfHash(h)];
+    auto it = bucket::Find(b, elem);
+    if (it == b.end()) return false;
+    b.erase(it);
+    --size_;
+    return true;
+  }
+
+  template <typename K>
+  bool ContainsHashed(const K& elem, size_t h) const {
+    const auto& b = buckets_[IndexOfHash(h)];
+    return bucket::Find(b, elem) != b.end();
+  }
+
+  // Doubles the table until |count| elements fit under max_load_factor.
+  void Reserve(size_t count) {
+    size_t cap = buckets_.size();
+    while (static_cast<double>(count) >
+           params_.max_load_factor * static_cast<double>(cap)) {
+      cap *= 2;
+    }
+    if (cap != buckets_.size()) {
+      Resize(cap);
+    }
+  }
+
   // Rehash all elements into a table with new_cap buckets.
   void Resize(size_t new_cap) {
     std::vector<std::vector<T>> new_buckets(new_cap);
@@ -81,9 +153,10 @@ class HashSetSequential : public HashSetBase<T> {
     buckets_.swap(new_buckets);
   }
 
+  HashSetParams params_;
   std::vector<std::vector<T>> buckets_;
   size_t size_;
-  std::hash<T> hasher_;
+  Hash hasher_;
 };
 
 #endif  // HASH_SET_SEQUENTIAL_H
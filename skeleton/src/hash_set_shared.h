@@ -0,0 +1,460 @@
+#ifndef HASH_SET_SHARED_H
+#define HASH_SET_SHARED_H
+
+#include <fcntl.h>     // O_* flags
+#include <pthread.h>   // pthread_mutex_*
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate
+
+#include <algorithm>    // std::max
+#include <atomic>       // std::atomic
+#include <cerrno>       // EOWNERDEAD
+#include <chrono>       // std::chrono::steady_clock
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <cstring>      // std::memset
+#include <functional>   // std::hash
+#include <memory>       // std::unique_ptr
+#include <new>          // placement new
+#include <stdexcept>    // std::length_error
+#include <string>       // std::string
+#include <thread>       // std::this_thread::yield
+#include <type_traits>  // std::is_trivially_copyable_v
+
+#include "src/hash_set_base.h"
+
+// A striped hash set that lives entirely in a POSIX shared-memory segment, so
+// several processes can map one copy instead of each keeping its own.
+//
+// Everything in the segment refers to everything else by offset from the
+// segment start, since each process maps it at a different address. The
+// layout is a Header (stripe locks and counters), then an arena from which
+// nodes and bucket arrays are bump-allocated. Buckets are chains of nodes;
+// removed nodes go on their stripe's free list for reuse, up to
+// kStripeFreeNodes of them, and past that on a free list shared by all
+// stripes under its own lock. Add takes a node from its stripe's list, then
+// the shared one, then the arena. Growing allocates a bucket array twice the
+// size from the arena and relinks every node into it under all stripe
+// locks, the same protocol as HashSetStriped. Old bucket arrays are not
+// reused, which at most doubles the space they take. The segment is sized
+// for |max_elements| plus every node the stripe lists can hold back, so Add
+// only throws std::length_error once the set really holds max_elements.
+//
+// Locks are process-shared robust mutexes. If a process dies holding one,
+// the next locker takes it over: a single Add or Remove publishes its change
+// with one store, so a death costs at most a leaked node and a stale size.
+// Dying inside a resize can lose keys.
+//
+// T must be trivially copyable, and Hash must give every process the same
+// result (std::hash on integers does).
+template <typename T, typename Hash = std::hash<T>>
+class HashSetShared : public HashSetBase<T> {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "keys are stored in shared memory as raw bytes");
+
+ public:
+  // Creates the segment |name| (e.g. "/my_set"), which must not exist yet.
+  // Returns nullptr on failure.
+  static std::unique_ptr<HashSetShared> Create(const std::string& name,
+                                               size_t initial_capacity,
+                                               size_t max_elements) {
+    size_t buckets = std::max<size_t>(initial_capacity, kStripes);
+    // Nodes for every element and for the stripes' free lists, plus every
+    // bucket array up to the one max_elements grows into (a geometric
+    // series below twice the last).
+    size_t last_buckets = buckets;
+    while (static_cast<double>(max_elements) >
+           kMaxLoadFactor * static_cast<double>(last_buckets)) {
+      last_buckets *= 2;
+    }
+    size_t nodes = max_elements + kStripes * kStripeFreeNodes;
+    size_t bytes = RoundUp(sizeof(Header), alignof(Node)) +
+                   nodes * sizeof(Node) +
+                   2 * last_buckets * sizeof(uint64_t);
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+      return nullptr;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      return nullptr;
+    }
+    void* base = Map(fd, bytes);
+    if (base == nullptr) {
+      ::shm_unlink(name.c_str());
+      return nullptr;
+    }
+    auto set = std::unique_ptr<HashSetShared>(
+        new HashSetShared(static_cast<char*>(base), bytes));
+    set->Initialize(buckets);
+    return set;
+  }
+
+  // Attaches to the segment |name| made by Create, in this or another
+  // process. Returns nullptr if it does not exist or is not a set of T.
+  static std::unique_ptr<HashSetShared> Open(const std::string& name) {
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header)) {
+      ::close(fd);
+      return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* base = Map(fd, bytes);
+    if (base == nullptr) {
+      return nullptr;
+    }
+    auto set = std::unique_ptr<HashSetShared>(
+        new HashSetShared(static_cast<char*>(base), bytes));
+    // The creator publishes ready last, after every other header field. A
+    // segment that never becomes ready was not made by Create.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (set->header_->ready.load(std::memory_order_acquire) == 0) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+    if (set->header_->magic != kMagic || set->header_->key_size != sizeof(T)) {
+      return nullptr;
+    }
+    return set;
+  }
+
+  // Removes the segment's name; processes that have it mapped keep using
+  // it until they let go.
+  static bool Unlink(const std::string& name) {
+    return ::shm_unlink(name.c_str()) == 0;
+  }
+
+  // Unmaps this process's view; the segment itself outlives it.
+  ~HashSetShared() override { ::munmap(base_, bytes_); }
+
+  HashSetShared(const HashSetShared&) = delete;
+  HashSetShared& operator=(const HashSetShared&) = delete;
+
+  bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    size_t buckets;
+    while (true) {
+      buckets = header_->buckets.load(std::memory_order_acquire);
+      size_t i = h % buckets;
+      Stripe& stripe = header_->stripes[i % kStripes];
+      StripeGuard guard(stripe.lock);
+      if (buckets != header_->buckets.load(std::memory_order_acquire)) {
+        continue;  // Resized while we waited.
+      }
+      uint64_t* head = Buckets() + i;
+      if (FindIn(*head, elem) != 0) {
+        return false;
+      }
+      uint64_t node = Allocate(stripe);
+      At<Node>(node)->key = elem;
+      At<Node>(node)->next = *head;
+      *head = node;  // Publishes the node.
+      header_->size.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    if (static_cast<double>(Size()) >
+        kMaxLoadFactor * static_cast<double>(buckets)) {
+      Resize(buckets * 2);
+    }
+    return true;
+  }
+
+  bool Remove(T elem) final {
+    size_t h = hasher_(elem);
+    while (true) {
+      size_t buckets = header_->buckets.load(std::memory_order_acquire);
+      size_t i = h % buckets;
+      Stripe& stripe = header_->stripes[i % kStripes];
+      StripeGuard guard(stripe.lock);
+      if (buckets != header_->buckets.load(std::memory_order_acquire)) {
+        continue;
+      }
+      uint64_t* link = Buckets() + i;
+      while (*link != 0 && !(At<Node>(*link)->key == elem)) {
+        link = &At<Node>(*link)->next;
+      }
+      if (*link == 0) {
+        return false;
+      }
+      uint64_t node = *link;
+      *link = At<Node>(node)->next;  // Unlinks the node.
+      Free(stripe, node);
+      header_->size.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  [[nodiscard]] bool Contains(T elem) final {
+    size_t h = hasher_(elem);
+    while (true) {
+      size_t buckets = header_->buckets.load(std::memory_order_acquire);
+      size_t i = h % buckets;
+      StripeGuard guard(header_->stripes[i % kStripes].lock);
+      if (buckets != header_->buckets.load(std::memory_order_acquire)) {
+        continue;
+      }
+      return FindIn(Buckets()[i], elem) != 0;
+    }
+  }
+
+  // Across all processes.
+  [[nodiscard]] size_t Size() const final {
+    return static_cast<size_t>(header_->size.load(std::memory_order_relaxed));
+  }
+
+  // Calls fn(elem) for every element while holding every stripe lock, so it
+  // sees a consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    StripeGuard resize_guard(header_->resize_lock);
+    LockAllStripes();
+    size_t buckets = header_->buckets.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < buckets; ++i) {
+      for (uint64_t node = Buckets()[i]; node != 0;
+           node = At<Node>(node)->next) {
+        fn(At<Node>(node)->key);
+      }
+    }
+    UnlockAllStripes();
+  }
+
+  // Size of the shared segment.
+  [[nodiscard]] size_t SegmentBytes() const { return bytes_; }
+
+ private:
+  static constexpr uint64_t kMagic = 0x5348415245445345ull;  // "SHAREDSE"
+  static constexpr size_t kStripes = 256;
+  static constexpr double kMaxLoadFactor = 2.0;
+  // Free nodes a stripe keeps to itself; Create reserves room for all of
+  // them on top of max_elements.
+  static constexpr uint32_t kStripeFreeNodes = 16;
+
+  struct Node {
+    uint64_t next;  // Offset of the next node in the chain; 0 ends it
+    T key;
+  };
+
+  // One cache line per stripe, as in HashSetStriped.
+  struct alignas(64) Stripe {
+    pthread_mutex_t lock;
+    uint64_t free_list;   // Removed nodes of this stripe; under lock
+    uint32_t free_count;  // Length of free_list, at most kStripeFreeNodes
+  };
+
+  struct Header {
+    uint64_t magic;
+    uint32_t key_size;
+    std::atomic<uint32_t> ready;  // Set once the header is initialised
+    pthread_mutex_t resize_lock;
+    std::atomic<uint64_t> size;
+    std::atomic<uint64_t> buckets;        // Written under every stripe lock
+    std::atomic<uint64_t> bucket_offset;  // Likewise
+    std::atomic<uint64_t> arena_used;     // Bump pointer, an offset
+    pthread_mutex_t free_lock;  // Taken inside a stripe lock, never around
+    uint64_t free_list;         // Nodes any stripe may reuse; under free_lock
+    Stripe stripes[kStripes];
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "shared-memory atomics must not need a process-local lock");
+
+  // Locks a robust mutex, taking it over if its owner died.
+  class StripeGuard {
+   public:
+    explicit StripeGuard(pthread_mutex_t& mutex) : mutex_(mutex) {
+      Lock(mutex_);
+    }
+    ~StripeGuard() { pthread_mutex_unlock(&mutex_); }
+    StripeGuard(const StripeGuard&) = delete;
+    StripeGuard& operator=(const StripeGuard&) = delete;
+
+   private:
+    pthread_mutex_t& mutex_;
+  };
+
+  char* base_;
+  size_t bytes_;
+  Header* header_;
+  Hash hasher_;
+
+  HashSetShared(char* base, size_t bytes)
+      : base_(base), bytes_(bytes), header_(reinterpret_cast<Header*>(base)) {}
+
+  static size_t RoundUp(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+  }
+
+  static void* Map(int fd, size_t bytes) {
+    void* base =
+        ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the segment open.
+    return base == MAP_FAILED ? nullptr : base;
+  }
+
+  static void Lock(pthread_mutex_t& mutex) {
+    if (pthread_mutex_lock(&mutex) == EOWNERDEAD) {
+      pthread_mutex_consistent(&mutex);
+    }
+  }
+
+  static void InitMutex(pthread_mutex_t& mutex) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+  }
+
+  // The segment is zero-filled by ftruncate; only what is not zero needs
+  // setting.
+  void Initialize(size_t buckets) {
+    Header* header = new (base_) Header;
+    header->magic = kMagic;
+    header->key_size = sizeof(T);
+    InitMutex(header->resize_lock);
+    InitMutex(header->free_lock);
+    header->free_list = 0;
+    for (Stripe& stripe : header->stripes) {
+      InitMutex(stripe.lock);
+      stripe.free_list = 0;
+      stripe.free_count = 0;
+    }
+    header->size.store(0, std::memory_order_relaxed);
+    header->arena_used.store(RoundUp(sizeof(Header), alignof(Node)),
+                             std::memory_order_relaxed);
+    uint64_t offset = Bump(buckets * sizeof(uint64_t));
+    header->bucket_offset.store(offset, std::memory_order_relaxed);
+    header->buckets.store(buckets, std::memory_order_relaxed);
+    header->ready.store(1, std::memory_order_release);
+  }
+
+  template <typename U>
+  U* At(uint64_t offset) const {
+    return reinterpret_cast<U*>(base_ + offset);
+  }
+
+  // Caller holds a stripe lock (or every one).
+  uint64_t* Buckets() const {
+    return At<uint64_t>(
+        header_->bucket_offset.load(std::memory_order_relaxed));
+  }
+
+  // Offset of the node holding |elem| in the chain at |node|, or 0.
+  uint64_t FindIn(uint64_t node, const T& elem) const {
+    while (node != 0 && !(At<Node>(node)->key == elem)) {
+      node = At<Node>(node)->next;
+    }
+    return node;
+  }
+
+  // Takes |bytes| from the arena, or returns 0 if it is exhausted. The bump
+  // pointer only moves when the request fits, so a request that does not
+  // fit never makes a concurrent one that would have fail.
+  uint64_t Bump(size_t bytes) {
+    bytes = RoundUp(bytes, alignof(Node));
+    uint64_t offset = header_->arena_used.load(std::memory_order_relaxed);
+    do {
+      if (offset + bytes > bytes_) {
+        return 0;
+      }
+    } while (!header_->arena_used.compare_exchange_weak(
+        offset, offset + bytes, std::memory_order_relaxed));
+    return offset;
+  }
+
+  // A node from the stripe's free list, the shared free list or the arena.
+  // Caller holds the stripe lock.
+  uint64_t Allocate(Stripe& stripe) {
+    if (stripe.free_list != 0) {
+      uint64_t node = stripe.free_list;
+      stripe.free_list = At<Node>(node)->next;
+      --stripe.free_count;
+      return node;
+    }
+    {
+      StripeGuard guard(header_->free_lock);
+      if (header_->free_list != 0) {
+        uint64_t node = header_->free_list;
+        header_->free_list = At<Node>(node)->next;
+        return node;
+      }
+    }
+    uint64_t node = Bump(sizeof(Node));
+    if (node == 0) {
+      throw std::length_error("HashSetShared: segment full");
+    }
+    return node;
+  }
+
+  // Puts a removed node on the stripe's free list, or the shared one once
+  // the stripe holds kStripeFreeNodes. Caller holds the stripe lock.
+  void Free(Stripe& stripe, uint64_t node) {
+    if (stripe.free_count < kStripeFreeNodes) {
+      At<Node>(node)->next = stripe.free_list;
+      stripe.free_list = node;
+      ++stripe.free_count;
+      return;
+    }
+    StripeGuard guard(header_->free_lock);
+    At<Node>(node)->next = header_->free_list;
+    header_->free_list = node;
+  }
+
+  void LockAllStripes() {
+    for (Stripe& stripe : header_->stripes) {
+      Lock(stripe.lock);
+    }
+  }
+
+  void UnlockAllStripes() {
+    for (Stripe& stripe : header_->stripes) {
+      pthread_mutex_unlock(&stripe.lock);
+    }
+  }
+
+  // Relinks every node into a new bucket array of |new_buckets|. Keeps the
+  // current array if the arena has no room for a larger one.
+  void Resize(size_t new_buckets) {
+    StripeGuard resize_guard(header_->resize_lock);
+    size_t old_buckets = header_->buckets.load(std::memory_order_relaxed);
+    if (old_buckets >= new_buckets) {
+      return;  // Another thread or process already grew it.
+    }
+    uint64_t offset = Bump(new_buckets * sizeof(uint64_t));
+    if (offset == 0) {
+      return;
+    }
+    uint64_t* to = At<uint64_t>(offset);
+    std::memset(to, 0, new_buckets * sizeof(uint64_t));
+
+    LockAllStripes();
+    uint64_t* from = Buckets();
+    for (size_t i = 0; i < old_buckets; ++i) {
+      uint64_t node = from[i];
+      while (node != 0) {
+        uint64_t next = At<Node>(node)->next;
+        size_t j = hasher_(At<Node>(node)->key) % new_buckets;
+        At<Node>(node)->next = to[j];
+        to[j] = node;
+        node = next;
+      }
+    }
+    // Nodes freed under an old stripe mapping stay valid under the new
+    // one: free lists are just pools, not tied to buckets.
+    header_->bucket_offset.store(offset, std::memory_order_relaxed);
+    header_->buckets.store(new_buckets, std::memory_order_release);
+    UnlockAllStripes();
+  }
+};
+
+#endif  // HASH_SET_SHARED_H
@@ -0,0 +1,436 @@
+#ifndef HASH_SET_SKIPLIST_H
+#define HASH_SET_SKIPLIST_H
+
+#include <algorithm>   // std::max
+#include <array>       // std::array
+#include <atomic>      // std::atomic
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t, std::uintptr_t
+#include <functional>  // std::less
+#include <memory>      // std::unique_ptr
+#include <mutex>       // std::mutex, std::scoped_lock
+#include <optional>    // std::optional
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "src/hash_set_base.h"
+
+// Ordered set as a lazy skiplist (Herlihy & Shavit, "The Art of
+// Multiprocessor Programming", section 14.3). Contains, LowerBound and the
+// ordered traversals take no locks. Add and Remove lock only the
+// predecessors they relink, and validate them before changing anything.
+// Removal first marks a node (logical delete), then unlinks it.
+//
+// Unlinked nodes are freed by epoch-based reclamation, since a lock-free
+// reader may still be standing on one. Every operation registers as a
+// reader of the current epoch for as long as it holds node pointers, and
+// the epoch only advances once no reader is left from the one before it.
+// A node unlinked by an operation of epoch e is therefore out of every
+// reader's reach once the epoch reaches e + 3. Removers free such nodes in
+// batches, so memory follows the live size plus about a batch of removals,
+// unless an operation stalls (a traversal's fn counts as part of it).
+//
+// T must be default-constructible (the head sentinel holds a T{} it never
+// compares).
+template <typename T, typename Compare = std::less<T>>
+class HashSetSkiplist : public HashSetBase<T> {
+ public:
+  // The capacity is accepted for interface parity with the hash sets.
+  explicit HashSetSkiplist(size_t /*initial_capacity*/)
+      : head_(std::make_unique<Node>(T{}, kMaxLevel - 1)), size_(0) {}
+
+  // Linked nodes are owned by the list itself; retired ones by retired_.
+  ~HashSetSkiplist() override {
+    Node* node = head_->next[0].load(std::memory_order_relaxed);
+    while (node != nullptr) {
+      Node* next = node->next[0].load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  HashSetSkiplist(const HashSetSkiplist&) = delete;
+  HashSetSkiplist& operator=(const HashSetSkiplist&) = delete;
+
+  bool Add(T elem) final {
+    ReadGuard guard(*this);
+    size_t top_level = RandomLevel();
+    std::array<Node*, kMaxLevel> preds;
+    std::array<Node*, kMaxLevel> succs;
+    while (true) {
+      int found = Find(elem, preds, succs);
+      if (found != -1) {
+        Node* node = succs[static_cast<size_t>(found)];
+        if (!node->marked.load(std::memory_order_acquire)) {
+          // Present; wait until it is visible at every level.
+          while (!node->fully_linked.load(std::memory_order_acquire)) {
+          }
+          return false;
+        }
+        continue;  // Being removed; retry once it is unlinked.
+      }
+
+      LockedPreds locked;
+      bool valid = true;
+      for (size_t level = 0; valid && level <= top_level; ++level) {
+        Node* pred = preds[level];
+        Node* succ = succs[level];
+        locked.Lock(pred);
+        valid = !pred->marked.load(std::memory_order_acquire) &&
+                (succ == nullptr ||
+                 !succ->marked.load(std::memory_order_acquire)) &&
+                pred->next[level].load(std::memory_order_acquire) == succ;
+      }
+      if (!valid) {
+        continue;
+      }
+
+      auto owned = std::make_unique<Node>(std::move(elem), top_level);
+      Node* node = owned.get();
+      for (size_t level = 0; level <= top_level; ++level) {
+        node->next[level].store(succs[level], std::memory_order_relaxed);
+      }
+      for (size_t level = 0; level <= top_level; ++level) {
+        preds[level]->next[level].store(node, std::memory_order_release);
+      }
+      node->fully_linked.store(true, std::memory_order_release);
+      owned.release();  // Owned by the list from here on.
+      size_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  bool Remove(T elem) final {
+    Node* victim = nullptr;
+    uint64_t epoch = 0;
+    {
+      ReadGuard guard(*this);
+      victim = Unlink(elem);
+      epoch = guard.Epoch();
+    }
+    if (victim == nullptr) {
+      return false;
+    }
+    // Outside the guard, so this thread's own epoch does not hold back the
+    // reclamation.
+    Retire(victim, epoch);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Wait-free: one traversal, no locks.
+  [[nodiscard]] bool Contains(T elem) final {
+    ReadGuard guard(*this);
+    std::array<Node*, kMaxLevel> preds;
+    std::array<Node*, kMaxLevel> succs;
+    int found = Find(elem, preds, succs);
+    if (found == -1) {
+      return false;
+    }
+    const Node* node = succs[static_cast<size_t>(found)];
+    return node->fully_linked.load(std::memory_order_acquire) &&
+           !node->marked.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Removed nodes that are not freed yet.
+  [[nodiscard]] size_t RetiredCount() {
+    std::scoped_lock lock(retired_mutex_);
+    return retired_.size();
+  }
+
+  // Smallest element not less than |key|, if any.
+  [[nodiscard]] std::optional<T> LowerBound(const T& key) const {
+    ReadGuard guard(*this);
+    for (const Node* node = FirstNotLess(key); node != nullptr;
+         node = node->next[0].load(std::memory_order_acquire)) {
+      if (IsLive(node)) {
+        return node->key;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Calls fn(elem) for every element in [lo, hi), in ascending order. Like
+  // every traversal here it is weakly consistent: elements added or removed
+  // concurrently may or may not be seen, but nothing is seen twice.
+  template <typename Fn>
+  void RangeForEach(const T& lo, const T& hi, Fn&& fn) const {
+    ReadGuard guard(*this);
+    for (const Node* node = FirstNotLess(lo);
+         node != nullptr && less_(node->key, hi);
+         node = node->next[0].load(std::memory_order_acquire)) {
+      if (IsLive(node)) {
+        fn(node->key);
+      }
+    }
+  }
+
+  // Calls fn(elem) for every element in ascending order.
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    ReadGuard guard(*this);
+    for (const Node* node = head_->next[0].load(std::memory_order_acquire);
+         node != nullptr;
+         node = node->next[0].load(std::memory_order_acquire)) {
+      if (IsLive(node)) {
+        fn(node->key);
+      }
+    }
+  }
+
+ private:
+  // Levels 0 .. kMaxLevel - 1; with p = 1/2 that comfortably covers 2^20
+  // elements.
+  static constexpr size_t kMaxLevel = 20;
+  // Readers count themselves in one of kReaderShards counters, picked per
+  // thread, so registering rarely contends.
+  static constexpr size_t kReaderShards = 64;
+  // Retired nodes that trigger a reclamation pass, at least.
+  static constexpr size_t kReclaimBatch = 64;
+
+  struct Node {
+    Node(T k, size_t top) : key(std::move(k)), top_level(top), next(top + 1) {}
+
+    const T key;
+    const size_t top_level;
+    std::vector<std::atomic<Node*>> next;  // nullptr is the tail
+    std::mutex lock;
+    std::atomic<bool> marked{false};        // Logically removed
+    std::atomic<bool> fully_linked{false};  // Linked at every level
+  };
+
+  // Locks each distinct predecessor once and unlocks them on destruction.
+  // Predecessors only repeat at consecutive levels.
+  class LockedPreds {
+   public:
+    LockedPreds() = default;
+    LockedPreds(const LockedPreds&) = delete;
+    LockedPreds& operator=(const LockedPreds&) = delete;
+    ~LockedPreds() {
+      for (size_t i = 0; i < count_; ++i) {
+        nodes_[i]->lock.unlock();
+      }
+    }
+
+    void Lock(Node* node) {
+      if (count_ > 0 && nodes_[count_ - 1] == node) {
+        return;
+      }
+      node->lock.lock();
+      nodes_[count_++] = node;
+    }
+
+   private:
+    std::array<Node*, kMaxLevel> nodes_{};
+    size_t count_ = 0;
+  };
+
+  // Readers registered in each epoch parity. Epoch e's readers count in
+  // count[e & 1]; only e and e - 1 can have any, so two suffice.
+  struct alignas(64) ReaderShard {
+    std::atomic<size_t> count[2] = {0, 0};
+  };
+
+  // Registers the calling thread as a reader of the current epoch until
+  // destroyed. A reader that loaded a stale epoch rechecks after counting
+  // itself, so an advance never overlooks it. Nests.
+  class ReadGuard {
+   public:
+    explicit ReadGuard(const HashSetSkiplist& set) {
+      ReaderShard& shard = set.readers_[ShardIndex()];
+      while (true) {
+        epoch_ = set.epoch_.load();
+        count_ = &shard.count[epoch_ & 1];
+        count_->fetch_add(1);
+        if (set.epoch_.load() == epoch_) {
+          return;
+        }
+        count_->fetch_sub(1);
+      }
+    }
+    ~ReadGuard() { count_->fetch_sub(1, std::memory_order_release); }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    [[nodiscard]] uint64_t Epoch() const { return epoch_; }
+
+   private:
+    uint64_t epoch_ = 0;
+    std::atomic<size_t>* count_ = nullptr;
+  };
+
+  struct Retired {
+    std::unique_ptr<Node> node;
+    uint64_t epoch;  // Of the operation that unlinked it
+  };
+
+  std::unique_ptr<Node> head_;
+  std::atomic<size_t> size_;
+  Compare less_;
+  mutable std::atomic<uint64_t> epoch_{0};  // Advanced under retired_mutex_
+  mutable ReaderShard readers_[kReaderShards];
+  std::mutex retired_mutex_;
+  std::vector<Retired> retired_;       // Guarded by retired_mutex_
+  size_t reclaim_at_ = kReclaimBatch;  // Likewise
+
+  // The calling thread's reader shard, handed out round robin.
+  static size_t ShardIndex() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index =
+        next.fetch_add(1, std::memory_order_relaxed) % kReaderShards;
+    return index;
+  }
+
+  static bool IsLive(const Node* node) {
+    return node->fully_linked.load(std::memory_order_acquire) &&
+           !node->marked.load(std::memory_order_acquire);
+  }
+
+  // Geometric level with p = 1/2 from a per-thread xorshift generator.
+  static size_t RandomLevel() {
+    thread_local uint64_t state =
+        0x9e3779b97f4a7c15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    size_t level = 0;
+    uint64_t bits = state;
+    while ((bits & 1) != 0 && level < kMaxLevel - 1) {
+      ++level;
+      bits >>= 1;
+    }
+    return level;
+  }
+
+  // Fills preds/succs with the nodes around |key| at every level. Returns the
+  // highest level at which a node equal to |key| was found, or -1.
+  int Find(const T& key, std::array<Node*, kMaxLevel>& preds,
+           std::array<Node*, kMaxLevel>& succs) const {
+    int found = -1;
+    Node* pred = head_.get();
+    for (size_t level = kMaxLevel; level-- > 0;) {
+      Node* curr = pred->next[level].load(std::memory_order_acquire);
+      while (curr != nullptr && less_(curr->key, key)) {
+        pred = curr;
+        curr = pred->next[level].load(std::memory_order_acquire);
+      }
+      if (found == -1 && curr != nullptr && !less_(key, curr->key)) {
+        found = static_cast<int>(level);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return found;
+  }
+
+  // First node (live or not) whose key is not less than |key|.
+  const Node* FirstNotLess(const T& key) const {
+    const Node* pred = head_.get();
+    const Node* curr = nullptr;
+    for (size_t level = kMaxLevel; level-- > 0;) {
+      curr = pred->next[level].load(std::memory_order_acquire);
+      while (curr != nullptr && less_(curr->key, key)) {
+        pred = curr;
+        curr = pred->next[level].load(std::memory_order_acquire);
+      }
+    }
+    return curr;
+  }
+
+  // Marks the node holding |elem| and unlinks it at every level. Returns
+  // it, or nullptr if no live node holds |elem|. Caller holds a ReadGuard.
+  Node* Unlink(const T& elem) {
+    Node* victim = nullptr;
+    bool is_marked = false;
+    size_t top_level = 0;
+    std::array<Node*, kMaxLevel> preds;
+    std::array<Node*, kMaxLevel> succs;
+    while (true) {
+      int found = Find(elem, preds, succs);
+      if (found != -1) {
+        victim = succs[static_cast<size_t>(found)];
+      }
+      if (!is_marked) {
+        // Only a fully linked node found at its own top level is a
+        // candidate; anything else is mid-insert or mid-removal.
+        if (found == -1 ||
+            !victim->fully_linked.load(std::memory_order_acquire) ||
+            victim->top_level != static_cast<size_t>(found) ||
+            victim->marked.load(std::memory_order_acquire)) {
+          return nullptr;
+        }
+        top_level = victim->top_level;
+        victim->lock.lock();
+        if (victim->marked.load(std::memory_order_acquire)) {
+          victim->lock.unlock();
+          return nullptr;
+        }
+        victim->marked.store(true, std::memory_order_release);
+        is_marked = true;
+      }
+
+      LockedPreds locked;
+      bool valid = true;
+      for (size_t level = 0; valid && level <= top_level; ++level) {
+        Node* pred = preds[level];
+        locked.Lock(pred);
+        valid = !pred->marked.load(std::memory_order_acquire) &&
+                pred->next[level].load(std::memory_order_acquire) == victim;
+      }
+      if (!valid) {
+        continue;
+      }
+
+      for (size_t level = top_level + 1; level-- > 0;) {
+        preds[level]->next[level].store(
+            victim->next[level].load(std::memory_order_acquire),
+            std::memory_order_release);
+      }
+      victim->lock.unlock();
+      return victim;
+    }
+  }
+
+  // Queues |node|, unlinked by an operation of |epoch|, and once enough are
+  // queued frees those no reader can reach any more.
+  void Retire(Node* node, uint64_t epoch) {
+    std::scoped_lock lock(retired_mutex_);
+    retired_.push_back(Retired{std::unique_ptr<Node>(node), epoch});
+    if (retired_.size() < reclaim_at_) {
+      return;
+    }
+    // Three advances free everything retired so far, if no reader lags.
+    for (int i = 0; i < 3 && TryAdvanceEpoch(); ++i) {
+    }
+    uint64_t now = epoch_.load();
+    size_t kept = 0;
+    for (Retired& retired : retired_) {
+      if (retired.epoch + 3 > now) {
+        retired_[kept++] = std::move(retired);
+      }
+    }
+    retired_.resize(kept);
+    // A lagging reader can pin everything; back off rather than rescan the
+    // same nodes on every removal.
+    reclaim_at_ = std::max(kReclaimBatch, 2 * kept);
+  }
+
+  // Moves the epoch from e to e + 1 if no reader of e - 1 is left. Caller
+  // holds retired_mutex_.
+  bool TryAdvanceEpoch() {
+    uint64_t e = epoch_.load();
+    for (const ReaderShard& shard : readers_) {
+      if (shard.count[(e + 1) & 1].load() != 0) {
+        return false;
+      }
+    }
+    epoch_.store(e + 1);
+    return true;
+  }
+};
+
+#endif  // HASH_SET_SKIPLIST_H
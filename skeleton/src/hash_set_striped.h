@@ -1,34 +1,570 @@
 #ifndef HASH_SET_STRIPED_H
 #define HASH_SET_STRIPED_H
 
+#include <algorithm>  // std::lower_bound, std::max, std::min
+#include <atomic>     // std::atomic
+#include <bit>        // std::bit_ceil, std::bit_floor
 #include <cassert>
-#include <cstddef>     // size_t
-#include <functional>  // std::hash
-#include <mutex>       // std::mutex, std::scoped_lock
-#include <utility>     // std::move
-#include <vector>      // std::vector
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // std::hash
+#include <iterator>     // std::prev
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::mutex, std::unique_lock
+#include <optional>     // std::optional
+#include <string>       // std::string
+#include <type_traits>  // std::is_trivially_copyable_v
+#include <utility>      // std::move
+#include <vector>       // std::vector
 
+#include "src/batch_hash.h"
+#include "src/bucket.h"
+#include "src/bucket_array.h"
+#include "src/frozen_hash_set.h"
 #include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
+#include "src/snapshot.h"
+#include "src/wal.h"
 
-// Fixed number of mutexes (locks_), independent from the number of buckets.
-// Each bucket maps to a stripe: stripe = bucket % locks_.size().
-template <typename T>
+struct StripedOptions {
+  // Number of stripe locks; zero falls back to 64.
+  size_t stripes = 64;
+  // Serve repeated Contains calls from a per-thread direct-mapped cache. A hit
+  // costs one load of the stripe's version counter and no lock; writers bump
+  // that counter under the stripe lock, which invalidates cached results.
+  bool hot_key_cache = false;
+  // Re-stripe online from sampled lock contention: double the stripe count
+  // when some stripe's failed try_lock rate over a window is high, halve it
+  // once every stripe has seen quiet windows. The count stays a power of two
+  // within [min_stripes, max_stripes] (rounded inwards to powers of two) and
+  // does not depend on the table size.
+  bool adaptive_stripes = false;
+  size_t min_stripes = 4;
+  size_t max_stripes = 4096;
+  // Load factors and minimum table size.
+  HashSetParams params{};
+};
+
+// Stripe locks are independent from the number of buckets. Each bucket maps
+// to a stripe: stripe = bucket % stripe count. The stripe count is fixed
+// unless adaptive_stripes is set.
+template <typename T, typename Hash = std::hash<T>>
 class HashSetStriped : public HashSetBase<T> {
  public:
   explicit HashSetStriped(size_t initial_capacity, size_t stripes = 64)
-      : buckets_(
-            std::max<size_t>(NormalizeCapacity(initial_capacity), kMinBuckets)),
+      : HashSetStriped(initial_capacity, StripedOptions{.stripes = stripes}) {}
+
+  HashSetStriped(size_t initial_capacity, const StripedOptions& options)
+      : params_(options.params.Normalized()),
+        buckets_(NormalizeCapacity(initial_capacity)),
         size_(0),
-        locks_(stripes ? stripes : 64) {}  // avoid zero stripes
+        hot_key_cache_(kHotKeyCacheable && options.hot_key_cache),
+        owner_id_(next_owner_id_.fetch_add(1, std::memory_order_relaxed)),
+        adaptive_(options.adaptive_stripes),
+        min_stripes_(
+            std::bit_ceil(std::max<size_t>(options.min_stripes, 1))),
+        max_stripes_(
+            std::max(std::bit_floor(options.max_stripes), min_stripes_)),
+        cold_windows_(0),
+        requested_stripes_(0) {
+    size_t stripes = options.stripes ? options.stripes : 64;
+    if (adaptive_) {
+      stripes = std::clamp(std::bit_ceil(stripes), min_stripes_, max_stripes_);
+    }
+    stripe_generations_.push_back(std::make_unique<StripeArray>(stripes));
+    stripes_.store(stripe_generations_.back().get(), std::memory_order_release);
+  }
 
   // Insert using the corresponding stripe lock.
   bool Add(T elem) final {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h);
+  }
+
+  // Constructs the element from |args| and adds it as Add does.
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return Add(T(std::forward<Args>(args)...));
+  }
+
+  // Remove under the corresponding stripe lock.
+  bool Remove(T elem) final { return RemoveHashed(elem, hasher_(elem)); }
+
+  // Heterogeneous Remove: finds |key| without building a T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  bool Remove(const K& key) {
+    return RemoveHashed(key, hasher_(key));
+  }
+
+  // Lookup under the corresponding stripe lock, or from the hot-key cache.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // Heterogeneous Contains: looks |key| up under its stripe lock without
+  // building a T. Bypasses the hot-key cache, which stores T.
+  template <typename K>
+    requires HeterogeneousKey<Hash, T, K>
+  [[nodiscard]] bool Contains(const K& key) {
+    const std::atomic<uint64_t>* counter = nullptr;
+    uint64_t version = 0;
+    bool present = ContainsLocked(key, hasher_(key), counter, version);
+    MaybeRestripe();
+    return present;
+  }
+
+  // Atomic size is sufficient; stripe locks protect structural changes.
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Keys are hashed in bulk; each one then takes only its own stripe lock.
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Adds every element of elems[0, n) if none of them is present, and
+  // otherwise changes nothing. Other threads see all of them appear at
+  // once. Returns whether they were added.
+  bool AddAll(const T* elems, size_t n) {
+    std::vector<size_t> hashes = HashAll(elems, n);
+    bool added = Transaction(hashes, [&] {
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) != b.end()) {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) == b.end()) {  // Repeated in elems
+          LogOp(wal::Op::kAdd, elems[i]);
+          b.push_back(elems[i]);
+          size_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      return true;
+    });
+    if (added && LoadFactor() > params_.max_load_factor) {
+      Resize(buckets_.size() * 2);
+    }
+    MaybeRestripe();
+    return added;
+  }
+
+  // Removes every element of elems[0, n) if all of them are present, and
+  // otherwise changes nothing. Returns whether they were removed.
+  bool RemoveAll(const T* elems, size_t n) {
+    std::vector<size_t> hashes = HashAll(elems, n);
+    bool removed = Transaction(hashes, [&] {
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        if (bucket::Find(b, elems[i]) == b.end()) {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < n; ++i) {
+        auto& b = buckets_[IndexOfHash(hashes[i])];
+        auto it = bucket::Find(b, elems[i]);
+        if (it != b.end()) {  // Repeated in elems
+          LogOp(wal::Op::kRemove, elems[i]);
+          b.erase(it);
+          size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+      return true;
+    });
+    if (removed && LoadFactor() < params_.min_load_factor &&
+        buckets_.size() > params_.min_buckets) {
+      Resize(buckets_.size() / 2);
+    }
+    MaybeRestripe();
+    return removed;
+  }
+
+  // Replaces |from| with |to| if |from| is present and |to| is not, as one
+  // step. Returns whether it did.
+  bool Swap(const T& from, const T& to) {
+    std::vector<size_t> hashes = {hasher_(from), hasher_(to)};
+    bool swapped = Transaction(hashes, [&] {
+      auto& from_bucket = buckets_[IndexOfHash(hashes[0])];
+      auto& to_bucket = buckets_[IndexOfHash(hashes[1])];
+      auto it = bucket::Find(from_bucket, from);
+      if (it == from_bucket.end() ||
+          bucket::Find(to_bucket, to) != to_bucket.end()) {
+        return false;
+      }
+      LogOp(wal::Op::kRemove, from);
+      LogOp(wal::Op::kAdd, to);
+      from_bucket.erase(it);
+      to_bucket.push_back(to);
+      return true;
+    });
+    MaybeRestripe();
+    return swapped;
+  }
+
+  // Calls fn(elem) for every element while holding every stripe lock, so it
+  // sees a consistent snapshot. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+    StripeArray* stripes = stripes_.load(std::memory_order_acquire);
+    for (auto& stripe : stripes->state) {
+      stripe.lock.lock();
+    }
+    for (const auto& b : buckets_) {
+      for (const auto& v : b) {
+        fn(v);
+      }
+    }
+    for (auto& stripe : stripes->state) {
+      stripe.lock.unlock();
+    }
+  }
+
+  // Immutable copy of the current contents for a read-only phase; see
+  // FrozenHashSet. Integral T only.
+  [[nodiscard]] FrozenHashSet<T, Hash> Freeze(size_t threads = 0) {
+    return FrozenHashSet<T, Hash>::FromSet(*this, threads);
+  }
+
+  // Writes the elements to |path| grouped by this table's current buckets, so
+  // LoadSnapshot can copy them back bucket by bucket. See src/snapshot.h.
+  bool SaveSnapshot(const std::string& path) {
+    size_t buckets;
+    {
+      std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+      buckets = buckets_.size();
+    }
+    return snapshot::Save<T, Hash>(*this, path, buckets);
+  }
+
+  // Replaces the contents with the snapshot at |path|. Returns false, leaving
+  // the set unchanged, if the file is missing or fails validation.
+  bool LoadSnapshot(const std::string& path, size_t threads = 0) {
+    std::optional<snapshot::Image<T, Hash>> image =
+        snapshot::Image<T, Hash>::Open(path, /*verify=*/true, threads);
+    if (!image) {
+      return false;
+    }
+    LoadImage(*image, threads);
+    return true;
+  }
+
+  // Replaces the contents with |image|'s keys. The image's buckets become
+  // the table's buckets, and whole ranges of them are copied by |threads|
+  // threads with no per-key hashing or locking; the table is then resized
+  // if the image's load factor is outside this set's bounds.
+  void LoadImage(const snapshot::Image<T, Hash>& image, size_t threads = 0) {
+    BucketArray<std::vector<T>> new_buckets(image.BucketCount());
+    size_t workers = snapshot::ThreadCount(threads);
+    size_t chunk = (new_buckets.size() + workers - 1) / workers;
+    snapshot::ParallelFor(workers, [&](size_t t) {
+      size_t end = std::min(new_buckets.size(), (t + 1) * chunk);
+      for (size_t b = t * chunk; b < end; ++b) {
+        new_buckets[b].assign(image.BucketBegin(b), image.BucketEnd(b));
+      }
+    });
+
+    {
+      std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+      StripeArray* stripes = stripes_.load(std::memory_order_acquire);
+      for (auto& stripe : stripes->state) {
+        stripe.lock.lock();
+      }
+      buckets_.swap(new_buckets);
+      size_.store(image.Size(), std::memory_order_relaxed);
+      for (auto& stripe : stripes->state) {
+        BumpVersion(stripe);
+        stripe.lock.unlock();
+      }
+    }
+
+    size_t capacity = image.BucketCount();
+    while (static_cast<double>(image.Size()) / static_cast<double>(capacity) >
+           params_.max_load_factor) {
+      capacity *= 2;
+    }
+    Resize(capacity);  // No-op unless below min_buckets or over-full.
+  }
+
+  // Makes Add and Remove durable: recovers the snapshot and log segments
+  // under |prefix| into this set (see src/wal.h), then logs every later Add
+  // or Remove that changes the set. An operation is durable once the log's
+  // next group commit finishes, at most options.commit_interval after it
+  // returns, or when Sync returns. Call before sharing the set between
+  // threads, at most once. Bulk loads (LoadSnapshot, LoadImage) are not
+  // logged; call Checkpoint after them. Returns false if a file could not
+  // be read or the log could not be started.
+  bool OpenLog(const std::string& prefix, const wal::Options& options = {},
+               size_t threads = 0) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "the log stores keys as raw bytes");
+    wal::Files files = wal::Scan(prefix);
+    // Start from the newest snapshot that validates. Checkpoint keeps the
+    // one before it and the segments since, so a damaged newest snapshot
+    // costs a longer replay rather than the data. Without any usable
+    // snapshot, only a log that starts at LSN 0 holds the whole history.
+    uint64_t next = 0;
+    bool loaded = files.snapshots.empty();
+    for (auto it = files.snapshots.rbegin(); it != files.snapshots.rend();
+         ++it) {
+      if (LoadSnapshot(wal::SnapshotPath(prefix, *it), threads)) {
+        next = *it;
+        loaded = true;
+        break;
+      }
+    }
+    if (!loaded && (files.segments.empty() || files.segments.front() != 0)) {
+      return false;
+    }
+    // Segments before the snapshot's LSN are covered by it. Stop at the
+    // first gap: nothing after a torn commit was acknowledged as durable.
+    for (uint64_t start : files.segments) {
+      if (start < next) {
+        continue;
+      }
+      if (start > next) {
+        break;
+      }
+      next = wal::Replay<T>(prefix, start, [this](wal::Op op, const T& key) {
+        if (op == wal::Op::kAdd) {
+          Add(key);
+        } else {
+          Remove(key);
+        }
+      });
+    }
+    log_ = wal::Log<T>::Open(prefix, next, options);
+    return log_ != nullptr;
+  }
+
+  // Blocks until every logged operation that returned before the call is
+  // durable. Returns false if there is no log or it has failed to write.
+  bool Sync() { return log_ != nullptr && log_->Sync(); }
+
+  // Bounds recovery time: starts a new log segment, writes a snapshot, then
+  // removes the files older than the previous snapshot. That one and the
+  // segments after it stay, so OpenLog can fall back to them if the new
+  // snapshot turns out damaged. Writers keep running; operations that race
+  // with the snapshot are replayed from the new segment. Returns false if
+  // there is no log or a write failed, in which case the previous files are
+  // kept.
+  bool Checkpoint() {
+    if (log_ == nullptr) {
+      return false;
+    }
+    std::optional<uint64_t> lsn = log_->Rotate();
+    if (!lsn) {
+      return false;
+    }
+    // SaveSnapshot syncs the file and the directory before returning.
+    if (!SaveSnapshot(wal::SnapshotPath(log_->Prefix(), *lsn))) {
+      return false;
+    }
+    wal::Files files = wal::Scan(log_->Prefix());
+    auto previous = std::lower_bound(files.snapshots.begin(),
+                                     files.snapshots.end(), *lsn);
+    if (previous != files.snapshots.begin()) {
+      wal::RemoveBefore(log_->Prefix(), *std::prev(previous));
+    }
+    return true;
+  }
+
+  // The log started by OpenLog, or nullptr.
+  [[nodiscard]] const wal::Log<T>* WriteAheadLog() const { return log_.get(); }
+
+  // Current number of stripe locks.
+  [[nodiscard]] size_t StripeCount() const {
+    return stripes_.load(std::memory_order_acquire)->state.size();
+  }
+
+  // Stripe generations allocated so far: one per stripe count used.
+  [[nodiscard]] size_t StripeGenerationCount() {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+    return stripe_generations_.size();
+  }
+
+  struct HotKeyStats {
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  // Hot-key cache hits and misses of the calling thread, summed over every
+  // set of this type it has queried.
+  static HotKeyStats ThreadHotKeyStats() {
+    if constexpr (kHotKeyCacheable) {
+      return HotKeyCache().stats;
+    } else {
+      return HotKeyStats{};
+    }
+  }
+
+ private:
+  // Only keys that are cheap to copy and compare live in the cache.
+  static constexpr bool kHotKeyCacheable =
+      std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>;
+  static constexpr size_t kHotKeySlots = 4096;
+
+  // Adaptive striping samples each stripe over windows of this many
+  // acquisitions. A window with more than kHighContention of them failing
+  // try_lock asks for twice the stripes; one under kLowContention counts as
+  // quiet, and two quiet windows per stripe ask for half.
+  static constexpr uint64_t kContentionWindow = 1024;
+  static constexpr double kHighContention = 1.0 / 64;
+  static constexpr double kLowContention = 1.0 / 1024;
+
+  // One cache line per stripe, so neither the lock nor the counters falsely
+  // share with a neighbouring stripe.
+  struct alignas(64) StripeState {
+    std::mutex lock;
+    std::atomic<uint64_t> version{0};  // Bumped by writers for the cache
+    uint64_t acquisitions = 0;         // Sampling counters, guarded by lock
+    uint64_t contended = 0;
+  };
+
+  // One generation of stripes. Re-striping publishes the generation for the
+  // new count, reusing the one from an earlier visit to that count, so there
+  // are at most log2(max_stripes / min_stripes) + 1 of them. None is freed
+  // while the set lives: threads may still be blocked on an old one's locks,
+  // and hot-key cache entries point at its version counters. A thread that
+  // waited on a generation that is current again holds the right lock.
+  struct StripeArray {
+    explicit StripeArray(size_t n) : state(n) {}
+    std::vector<StripeState> state;
+  };
+
+  struct HotKeyEntry {
+    uint64_t owner = 0;  // owner_id_ of the set; 0 marks an empty slot
+    uint64_t version = 0;
+    const std::atomic<uint64_t>* counter = nullptr;  // Stripe version
+    T key{};
+    bool present = false;
+  };
+
+  struct HotKeyTable {
+    HotKeyEntry entries[kHotKeySlots];
+    HotKeyStats stats;
+  };
+
+  static HotKeyTable& HotKeyCache() {
+    thread_local HotKeyTable table;
+    return table;
+  }
+
+  static inline std::atomic<uint64_t> next_owner_id_{1};
+
+  const HashSetParams params_;
+  // Lazily backed, so a huge initial capacity costs nothing up front.
+  BucketArray<std::vector<T>> buckets_;
+  std::atomic<size_t> size_;  // Updated inside stripe CS; relaxed is OK
+  Hash hasher_;
+  std::atomic<StripeArray*> stripes_;  // Current generation
+  // Every generation so far, one per stripe count; under resize_mutex_.
+  std::vector<std::unique_ptr<StripeArray>> stripe_generations_;
+  std::mutex resize_mutex_;  // Protects resize and re-stripe operations
+  const bool hot_key_cache_;
+  const uint64_t owner_id_;  // Tags this set's entries in the hot-key caches
+  const bool adaptive_;
+  const size_t min_stripes_;
+  const size_t max_stripes_;
+  std::atomic<size_t> cold_windows_;       // Quiet windows since a busy one
+  std::atomic<size_t> requested_stripes_;  // Pending re-stripe target, or 0
+  // Set by OpenLog before the set is shared; destroyed first, so the writer
+  // thread stops before the set it logs for.
+  std::unique_ptr<wal::Log<T>> log_;
+
+  size_t NormalizeCapacity(size_t cap) const {
+    return std::max(cap, params_.min_buckets);
+  }
+
+  size_t IndexOfHash(size_t h) const { return h % buckets_.size(); }
+
+  // Approximate load factor; exactness not required for triggering resize.
+  double LoadFactor() const {
+    return static_cast<double>(size_.load(std::memory_order_relaxed)) /
+           static_cast<double>(buckets_.size());
+  }
+
+  // Locks the stripe guarding bucket |i| in the current generation. Returns
+  // nullptr, holding nothing, if a re-stripe replaced the generation while we
+  // waited; the caller retries.
+  StripeState* LockStripe(size_t i) {
+    StripeArray* stripes = stripes_.load(std::memory_order_acquire);
+    StripeState& stripe = stripes->state[i % stripes->state.size()];
+    if (!adaptive_) {
+      stripe.lock.lock();
+    } else {
+      if (!stripe.lock.try_lock()) {
+        stripe.lock.lock();
+        ++stripe.contended;
+      }
+      if (++stripe.acquisitions == kContentionWindow) {
+        SampleContention(stripe, stripes->state.size());
+      }
+    }
+    if (stripes_.load(std::memory_order_acquire) != stripes) {
+      stripe.lock.unlock();
+      return nullptr;
+    }
+    return &stripe;
+  }
+
+  // Caller holds stripe.lock, whose window of acquisitions just filled up.
+  void SampleContention(StripeState& stripe, size_t stripe_count) {
+    double rate = static_cast<double>(stripe.contended) /
+                  static_cast<double>(stripe.acquisitions);
+    stripe.acquisitions = 0;
+    stripe.contended = 0;
+    if (rate > kHighContention && stripe_count < max_stripes_) {
+      cold_windows_.store(0, std::memory_order_relaxed);
+      requested_stripes_.store(std::min(stripe_count * 2, max_stripes_),
+                               std::memory_order_relaxed);
+    } else if (rate < kLowContention && stripe_count > min_stripes_) {
+      if (cold_windows_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+          2 * stripe_count) {
+        cold_windows_.store(0, std::memory_order_relaxed);
+        requested_stripes_.store(std::max(stripe_count / 2, min_stripes_),
+                                 std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Called with no stripe lock held. The plain load keeps the common case
+  // free of writes to the shared request word.
+  void MaybeRestripe() {
+    if (adaptive_ && requested_stripes_.load(std::memory_order_relaxed) != 0) {
+      size_t target = requested_stripes_.exchange(0, std::memory_order_relaxed);
+      if (target != 0) {
+        Restripe(target);
+      }
+    }
+  }
+
+  bool AddHashed(T elem, size_t h) {
     while (true) {
       size_t cap = buckets_.size();
-      size_t i = Index(elem);
-      size_t stripe = StripeOfBucket(i);
+      size_t i = IndexOfHash(h);
 
-      std::unique_lock<std::mutex> lk(locks_[stripe]);
+      StripeState* stripe = LockStripe(i);
+      if (stripe == nullptr) {
+        continue;  // Re-striped while we waited.
+      }
+      std::unique_lock<std::mutex> lk(stripe->lock, std::adopt_lock);
 
       // Check if resize happened between computing index and acquiring lock.
       if (cap != buckets_.size()) {
@@ -36,28 +572,34 @@ class HashSetStriped : public HashSetBase<T> {
       }
 
       auto& b = buckets_[i];
-      if (std::find(b.begin(), b.end(), elem) != b.end()) {
+      if (bucket::Find(b, elem) != b.end()) {
         return false;
       }
+      LogOp(wal::Op::kAdd, elem);
       b.push_back(std::move(elem));
       size_.fetch_add(1, std::memory_order_relaxed);
+      BumpVersion(*stripe);
       break;
     }
 
-    if (LoadFactor() > kMaxLoadFactor) {
+    if (LoadFactor() > params_.max_load_factor) {
       Resize(buckets_.size() * 2);
     }
+    MaybeRestripe();
     return true;
   }
 
-  // Insert under the corresponding stripe lock.
-  bool Remove(T elem) final {
+  template <typename K>
+  bool RemoveHashed(const K& elem, size_t h) {
     while (true) {
       size_t cap = buckets_.size();
-      size_t i = Index(elem);
-      size_t stripe = StripeOfBucket(i);
+      size_t i = IndexOfHash(h);
 
-      std::unique_lock<std::mutex> lk(locks_[stripe]);
+      StripeState* stripe = LockStripe(i);
+      if (stripe == nullptr) {
+        continue;  // Re-striped while we waited.
+      }
+      std::unique_lock<std::mutex> lk(stripe->lock, std::adopt_lock);
 
       // Check if resize happened between computing index and acquiring lock.
       if (cap != buckets_.size()) {
@@ -65,86 +607,174 @@ class HashSetStriped : public HashSetBase<T> {
       }
 
       auto& b = buckets_[i];
-      auto it = std::find(b.begin(), b.end(), elem);
+      auto it = bucket::Find(b, elem);
       if (it == b.end()) {
         return false;
       }
+      LogOp(wal::Op::kRemove, *it);
       b.erase(it);
       size_.fetch_sub(1, std::memory_order_relaxed);
+      BumpVersion(*stripe);
       break;
     }
 
-    if (LoadFactor() < 1.0 && buckets_.size() > kMinBuckets) {
+    if (LoadFactor() < params_.min_load_factor &&
+        buckets_.size() > params_.min_buckets) {
       Resize(buckets_.size() / 2);
     }
+    MaybeRestripe();
     return true;
   }
 
-  // Insert under the corresponding stripe lock.
-  [[nodiscard]] bool Contains(T elem) final {
+  std::vector<size_t> HashAll(const T* elems, size_t n) const {
+    std::vector<size_t> hashes(n);
+    batch_hash::ForEachHashed(hasher_, elems, n,
+                              [&](size_t i, size_t h) { hashes[i] = h; });
+    return hashes;
+  }
+
+  // Runs fn() holding the stripe locks of every bucket the hashes map to.
+  // They are taken in ascending stripe order, the order Resize, Restripe
+  // and ForEach use, so transactions cannot deadlock with those or with
+  // each other. If fn returns true it changed the set, and the stripes'
+  // versions are bumped. Returns fn's result.
+  template <typename Fn>
+  bool Transaction(const std::vector<size_t>& hashes, Fn&& fn) {
+    std::vector<size_t> order;
+    order.reserve(hashes.size());
+    while (true) {
+      size_t cap = buckets_.size();
+      StripeArray* stripes = stripes_.load(std::memory_order_acquire);
+      size_t count = stripes->state.size();
+      order.clear();
+      for (size_t h : hashes) {
+        order.push_back(h % cap % count);
+      }
+      std::sort(order.begin(), order.end());
+      order.erase(std::unique(order.begin(), order.end()), order.end());
+      for (size_t s : order) {
+        stripes->state[s].lock.lock();
+      }
+
+      // Retry if a resize or re-stripe got in before we held every lock.
+      bool stale = stripes_.load(std::memory_order_acquire) != stripes ||
+                   cap != buckets_.size();
+      bool changed = !stale && fn();
+      for (size_t s : order) {
+        if (changed) {
+          BumpVersion(stripes->state[s]);
+        }
+        stripes->state[s].lock.unlock();
+      }
+      if (!stale) {
+        return changed;
+      }
+    }
+  }
+
+  bool ContainsHashed(const T& elem, size_t h) {
+    if constexpr (kHotKeyCacheable) {
+      if (hot_key_cache_) {
+        return ContainsCached(elem, h);
+      }
+    }
+    const std::atomic<uint64_t>* counter = nullptr;
+    uint64_t version = 0;
+    bool present = ContainsLocked(elem, h, counter, version);
+    MaybeRestripe();
+    return present;
+  }
+
+  // Reports the version counter of the stripe that was locked and, with the
+  // hot-key cache on, its value as read under the lock.
+  template <typename K>
+  bool ContainsLocked(const K& elem, size_t h,
+                      const std::atomic<uint64_t>*& counter,
+                      uint64_t& version) {
     while (true) {
       size_t cap = buckets_.size();
-      size_t i = Index(elem);
-      size_t stripe = StripeOfBucket(i);
+      size_t i = IndexOfHash(h);
 
-      std::unique_lock<std::mutex> lk(locks_[stripe]);
+      StripeState* stripe = LockStripe(i);
+      if (stripe == nullptr) {
+        continue;  // Re-striped while we waited.
+      }
+      std::unique_lock<std::mutex> lk(stripe->lock, std::adopt_lock);
 
       // Check if resize happened between computing index and acquiring lock.
       if (cap != buckets_.size()) {
         continue;
       }
 
+      counter = &stripe->version;
+      if (hot_key_cache_) {
+        version = stripe->version.load(std::memory_order_relaxed);
+      }
       auto& b = buckets_[i];
-      return std::find(b.begin(), b.end(), elem) != b.end();
+      return bucket::Find(b, elem) != b.end();
     }
   }
 
-  // Atomic size is sufficient; stripe locks protect structural changes.
-  [[nodiscard]] size_t Size() const final {
-    return size_.load(std::memory_order_relaxed);
-  }
-
- private:
-  std::vector<std::vector<T>> buckets_;
-  std::atomic<size_t> size_;  // Updated inside stripe CS; relaxed is OK
-  std::hash<T> hasher_;
-  std::vector<std::mutex> locks_;
-  std::mutex resize_mutex_;  // Protects resize operations
-
-  static constexpr size_t kMinBuckets = 4;
-  static constexpr double kMaxLoadFactor = 4.0;
+  // A cached result is valid while its stripe's version is unchanged: every
+  // write to the stripe, every resize and every re-stripe bumps the version.
+  bool ContainsCached(const T& elem, size_t h) {
+    HotKeyTable& cache = HotKeyCache();
+    HotKeyEntry& entry = cache.entries[h % kHotKeySlots];
+    if (entry.owner == owner_id_ && entry.key == elem &&
+        entry.counter->load(std::memory_order_acquire) == entry.version) {
+      ++cache.stats.hits;
+      return entry.present;
+    }
+    ++cache.stats.misses;
 
-  static size_t NormalizeCapacity(size_t cap) {
-    return cap == 0 ? kMinBuckets : cap;
+    const std::atomic<uint64_t>* counter = nullptr;
+    uint64_t version = 0;
+    bool present = ContainsLocked(elem, h, counter, version);
+    entry.owner = owner_id_;
+    entry.version = version;
+    entry.counter = counter;
+    entry.key = elem;
+    entry.present = present;
+    MaybeRestripe();
+    return present;
   }
 
-  size_t Index(const T& elem) const { return hasher_(elem) % buckets_.size(); }
-
-  // Map bucket to a stripe (lock index).
-  size_t StripeOfBucket(size_t b) const { return b % locks_.size(); }
+  // Caller holds the stripe lock of |elem|'s bucket, which orders the log
+  // records of each key the same way as the operations themselves.
+  void LogOp(wal::Op op, const T& elem) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      if (log_ != nullptr) {
+        log_->Append(op, elem);
+      }
+    }
+  }
 
-  // Approximate load factor; exactness not required for triggering resize.
-  double LoadFactor() const {
-    return static_cast<double>(size_.load(std::memory_order_relaxed)) /
-           static_cast<double>(buckets_.size());
+  // Caller holds stripe.lock and has just changed the stripe's contents.
+  void BumpVersion(StripeState& stripe) {
+    if (hot_key_cache_) {
+      stripe.version.store(stripe.version.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_release);
+    }
   }
 
   void Resize(size_t new_capacity) {
     std::unique_lock<std::mutex> resize_lock(resize_mutex_);
 
-    new_capacity = std::max(kMinBuckets, NormalizeCapacity(new_capacity));
+    new_capacity = NormalizeCapacity(new_capacity);
 
     // Check if another thread already resized.
     if (new_capacity == buckets_.size()) {
       return;
     }
 
-    // Acquire all stripe locks in order.
-    for (auto& lock : locks_) {
-      lock.lock();
+    // Acquire all stripe locks in order. The generation cannot change while
+    // we hold resize_mutex_.
+    StripeArray* stripes = stripes_.load(std::memory_order_acquire);
+    for (auto& stripe : stripes->state) {
+      stripe.lock.lock();
     }
 
-    std::vector<std::vector<T>> new_buckets(new_capacity);
+    BucketArray<std::vector<T>> new_buckets(new_capacity);
     for (auto& bucket : buckets_) {
       for (auto& v : bucket) {
         size_t i = hasher_(v) % new_capacity;
@@ -153,9 +783,49 @@ class HashSetStriped : public HashSetBase<T> {
     }
     buckets_.swap(new_buckets);
 
+    // Keys moved to other stripes, so no cached result can be trusted.
+    for (auto& stripe : stripes->state) {
+      BumpVersion(stripe);
+    }
+
     // Release all stripe locks.
-    for (auto& lock : locks_) {
-      lock.unlock();
+    for (auto& stripe : stripes->state) {
+      stripe.lock.unlock();
+    }
+  }
+
+  // Replaces the stripe locks with the generation of |new_count| stripes.
+  void Restripe(size_t new_count) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+
+    StripeArray* old_stripes = stripes_.load(std::memory_order_acquire);
+    if (new_count == old_stripes->state.size()) {
+      return;
+    }
+
+    // Holding every old lock drains all operations on the old generation.
+    for (auto& stripe : old_stripes->state) {
+      stripe.lock.lock();
+    }
+
+    StripeArray* new_stripes = nullptr;
+    for (const auto& generation : stripe_generations_) {
+      if (generation->state.size() == new_count) {
+        new_stripes = generation.get();
+      }
+    }
+    if (new_stripes == nullptr) {
+      stripe_generations_.push_back(std::make_unique<StripeArray>(new_count));
+      new_stripes = stripe_generations_.back().get();
+    }
+    stripes_.store(new_stripes, std::memory_order_release);
+
+    // Cached results point at old version counters; retire them all. The
+    // counters only grow, so results cached before an earlier switch away
+    // from the new generation stay retired too.
+    for (auto& stripe : old_stripes->state) {
+      BumpVersion(stripe);
+      stripe.lock.unlock();
     }
   }
 };
@@ -0,0 +1,455 @@
+#ifndef HASH_SET_TTL_H
+#define HASH_SET_TTL_H
+
+#include <time.h>  // clock_gettime
+
+#include <algorithm>           // std::max
+#include <atomic>              // std::atomic
+#include <chrono>              // std::chrono::steady_clock
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>             // size_t
+#include <cstdint>             // int64_t, uint64_t
+#include <functional>          // std::hash
+#include <iterator>            // std::make_move_iterator
+#include <mutex>               // std::mutex, std::unique_lock
+#include <thread>              // std::thread
+#include <utility>             // std::move
+#include <vector>              // std::vector
+
+#include "src/batch_hash.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_params.h"
+
+struct TtlOptions {
+  // Number of stripes, rounded up to a power of two.
+  size_t stripes = 64;
+  // Resolution of the timer wheels: entries are evicted within about one
+  // tick after they expire.
+  std::chrono::nanoseconds tick = std::chrono::milliseconds(1);
+  // Run a thread that evicts expired entries once per tick. Without it,
+  // call EvictExpired yourself.
+  bool background_eviction = true;
+  // Most entries one stripe evicts per pass, which bounds how long eviction
+  // holds a stripe lock. The rest wait for the next pass; being expired,
+  // they are already absent.
+  size_t max_evictions_per_pass = 1024;
+  // Load factors and minimum table size, per stripe.
+  HashSetParams params{};
+};
+
+// A concurrent set whose entries expire a fixed time after they are added.
+// Expired entries are absent to every operation at once; freeing them is
+// left to a background evictor.
+//
+// The low bits of the hash pick one of a fixed number of stripes. Each
+// stripe has its own lock, buckets and hierarchical timer wheel, so adding,
+// growing and evicting all happen under one stripe lock. Every Add that
+// stores an entry schedules a timer in its stripe's wheel. Once per tick
+// the evictor locks each stripe in turn and advances its wheel to the
+// current tick. That erases the entries whose timers came due, and it
+// cascades timers from coarser levels into finer ones.
+//
+// A timer is a copy of the key and its expiry time. Removing or re-adding
+// a key leaves its old timer in the wheel. When that timer comes due, it
+// finds no entry with its expiry time and is dropped, so the timers never
+// have to be looked up or cancelled.
+template <typename T, typename Hash = std::hash<T>>
+class HashSetTtl : public HashSetBase<T> {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  HashSetTtl(size_t initial_capacity, std::chrono::nanoseconds ttl,
+             const TtlOptions& options = TtlOptions{})
+      : params_(options.params.Normalized()),
+        ttl_(ttl.count()),
+        tick_(std::max<int64_t>(options.tick.count(), 1)),
+        max_evictions_(std::max<size_t>(options.max_evictions_per_pass, 1)),
+        stripes_(RoundUpToPowerOfTwo(options.stripes)),
+        stripe_mask_(stripes_.size() - 1),
+        stripe_shift_(Log2(stripes_.size())) {
+    size_t per_stripe = std::max(initial_capacity / stripes_.size(),
+                                 params_.min_buckets);
+    uint64_t now_tick = TickOf(NowNanos());
+    for (auto& stripe : stripes_) {
+      stripe.buckets.resize(per_stripe);
+      stripe.wheel_tick = now_tick;
+    }
+    if (options.background_eviction) {
+      evictor_ = std::thread([this] { RunEvictor(); });
+    }
+  }
+
+  ~HashSetTtl() override {
+    if (evictor_.joinable()) {
+      {
+        std::unique_lock<std::mutex> lk(evictor_mutex_);
+        stop_ = true;
+      }
+      evictor_wake_.notify_one();
+      evictor_.join();
+    }
+  }
+
+  HashSetTtl(const HashSetTtl&) = delete;
+  HashSetTtl& operator=(const HashSetTtl&) = delete;
+
+  // Adds |elem| to live for the set's TTL. Returns false, leaving its expiry
+  // alone, if it is present and unexpired.
+  bool Add(T elem) final { return AddFor(std::move(elem), ttl_); }
+
+  // Adds |elem| to live for |ttl| instead of the set's TTL.
+  bool Add(T elem, std::chrono::nanoseconds ttl) {
+    return AddFor(std::move(elem), ttl.count());
+  }
+
+  // Removes |elem| if it is present and unexpired.
+  bool Remove(T elem) final {
+    size_t h = hasher_(elem);
+    Stripe& stripe = StripeOf(h);
+    std::unique_lock<std::mutex> lk(stripe.lock);
+    auto& b = stripe.buckets[BucketOf(stripe, h)];
+    for (size_t i = 0; i < b.size(); ++i) {
+      if (b[i].key == elem) {
+        bool live = b[i].expires > NowNanos();
+        EraseAt(stripe, b, i);
+        return live;
+      }
+    }
+    return false;
+  }
+
+  // An expired entry is absent even before it has been evicted.
+  [[nodiscard]] bool Contains(T elem) final {
+    return ContainsHashed(elem, hasher_(elem));
+  }
+
+  // Entries not yet evicted, which includes those that expired within about
+  // the last tick (or since the last EvictExpired, without the evictor).
+  [[nodiscard]] size_t Size() const final {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  size_t AddBatch(const T* elems, size_t n) final {
+    size_t added = 0;
+    int64_t now = NowNanos();
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      if (AddHashed(elems[i], h, now, ttl_)) {
+        ++added;
+      }
+    });
+    return added;
+  }
+
+  void ContainsBatch(const T* elems, size_t n, bool* results) final {
+    batch_hash::ForEachHashed(hasher_, elems, n, [&](size_t i, size_t h) {
+      results[i] = ContainsHashed(elems[i], h);
+    });
+  }
+
+  // Calls fn(elem) for every unexpired element, one stripe at a time under
+  // that stripe's lock. fn must not call back into the set.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    int64_t now = NowNanos();
+    for (auto& stripe : stripes_) {
+      std::unique_lock<std::mutex> lk(stripe.lock);
+      for (const auto& b : stripe.buckets) {
+        for (const auto& entry : b) {
+          if (entry.expires > now) {
+            fn(entry.key);
+          }
+        }
+      }
+    }
+  }
+
+  // Advances every stripe's timer wheel to now, evicting what has expired.
+  // Returns how many entries were evicted. The background evictor calls
+  // this once per tick.
+  size_t EvictExpired() {
+    int64_t cpu_begin = ThreadCpuNanos();
+    // Only ticks that have wholly passed: a slot holds timers up to the end
+    // of its tick, and running it early would evict live entries.
+    uint64_t now_tick =
+        static_cast<uint64_t>(std::max<int64_t>(NowNanos(), 0) / tick_);
+    size_t evicted = 0;
+    std::chrono::nanoseconds longest_hold{0};
+    for (auto& stripe : stripes_) {
+      auto hold_begin = Clock::now();
+      std::unique_lock<std::mutex> lk(stripe.lock);
+      evicted += Advance(stripe, now_tick);
+      lk.unlock();
+      longest_hold = std::max(longest_hold, std::chrono::nanoseconds(
+                                                Clock::now() - hold_begin));
+    }
+    std::unique_lock<std::mutex> lk(stats_mutex_);
+    stats_.evicted += evicted;
+    stats_.passes += 1;
+    stats_.cpu += std::chrono::nanoseconds(ThreadCpuNanos() - cpu_begin);
+    stats_.longest_hold = std::max(stats_.longest_hold, longest_hold);
+    return evicted;
+  }
+
+  struct EvictionStats {
+    size_t evicted = 0;
+    size_t passes = 0;
+    std::chrono::nanoseconds cpu{0};  // CPU time spent in EvictExpired
+    // Longest time one pass spent on one stripe, lock wait included: the
+    // most eviction can have delayed an operation on that stripe.
+    std::chrono::nanoseconds longest_hold{0};
+  };
+
+  [[nodiscard]] EvictionStats Stats() {
+    std::unique_lock<std::mutex> lk(stats_mutex_);
+    return stats_;
+  }
+
+ private:
+  // Each wheel has kLevels levels of kSlots slots. A slot on level l covers
+  // kSlots^l ticks, so four levels of 64 reach 2^24 ticks (4.6 hours at
+  // 1 ms). Timers further out wait in the last level and are rescheduled
+  // when it comes round.
+  static constexpr size_t kSlotBits = 6;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+  static constexpr size_t kLevels = 4;
+
+  struct Entry {
+    T key;
+    int64_t expires;  // Steady-clock nanoseconds
+  };
+
+  struct Timer {
+    T key;
+    size_t hash;
+    int64_t expires;  // Matches the entry it was scheduled for
+  };
+
+  struct alignas(64) Stripe {
+    std::mutex lock;
+    std::vector<std::vector<Entry>> buckets;
+    size_t size = 0;  // Entries not yet evicted, guarded by lock
+    uint64_t wheel_tick = 0;  // Every slot before this tick has been run
+    std::vector<Timer> wheel[kLevels][kSlots];
+  };
+
+  const HashSetParams params_;
+  const int64_t ttl_;   // Nanoseconds
+  const int64_t tick_;  // Nanoseconds
+  const size_t max_evictions_;
+  std::vector<Stripe> stripes_;
+  const size_t stripe_mask_;
+  const size_t stripe_shift_;
+  std::atomic<size_t> size_{0};
+  Hash hasher_;
+
+  std::mutex stats_mutex_;
+  EvictionStats stats_;
+
+  std::thread evictor_;
+  std::mutex evictor_mutex_;
+  std::condition_variable evictor_wake_;
+  bool stop_ = false;
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  static size_t Log2(size_t n) {
+    size_t log = 0;
+    while ((size_t{1} << log) < n) {
+      ++log;
+    }
+    return log;
+  }
+
+  static int64_t ThreadCpuNanos() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+  }
+
+  static int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+  }
+
+  // The first tick at or after |nanos|, so a timer never fires early.
+  uint64_t TickOf(int64_t nanos) const {
+    return static_cast<uint64_t>((std::max<int64_t>(nanos, 0) + tick_ - 1) /
+                                 tick_);
+  }
+
+  Stripe& StripeOf(size_t h) { return stripes_[h & stripe_mask_]; }
+
+  size_t BucketOf(const Stripe& stripe, size_t h) const {
+    return (h >> stripe_shift_) % stripe.buckets.size();
+  }
+
+  bool AddFor(T elem, int64_t ttl) {
+    size_t h = hasher_(elem);
+    return AddHashed(std::move(elem), h, NowNanos(), ttl);
+  }
+
+  bool AddHashed(T elem, size_t h, int64_t now, int64_t ttl) {
+    Stripe& stripe = StripeOf(h);
+    std::unique_lock<std::mutex> lk(stripe.lock);
+    int64_t expires = now + ttl;
+    auto& b = stripe.buckets[BucketOf(stripe, h)];
+    for (auto& entry : b) {
+      if (entry.key == elem) {
+        if (entry.expires > now) {
+          return false;
+        }
+        // Expired but not yet evicted: revive it. Its old timer no longer
+        // matches and will be dropped.
+        entry.expires = expires;
+        Schedule(stripe, Timer{std::move(elem), h, expires});
+        return true;
+      }
+    }
+    b.push_back(Entry{elem, expires});
+    Schedule(stripe, Timer{std::move(elem), h, expires});
+    ++stripe.size;
+    size_.fetch_add(1, std::memory_order_relaxed);
+    if (static_cast<double>(stripe.size) >
+        params_.max_load_factor * static_cast<double>(stripe.buckets.size())) {
+      Grow(stripe);
+    }
+    return true;
+  }
+
+  bool ContainsHashed(const T& elem, size_t h) {
+    Stripe& stripe = StripeOf(h);
+    std::unique_lock<std::mutex> lk(stripe.lock);
+    for (const auto& entry : stripe.buckets[BucketOf(stripe, h)]) {
+      if (entry.key == elem) {
+        return entry.expires > NowNanos();
+      }
+    }
+    return false;
+  }
+
+  // Caller holds stripe.lock.
+  void EraseAt(Stripe& stripe, std::vector<Entry>& b, size_t i) {
+    b[i] = std::move(b.back());
+    b.pop_back();
+    --stripe.size;
+    size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Caller holds stripe.lock.
+  void Grow(Stripe& stripe) {
+    std::vector<std::vector<Entry>> new_buckets(stripe.buckets.size() * 2);
+    for (auto& b : stripe.buckets) {
+      for (auto& entry : b) {
+        size_t h = hasher_(entry.key);
+        new_buckets[(h >> stripe_shift_) % new_buckets.size()].push_back(
+            std::move(entry));
+      }
+    }
+    stripe.buckets.swap(new_buckets);
+  }
+
+  // Puts |timer| in the finest level whose range reaches its tick. Caller
+  // holds stripe.lock.
+  void Schedule(Stripe& stripe, Timer timer) {
+    uint64_t tick = std::max(TickOf(timer.expires), stripe.wheel_tick);
+    uint64_t delta = tick - stripe.wheel_tick;
+    size_t level = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t{1} << ((level + 1) *
+                                                             kSlotBits))) {
+      ++level;
+    }
+    uint64_t reach = uint64_t{1} << (kLevels * kSlotBits);
+    if (delta >= reach) {
+      tick = stripe.wheel_tick + reach - 1;  // Rescheduled when it comes due
+    }
+    size_t slot = (tick >> (level * kSlotBits)) & (kSlots - 1);
+    stripe.wheel[level][slot].push_back(std::move(timer));
+  }
+
+  // Runs the wheel's level-0 slots up to and including |now_tick|. Each
+  // slot's timers either evict their entry or, if it expires later (a far
+  // timer), are rescheduled. Whenever level 0 wraps, the next slot of
+  // level 1 is cascaded down, and so on up the levels. Stops early, leaving
+  // the current slot's remaining timers in place, once max_evictions_ have
+  // been evicted. Caller holds stripe.lock. Returns how many were evicted.
+  size_t Advance(Stripe& stripe, uint64_t now_tick) {
+    size_t evicted = 0;
+    std::vector<Timer> due;
+    while (stripe.wheel_tick <= now_tick) {
+      uint64_t tick = stripe.wheel_tick;
+      auto& slot_timers = stripe.wheel[0][tick & (kSlots - 1)];
+      due.swap(slot_timers);
+      for (size_t i = 0; i < due.size(); ++i) {
+        if (evicted == max_evictions_) {
+          // Anything rescheduled went to later slots, so the slot only
+          // holds what we put back.
+          auto rest = due.begin() + static_cast<std::ptrdiff_t>(i);
+          slot_timers.assign(std::make_move_iterator(rest),
+                             std::make_move_iterator(due.end()));
+          return evicted;
+        }
+        if (TickOf(due[i].expires) > tick) {
+          Schedule(stripe, std::move(due[i]));
+        } else {
+          evicted += Expire(stripe, due[i]);
+        }
+      }
+      due.clear();
+      stripe.wheel_tick = tick + 1;
+
+      // Cascade: entering a new level-l period moves its slot down a level.
+      for (size_t level = 1; level < kLevels; ++level) {
+        uint64_t next = stripe.wheel_tick;
+        if ((next & ((uint64_t{1} << (level * kSlotBits)) - 1)) != 0) {
+          break;
+        }
+        size_t slot = (next >> (level * kSlotBits)) & (kSlots - 1);
+        due.swap(stripe.wheel[level][slot]);
+        for (Timer& timer : due) {
+          Schedule(stripe, std::move(timer));
+        }
+        due.clear();
+      }
+    }
+    return evicted;
+  }
+
+  // Erases the timer's entry if it is still the one the timer was scheduled
+  // for. Caller holds stripe.lock.
+  size_t Expire(Stripe& stripe, const Timer& timer) {
+    auto& b = stripe.buckets[BucketOf(stripe, timer.hash)];
+    for (size_t i = 0; i < b.size(); ++i) {
+      if (b[i].key == timer.key) {
+        if (b[i].expires != timer.expires) {
+          return 0;  // Re-added since; a later timer owns it
+        }
+        EraseAt(stripe, b, i);
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  void RunEvictor() {
+    std::unique_lock<std::mutex> lk(evictor_mutex_);
+    while (!stop_) {
+      evictor_wake_.wait_for(lk, std::chrono::nanoseconds(tick_),
+                             [this] { return stop_; });
+      if (stop_) {
+        break;
+      }
+      lk.unlock();
+      EvictExpired();
+      lk.lock();
+    }
+  }
+};
+
+#endif  // HASH_SET_TTL_H
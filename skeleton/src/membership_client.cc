@@ -0,0 +1,244 @@
+#include <sys/socket.h>  // socket, connect, shutdown
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // close, read, write
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "src/membership_protocol.h"
+
+// Load generator for membership_server. Each connection runs on its own
+// thread and sends windows of |pipeline_depth| requests (80% Contains, 10%
+// Add, 10% Remove) without waiting, then reads the window's answers. Every
+// connection works on its own keys and mirrors them locally, so each answer
+// is checked; a connection first clears its keys left over from earlier
+// runs. Reports throughput and percentiles of the window round trip. First
+// checks that a client which shuts down its sending side still gets every
+// answer.
+
+namespace {
+
+int Connect(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  // The server may still be starting up.
+  for (int attempt = 0; attempt < 50; ++attempt) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr),
+                  sizeof(addr)) == 0) {
+      return fd;
+    }
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  return -1;
+}
+
+bool WriteAll(int fd, const uint8_t* data, size_t bytes) {
+  while (bytes > 0) {
+    ssize_t n = ::write(fd, data, bytes);
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool ReadAll(int fd, uint8_t* data, size_t bytes) {
+  while (bytes > 0) {
+    ssize_t n = ::read(fd, data, bytes);
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Sends a batch of Contains whose answers outgrow the socket buffer, shuts
+// down the sending side without reading, then expects every answer followed
+// by end of stream: the server must finish answering a half-closed client.
+// The keys belong to no connection, so every answer is kFalse.
+bool HalfCloseGetsAnswers(const std::string& path) {
+  constexpr size_t kRequests = 512 * 1024;
+  int fd = Connect(path);
+  if (fd < 0) {
+    return false;
+  }
+  std::vector<uint8_t> requests(kRequests * membership::kRequestBytes);
+  for (size_t i = 0; i < kRequests; ++i) {
+    membership::EncodeRequest(membership::Op::kContains, ~uint64_t{0} - i,
+                              requests.data() + i * membership::kRequestBytes);
+  }
+  std::vector<uint8_t> answers(kRequests);
+  uint8_t extra = 0;
+  bool ok = WriteAll(fd, requests.data(), requests.size()) &&
+            ::shutdown(fd, SHUT_WR) == 0;
+  // Let the server read end of input while answers are still queued.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ok = ok && ReadAll(fd, answers.data(), answers.size()) &&
+       ::read(fd, &extra, 1) == 0 &&
+       std::all_of(answers.begin(), answers.end(),
+                   [](uint8_t a) { return a == membership::kFalse; });
+  ::close(fd);
+  return ok;
+}
+
+struct ClientResult {
+  bool ok = false;
+  std::vector<double> window_micros;
+};
+
+// Keys of connection |id| are id << 32 plus an offset below kKeysPerClient.
+constexpr uint64_t kKeysPerClient = 4096;
+
+ClientResult RunClient(const std::string& path, size_t id, size_t requests,
+                       size_t depth) {
+  ClientResult result;
+  int fd = Connect(path);
+  if (fd < 0) {
+    return result;
+  }
+  // Start from an empty key range, whatever earlier clients left behind.
+  std::vector<uint8_t> reset(kKeysPerClient * membership::kRequestBytes);
+  for (uint64_t k = 0; k < kKeysPerClient; ++k) {
+    membership::EncodeRequest(membership::Op::kRemove, (uint64_t{id} << 32) + k,
+                              reset.data() + k * membership::kRequestBytes);
+  }
+  std::vector<uint8_t> ignored(kKeysPerClient);
+  if (!WriteAll(fd, reset.data(), reset.size()) ||
+      !ReadAll(fd, ignored.data(), ignored.size())) {
+    ::close(fd);
+    return result;
+  }
+
+  std::mt19937_64 engine(id + 1);
+  std::uniform_int_distribution<uint64_t> offset(0, kKeysPerClient - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::unordered_set<uint64_t> mirror;
+  std::vector<uint8_t> out(depth * membership::kRequestBytes);
+  std::vector<uint8_t> expected(depth);
+  std::vector<uint8_t> answers(depth);
+  result.window_micros.reserve(requests / depth + 1);
+
+  for (size_t sent = 0; sent < requests;) {
+    size_t n = std::min(depth, requests - sent);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t key = (uint64_t{id} << 32) + offset(engine);
+      int p = percent(engine);
+      membership::Op op = p < 10   ? membership::Op::kAdd
+                          : p < 20 ? membership::Op::kRemove
+                                   : membership::Op::kContains;
+      bool answer = false;
+      if (op == membership::Op::kAdd) {
+        answer = mirror.insert(key).second;
+      } else if (op == membership::Op::kRemove) {
+        answer = mirror.erase(key) != 0;
+      } else {
+        answer = mirror.count(key) != 0;
+      }
+      expected[i] = answer ? membership::kTrue : membership::kFalse;
+      membership::EncodeRequest(op, key,
+                                out.data() + i * membership::kRequestBytes);
+    }
+    auto begin_time = std::chrono::steady_clock::now();
+    if (!WriteAll(fd, out.data(), n * membership::kRequestBytes) ||
+        !ReadAll(fd, answers.data(), n)) {
+      ::close(fd);
+      return result;
+    }
+    auto end_time = std::chrono::steady_clock::now();
+    result.window_micros.push_back(
+        std::chrono::duration<double, std::micro>(end_time - begin_time)
+            .count());
+    if (std::memcmp(answers.data(), expected.data(), n) != 0) {
+      ::close(fd);
+      return result;
+    }
+    sent += n;
+  }
+  ::close(fd);
+  result.ok = true;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " socket_path num_connections requests_per_connection"
+                 " pipeline_depth"
+              << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+  size_t num_connections = std::stoul(std::string(argv[2]));
+  size_t requests = std::stoul(std::string(argv[3]));
+  size_t depth = std::max<size_t>(std::stoul(std::string(argv[4])), 1);
+
+  if (!HalfCloseGetsAnswers(path)) {
+    std::cerr << argv[0] << " failed: answers lost after a half-close"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<ClientResult> results(num_connections);
+  std::vector<std::thread> threads;
+  threads.reserve(num_connections);
+  auto begin_time = std::chrono::steady_clock::now();
+  for (size_t c = 0; c < num_connections; c++) {
+    threads.emplace_back([&results, &path, c, requests, depth] {
+      results[c] = RunClient(path, c, requests, depth);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end_time = std::chrono::steady_clock::now();
+
+  std::vector<double> windows;
+  for (const ClientResult& r : results) {
+    if (!r.ok) {
+      std::cerr << argv[0] << " failed: lost connection or wrong answer"
+                << std::endl;
+      return 1;
+    }
+    windows.insert(windows.end(), r.window_micros.begin(),
+                   r.window_micros.end());
+  }
+  std::sort(windows.begin(), windows.end());
+  auto percentile = [&windows](double p) {
+    size_t i = static_cast<size_t>(p * static_cast<double>(windows.size()));
+    return windows.empty() ? 0.0 : windows[std::min(i, windows.size() - 1)];
+  };
+  double micros =
+      std::chrono::duration<double, std::micro>(end_time - begin_time).count();
+  std::cout << num_connections << " connections, pipeline depth " << depth
+            << ": "
+            << static_cast<double>(num_connections * requests) / micros
+            << " M requests/s" << std::endl;
+  std::cout << "Window round trip (us): p50 " << percentile(0.50) << ", p99 "
+            << percentile(0.99) << ", p99.9 " << percentile(0.999) << ", max "
+            << (windows.empty() ? 0.0 : windows.back()) << std::endl;
+  return 0;
+}
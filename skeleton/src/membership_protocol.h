@@ -0,0 +1,46 @@
+#ifndef MEMBERSHIP_PROTOCOL_H
+#define MEMBERSHIP_PROTOCOL_H
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint64_t
+
+// Wire format of the membership service (membership_server), simple enough
+// to speak from any language over a Unix stream socket.
+//
+// A request is kRequestBytes bytes: one opcode byte, then the 64-bit key in
+// little-endian order. The server answers every request with one byte, in
+// request order: kTrue or kFalse with the result of the set operation, or
+// kBadRequest for an unknown opcode, after which it closes the connection.
+//
+// Clients may pipeline: send any number of requests without waiting for
+// the answers. The server handles everything that has arrived before
+// replying, so the answers to a pipelined run come back in as few writes
+// as the socket allows.
+namespace membership {
+
+enum class Op : uint8_t { kAdd = 1, kRemove = 2, kContains = 3 };
+
+inline constexpr size_t kRequestBytes = 9;
+
+inline constexpr uint8_t kFalse = 0;
+inline constexpr uint8_t kTrue = 1;
+inline constexpr uint8_t kBadRequest = 0xff;
+
+inline void EncodeRequest(Op op, uint64_t key, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(op);
+  for (size_t i = 0; i < 8; ++i) {
+    out[1 + i] = static_cast<uint8_t>(key >> (8 * i));
+  }
+}
+
+inline uint64_t DecodeKey(const uint8_t* request) {
+  uint64_t key = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    key |= uint64_t{request[1 + i]} << (8 * i);
+  }
+  return key;
+}
+
+}  // namespace membership
+
+#endif  // MEMBERSHIP_PROTOCOL_H
@@ -0,0 +1,336 @@
+#include <fcntl.h>       // fcntl
+#include <signal.h>      // sigaction
+#include <sys/epoll.h>   // epoll_*
+#include <sys/socket.h>  // socket, bind, listen, accept4
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // close, read, write, unlink
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "src/hash_set_base.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_striped.h"
+#include "src/membership_protocol.h"
+
+// Serves Add/Remove/Contains of one shared set over a Unix domain socket,
+// speaking the protocol in src/membership_protocol.h. Each event loop has its
+// own epoll instance and waits on the listening socket with EPOLLEXCLUSIVE,
+// so a new connection wakes one loop, which then owns it for its lifetime.
+// Runs until SIGINT or SIGTERM.
+
+namespace {
+
+std::atomic<bool> stop{false};
+
+void OnSignal(int) { stop.store(true); }
+
+// Stop reading from a client whose answers pile up faster than it reads
+// them; resume once they have drained.
+constexpr size_t kMaxPendingOutput = 1 << 20;
+constexpr size_t kReadChunk = 64 * 1024;
+
+struct Connection {
+  int fd;
+  std::vector<uint8_t> in;  // Bytes of requests not yet complete
+  std::vector<uint8_t> out;
+  size_t out_begin = 0;  // out[out_begin, end) is still to be written
+  bool closing = false;  // Close once out has drained
+};
+
+class EventLoop {
+ public:
+  EventLoop(int listen_fd, HashSetBase<uint64_t>& hash_set)
+      : listen_fd_(listen_fd), hash_set_(hash_set) {}
+
+  ~EventLoop() {
+    for (auto& [fd, conn] : connections_) {
+      ::close(fd);
+    }
+    if (epoll_fd_ >= 0) {
+      ::close(epoll_fd_);
+    }
+  }
+
+  bool Init() {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.ptr = nullptr;  // Marks the listening socket
+    return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev) == 0;
+  }
+
+  void Run() {
+    epoll_event events[64];
+    while (!stop.load(std::memory_order_relaxed)) {
+      int n = ::epoll_wait(epoll_fd_, events, 64, 100);
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.ptr == nullptr) {
+          Accept();
+          continue;
+        }
+        auto* conn = static_cast<Connection*>(events[i].data.ptr);
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+          Close(conn);
+          continue;
+        }
+        if (events[i].events & EPOLLIN) {
+          if (!Read(conn)) {
+            Close(conn);
+            continue;
+          }
+        }
+        if (!Flush(conn)) {
+          Close(conn);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] uint64_t Requests() const { return requests_; }
+
+ private:
+  int listen_fd_;
+  HashSetBase<uint64_t>& hash_set_;
+  int epoll_fd_ = -1;
+  std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+  uint64_t requests_ = 0;
+  // Scratch space for runs of Contains, answered with one ContainsBatch.
+  std::vector<uint64_t> keys_;
+  std::unique_ptr<bool[]> results_;
+  size_t results_capacity_ = 0;
+
+  void Accept() {
+    while (true) {
+      int fd = ::accept4(listen_fd_, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        return;  // EAGAIN, or another loop took it
+      }
+      auto conn = std::make_unique<Connection>();
+      conn->fd = fd;
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ev.data.ptr = conn.get();
+      if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        ::close(fd);
+        continue;
+      }
+      connections_[fd] = std::move(conn);
+    }
+  }
+
+  void Close(Connection* conn) {
+    int fd = conn->fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+  }
+
+  // Reads what has arrived, up to one chunk so that a busy client cannot
+  // starve the others, and answers every complete request. A client that
+  // shuts down its side after its last request still gets every answer:
+  // end of input only marks the connection closing, and Flush closes it
+  // once they are written. Returns false on a read error.
+  bool Read(Connection* conn) {
+    size_t have = conn->in.size();
+    conn->in.resize(have + kReadChunk);
+    ssize_t n = ::read(conn->fd, conn->in.data() + have, kReadChunk);
+    if (n <= 0) {
+      conn->in.resize(have);
+      if (n == 0) {
+        conn->closing = true;
+        return true;
+      }
+      return errno == EAGAIN || errno == EINTR;
+    }
+    conn->in.resize(have + static_cast<size_t>(n));
+
+    size_t complete =
+        conn->in.size() / membership::kRequestBytes * membership::kRequestBytes;
+    size_t used = Handle(conn, conn->in.data(), complete);
+    conn->in.erase(conn->in.begin(),
+                   conn->in.begin() + static_cast<std::ptrdiff_t>(used));
+    return true;
+  }
+
+  // Answers the requests in data[0, bytes) into conn->out. Returns how many
+  // bytes were consumed, which is fewer after a bad request.
+  size_t Handle(Connection* conn, const uint8_t* data, size_t bytes) {
+    size_t count = bytes / membership::kRequestBytes;
+    size_t i = 0;
+    while (i < count && !conn->closing) {
+      const uint8_t* request = data + i * membership::kRequestBytes;
+      auto op = static_cast<membership::Op>(request[0]);
+      if (op == membership::Op::kContains) {
+        i += ContainsRun(conn, data, i, count);
+        continue;
+      }
+      uint64_t key = membership::DecodeKey(request);
+      uint8_t answer = membership::kBadRequest;
+      if (op == membership::Op::kAdd) {
+        answer = hash_set_.Add(key) ? membership::kTrue : membership::kFalse;
+      } else if (op == membership::Op::kRemove) {
+        answer = hash_set_.Remove(key) ? membership::kTrue : membership::kFalse;
+      } else {
+        conn->closing = true;
+      }
+      conn->out.push_back(answer);
+      ++i;
+    }
+    requests_ += i;
+    return i * membership::kRequestBytes;
+  }
+
+  // Answers the run of Contains requests starting at |first| with one
+  // ContainsBatch. Returns the length of the run.
+  size_t ContainsRun(Connection* conn, const uint8_t* data, size_t first,
+                     size_t count) {
+    keys_.clear();
+    for (size_t i = first; i < count; ++i) {
+      const uint8_t* request = data + i * membership::kRequestBytes;
+      if (request[0] != static_cast<uint8_t>(membership::Op::kContains)) {
+        break;
+      }
+      keys_.push_back(membership::DecodeKey(request));
+    }
+    if (keys_.size() > results_capacity_) {
+      results_capacity_ = keys_.size();
+      results_ = std::make_unique<bool[]>(results_capacity_);
+    }
+    hash_set_.ContainsBatch(keys_.data(), keys_.size(), results_.get());
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      conn->out.push_back(results_[i] ? membership::kTrue : membership::kFalse);
+    }
+    return keys_.size();
+  }
+
+  // Writes as much pending output as the socket takes, then adjusts the
+  // events we wait for. Returns false if the connection should be closed.
+  bool Flush(Connection* conn) {
+    while (conn->out_begin < conn->out.size()) {
+      ssize_t n = ::write(conn->fd, conn->out.data() + conn->out_begin,
+                          conn->out.size() - conn->out_begin);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN) {
+          return false;
+        }
+        break;
+      }
+      conn->out_begin += static_cast<size_t>(n);
+    }
+    size_t pending = conn->out.size() - conn->out_begin;
+    if (pending == 0) {
+      conn->out.clear();
+      conn->out_begin = 0;
+      if (conn->closing) {
+        return false;
+      }
+    }
+
+    bool reading = pending < kMaxPendingOutput && !conn->closing;
+    uint32_t events = (reading ? EPOLLIN : 0u) | (pending > 0 ? EPOLLOUT : 0u);
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = conn;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn->fd, &ev);
+    return true;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " socket_path striped|refinable num_loops (0: one per core)"
+              << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+  std::string set_type = argv[2];
+  size_t num_loops = std::stoul(std::string(argv[3]));
+  if (num_loops == 0) {
+    num_loops = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  std::unique_ptr<HashSetBase<uint64_t>> hash_set;
+  if (set_type == "striped") {
+    hash_set = std::make_unique<HashSetStriped<uint64_t>>(1024);
+  } else if (set_type == "refinable") {
+    hash_set = std::make_unique<HashSetRefinable<uint64_t>>(1024);
+  } else {
+    std::cerr << argv[0] << " failed: unknown set type " << set_type
+              << std::endl;
+    return 1;
+  }
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << argv[0] << " failed: socket path too long" << std::endl;
+    return 1;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  int listen_fd =
+      ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  ::unlink(path.c_str());
+  if (listen_fd < 0 ||
+      ::bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+      ::listen(listen_fd, SOMAXCONN) != 0) {
+    std::cerr << argv[0] << " failed: cannot listen on " << path << ": "
+              << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  struct sigaction action {};
+  action.sa_handler = OnSignal;
+  ::sigaction(SIGINT, &action, nullptr);
+  ::sigaction(SIGTERM, &action, nullptr);
+  ::signal(SIGPIPE, SIG_IGN);
+
+  std::vector<std::unique_ptr<EventLoop>> loops;
+  for (size_t i = 0; i < num_loops; ++i) {
+    loops.push_back(std::make_unique<EventLoop>(listen_fd, *hash_set));
+    if (!loops.back()->Init()) {
+      std::cerr << argv[0] << " failed: epoll" << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "Serving a " << set_type << " set on " << path << " with "
+            << num_loops << " event loops" << std::endl;
+  std::vector<std::thread> threads;
+  for (auto& loop : loops) {
+    threads.emplace_back([&loop] { loop->Run(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t requests = 0;
+  for (auto& loop : loops) {
+    requests += loop->Requests();
+  }
+  ::close(listen_fd);
+  ::unlink(path.c_str());
+  std::cout << "Served " << requests << " requests; " << hash_set->Size()
+            << " keys in the set" << std::endl;
+  return 0;
+}
@@ -0,0 +1,379 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, fsync, write
+
+#include <algorithm>    // std::max, std::min
+#include <cerrno>       // errno, EINTR
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <cstdio>       // std::rename, std::remove
+#include <cstring>      // std::memcmp, std::memcpy
+#include <filesystem>   // std::filesystem::path
+#include <functional>   // std::hash
+#include <optional>     // std::optional
+#include <string>       // std::string
+#include <thread>       // std::thread
+#include <type_traits>  // std::is_trivially_copyable_v
+#include <utility>      // std::exchange
+#include <vector>       // std::vector
+
+#include "src/batch_hash.h"
+#include "src/bucket.h"
+#include "src/hash_set_base.h"
+
+// Binary snapshots of a set's keys, for restarting without replaying every
+// Add. A snapshot file is, in native byte order:
+//
+//   Header                         magic, version, key size, counts, checksum
+//   uint64_t offsets[buckets + 1]  bucket b is keys[offsets[b], offsets[b + 1])
+//   T keys[count]                  grouped by Hash{}(key) % buckets
+//   zero padding to a multiple of 8 bytes
+//
+// Keys are grouped exactly as a bucketed set with |buckets| buckets and the
+// same Hash would hold them, so HashSetStriped::LoadSnapshot can copy whole
+// buckets in parallel without hashing, comparing or locking per key. Any
+// other set can be filled with LoadInto, and Image::Contains answers lookups
+// straight from the mapped file.
+namespace snapshot {
+
+inline constexpr char kMagic[8] = {'H', 'S', 'S', 'N', 'A', 'P', '\r', '\n'};
+inline constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;  // sizeof(T) of the writer
+  uint64_t count;
+  uint64_t buckets;
+  uint64_t checksum;  // Checksum() of everything after the header
+};
+static_assert(sizeof(Header) == 40, "Header layout is part of the format");
+
+// |threads|, or one per hardware thread if it is 0.
+inline size_t ThreadCount(size_t threads) {
+  return threads != 0
+             ? threads
+             : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// Runs fn(t) for t in [0, ThreadCount(threads)) on separate threads.
+template <typename Fn>
+void ParallelFor(size_t threads, Fn&& fn) {
+  threads = ThreadCount(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(fn, t);
+  }
+  fn(size_t{0});
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// Position-dependent sum of mixed 8-byte words. Unlike a running hash it
+// splits into independent partial sums, so large images verify in parallel.
+// |bytes| must be a multiple of 8.
+inline uint64_t Checksum(const unsigned char* data, size_t bytes,
+                         size_t threads = 0) {
+  threads = ThreadCount(threads);
+  size_t words = bytes / 8;
+  size_t chunk = (words + threads - 1) / threads;
+  std::vector<uint64_t> partial(threads, 0);
+  ParallelFor(threads, [&](size_t t) {
+    uint64_t sum = 0;
+    size_t end = std::min(words, (t + 1) * chunk);
+    for (size_t i = t * chunk; i < end; ++i) {
+      uint64_t word;
+      std::memcpy(&word, data + i * 8, 8);
+      sum += batch_hash::Mix64(word ^ (i * 0x9e3779b97f4a7c15ull));
+    }
+    partial[t] = sum;
+  });
+  uint64_t sum = 0;
+  for (uint64_t p : partial) {
+    sum += p;
+  }
+  return sum;
+}
+
+inline bool WriteAll(int fd, const unsigned char* data, size_t bytes) {
+  while (bytes > 0) {
+    ssize_t n = ::write(fd, data, bytes);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// fsyncs the directory holding |path|, which makes a rename into it durable.
+inline bool SyncParentDirectory(const std::string& path) {
+  std::filesystem::path dir = std::filesystem::path(path).parent_path();
+  int fd = ::open(dir.empty() ? "." : dir.c_str(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+// Writes keys[0, n), which must be distinct, as a snapshot with |buckets|
+// buckets (0 picks two keys per bucket). The file is written and fsynced
+// next to |path|, renamed over it, and the rename is made durable by
+// fsyncing the directory, so a crash never leaves a torn snapshot behind.
+// Returns false if the file could not be written.
+template <typename T, typename Hash = std::hash<T>>
+bool SaveKeys(const T* keys, size_t n, const std::string& path,
+              size_t buckets = 0) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "snapshots store keys as raw bytes");
+  if (buckets == 0) {
+    buckets = std::max<size_t>(n / 2, 1);
+  }
+  Hash hasher;
+
+  // Counting sort by bucket.
+  std::vector<size_t> bucket_of(n);
+  std::vector<uint64_t> offsets(buckets + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    bucket_of[i] = hasher(keys[i]) % buckets;
+    ++offsets[bucket_of[i] + 1];
+  }
+  for (size_t b = 0; b < buckets; ++b) {
+    offsets[b + 1] += offsets[b];
+  }
+  size_t payload = (buckets + 1) * sizeof(uint64_t) + n * sizeof(T);
+  size_t padded = (payload + 7) / 8 * 8;
+  std::vector<unsigned char> body(padded, 0);
+  std::memcpy(body.data(), offsets.data(), (buckets + 1) * sizeof(uint64_t));
+  unsigned char* key_bytes = body.data() + (buckets + 1) * sizeof(uint64_t);
+  std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < n; ++i) {
+    std::memcpy(key_bytes + cursor[bucket_of[i]]++ * sizeof(T), &keys[i],
+                sizeof(T));
+  }
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.key_size = sizeof(T);
+  header.count = n;
+  header.buckets = buckets;
+  header.checksum = Checksum(body.data(), body.size());
+
+  std::string tmp_path = path + ".tmp";
+  int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = WriteAll(fd, reinterpret_cast<const unsigned char*>(&header),
+                     sizeof(header)) &&
+            WriteAll(fd, body.data(), body.size()) && ::fsync(fd) == 0;
+  ok = ::close(fd) == 0 && ok;
+  if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return SyncParentDirectory(path);
+}
+
+// Writes every element |set|'s ForEach visits; see SaveKeys.
+template <typename T, typename Hash = std::hash<T>, typename Set>
+bool Save(Set& set, const std::string& path, size_t buckets = 0) {
+  std::vector<T> keys;
+  keys.reserve(set.Size());
+  set.ForEach([&keys](const T& elem) { keys.push_back(elem); });
+  return SaveKeys<T, Hash>(keys.data(), keys.size(), path, buckets);
+}
+
+// A snapshot file mapped read-only. Nothing is copied: lookups, iteration
+// and bulk loads read the page cache directly.
+template <typename T, typename Hash = std::hash<T>>
+class Image {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "snapshots store keys as raw bytes");
+
+ public:
+  // Maps |path| and checks its header and layout; with |verify| it also
+  // checks the checksum, which reads the whole file. Returns nothing if the
+  // file is missing, truncated, from another format version or key type,
+  // or corrupt.
+  static std::optional<Image> Open(const std::string& path, bool verify = true,
+                                   size_t threads = 0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header)) {
+      ::close(fd);
+      return std::nullopt;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* data = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file open.
+    if (data == MAP_FAILED) {
+      return std::nullopt;
+    }
+    Image image(data, bytes);
+    if (!image.Valid(verify, threads)) {
+      return std::nullopt;
+    }
+    return image;
+  }
+
+  Image(Image&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        bytes_(std::exchange(other.bytes_, 0)),
+        header_(other.header_),
+        offsets_(other.offsets_),
+        keys_(other.keys_) {}
+
+  Image& operator=(Image&& other) noexcept {
+    if (this != &other) {
+      Unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      bytes_ = std::exchange(other.bytes_, 0);
+      header_ = other.header_;
+      offsets_ = other.offsets_;
+      keys_ = other.keys_;
+    }
+    return *this;
+  }
+
+  Image(const Image&) = delete;
+  Image& operator=(const Image&) = delete;
+
+  ~Image() { Unmap(); }
+
+  [[nodiscard]] size_t Size() const {
+    return static_cast<size_t>(header_.count);
+  }
+
+  [[nodiscard]] size_t BucketCount() const {
+    return static_cast<size_t>(header_.buckets);
+  }
+
+  // Keys of bucket b, as [BucketBegin(b), BucketEnd(b)).
+  const T* BucketBegin(size_t b) const { return keys_ + offsets_[b]; }
+  const T* BucketEnd(size_t b) const { return keys_ + offsets_[b + 1]; }
+
+  // All keys, in bucket order.
+  const T* Keys() const { return keys_; }
+
+  // Served from the mapping: one bucket scan, no locks.
+  [[nodiscard]] bool Contains(const T& elem) const {
+    size_t b = hasher_(elem) % BucketCount();
+    size_t n = static_cast<size_t>(offsets_[b + 1] - offsets_[b]);
+    return bucket::FindIndex(BucketBegin(b), n, elem) < n;
+  }
+
+  // Calls fn(elem) for every key, in bucket order.
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (size_t i = 0; i < Size(); ++i) {
+      fn(keys_[i]);
+    }
+  }
+
+ private:
+  Image(void* data, size_t bytes) : data_(data), bytes_(bytes) {
+    std::memcpy(&header_, data_, sizeof(Header));
+  }
+
+  void* data_;
+  size_t bytes_;
+  Header header_{};
+  const uint64_t* offsets_ = nullptr;
+  const T* keys_ = nullptr;
+  Hash hasher_;
+
+  void Unmap() {
+    if (data_ != nullptr) {
+      ::munmap(data_, bytes_);
+      data_ = nullptr;
+    }
+  }
+
+  bool Valid(bool verify, size_t threads) {
+    if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_.version != kVersion || header_.key_size != sizeof(T) ||
+        header_.buckets == 0) {
+      return false;
+    }
+    // Guard the size arithmetic against absurd counts in a corrupt header.
+    uint64_t limit = bytes_;
+    if (header_.buckets >= limit || header_.count >= limit) {
+      return false;
+    }
+    size_t payload = (BucketCount() + 1) * sizeof(uint64_t) +
+                     static_cast<size_t>(header_.count) * sizeof(T);
+    if (bytes_ != sizeof(Header) + (payload + 7) / 8 * 8) {
+      return false;
+    }
+    const unsigned char* body =
+        static_cast<const unsigned char*>(data_) + sizeof(Header);
+    if (verify) {
+      ::madvise(data_, bytes_, MADV_SEQUENTIAL);
+      if (Checksum(body, bytes_ - sizeof(Header), threads) !=
+          header_.checksum) {
+        return false;
+      }
+    }
+    offsets_ = reinterpret_cast<const uint64_t*>(body);
+    keys_ = reinterpret_cast<const T*>(body +
+                                       (BucketCount() + 1) * sizeof(uint64_t));
+    // Lookups index keys_ through the offsets, so they must be in bounds
+    // even when the checksum was skipped.
+    if (offsets_[0] != 0 || offsets_[BucketCount()] != header_.count) {
+      return false;
+    }
+    for (size_t b = 0; b < BucketCount(); ++b) {
+      if (offsets_[b] > offsets_[b + 1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Adds every key of |image| to |set|, splitting the keys into one
+// contiguous share per thread, each inserted with AddBatch. Works for any
+// thread-safe set; pass threads = 1 for HashSetSequential. Returns how many
+// keys were absent.
+template <typename T, typename Hash>
+size_t LoadInto(const Image<T, Hash>& image, HashSetBase<T>& set,
+                size_t threads = 0) {
+  threads = ThreadCount(threads);
+  size_t n = image.Size();
+  size_t chunk = (n + threads - 1) / threads;
+  std::vector<size_t> added(threads, 0);
+  ParallelFor(threads, [&](size_t t) {
+    size_t begin = std::min(n, t * chunk);
+    size_t end = std::min(n, begin + chunk);
+    added[t] = set.AddBatch(image.Keys() + begin, end - begin);
+  });
+  size_t total = 0;
+  for (size_t a : added) {
+    total += a;
+  }
+  return total;
+}
+
+}  // namespace snapshot
+
+#endif  // SNAPSHOT_H
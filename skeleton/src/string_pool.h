@@ -0,0 +1,271 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <algorithm>    // std::max
+#include <atomic>       // std::atomic
+#include <bit>          // std::bit_width
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <cstring>      // std::memcpy
+#include <functional>   // std::hash
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::mutex, std::unique_lock
+#include <optional>     // std::optional
+#include <stdexcept>    // std::length_error
+#include <string_view>  // std::string_view
+#include <vector>       // std::vector
+
+#include "src/hash_set_params.h"
+
+// Interns strings: every distinct string is stored once and named by a
+// stable 32-bit id, numbered densely from zero in the order strings were
+// first seen. View(id) returns the bytes, which stay valid and unmoved for
+// the pool's lifetime.
+//
+// HashSetBase<std::string> takes its elements by value, so every Add and
+// Contains would copy the string. The pool takes std::string_view instead
+// and copies bytes only for a string it has not seen. Those bytes go to
+// an append-only arena picked per thread: a thread takes an arena slot on
+// its first Intern, so with up to kArenas threads no two share one and the
+// arena's lock is never contended.
+//
+// The index is a striped hash set of entries holding a cached hash and the
+// string's location. Stripes and buckets are both powers of two with
+// buckets >= stripes, so a hash's stripe is fixed across resizes and each
+// bucket is guarded by exactly one stripe. A resize takes every stripe lock
+// and moves entries by their cached hash without touching string bytes.
+//
+// Strings are never removed.
+class StringPool {
+ public:
+  explicit StringPool(size_t initial_capacity = 1024, size_t stripes = 64,
+                      const HashSetParams& params = HashSetParams{})
+      : params_(params.Normalized()),
+        stripe_mask_(RoundUpToPowerOfTwo(std::max<size_t>(stripes, 1)) - 1),
+        stripes_(std::make_unique<Stripe[]>(stripe_mask_ + 1)),
+        buckets_(RoundUpToPowerOfTwo(
+            std::max({initial_capacity, params_.min_buckets,
+                      stripe_mask_ + 1}))) {
+    bucket_count_.store(buckets_.size(), std::memory_order_relaxed);
+  }
+
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // Returns the id of |s|, storing it first if the pool has not seen it.
+  // Throws std::length_error once 2^32 - 1 strings are stored or if |s| is
+  // 4 GiB or longer.
+  uint32_t Intern(std::string_view s) {
+    size_t h = hasher_(s);
+    std::unique_lock<std::mutex> lk(stripes_[h & stripe_mask_].lock);
+    auto& b = buckets_[h & (buckets_.size() - 1)];
+    if (const Entry* e = FindIn(b, s, h)) {
+      return e->id;
+    }
+    if (s.size() > UINT32_MAX) {
+      throw std::length_error("StringPool: string too long");
+    }
+    uint32_t id = NewId();
+    const char* data = arenas_[ArenaSlot()].Store(s, arena_bytes_);
+    auto len = static_cast<uint32_t>(s.size());
+    RefAt(id) = Ref{data, len};
+    b.push_back(Entry{h, data, len, id});
+    size_t size = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t cap = buckets_.size();
+    lk.unlock();
+
+    if (static_cast<double>(size) >
+        params_.max_load_factor * static_cast<double>(cap)) {
+      Resize(cap);
+    }
+    return id;
+  }
+
+  // Returns the id of |s| if it was interned, without storing it otherwise.
+  [[nodiscard]] std::optional<uint32_t> Find(std::string_view s) {
+    size_t h = hasher_(s);
+    std::unique_lock<std::mutex> lk(stripes_[h & stripe_mask_].lock);
+    if (const Entry* e = FindIn(buckets_[h & (buckets_.size() - 1)], s, h)) {
+      return e->id;
+    }
+    return std::nullopt;
+  }
+
+  // Returns the string with id |id|, which must have come from Intern or
+  // Find. Takes no lock.
+  [[nodiscard]] std::string_view View(uint32_t id) const {
+    const Ref& ref = RefAt(id);
+    return {ref.data, ref.len};
+  }
+
+  // Returns the number of distinct strings interned.
+  [[nodiscard]] size_t Size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the bytes held by arenas, the id directory and the index, for
+  // bytes-per-string accounting. Arena blocks count in full once allocated.
+  [[nodiscard]] size_t MemoryUsage() const {
+    size_t n = Size();
+    return arena_bytes_.load(std::memory_order_relaxed) +
+           directory_bytes_.load(std::memory_order_relaxed) +
+           n * sizeof(Entry) +
+           bucket_count_.load(std::memory_order_relaxed) *
+               sizeof(std::vector<Entry>);
+  }
+
+ private:
+  // Where an interned string lives.
+  struct Ref {
+    const char* data;
+    uint32_t len;
+  };
+
+  struct Entry {
+    size_t hash;
+    const char* data;
+    uint32_t len;
+    uint32_t id;
+  };
+
+  struct alignas(64) Stripe {
+    std::mutex lock;
+  };
+
+  // An append-only run of blocks. Strings longer than a quarter block get a
+  // block of their own, so at most a quarter of each block is wasted.
+  struct alignas(64) Arena {
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* next = nullptr;
+    size_t left = 0;
+
+    const char* Store(std::string_view s, std::atomic<size_t>& bytes) {
+      std::unique_lock<std::mutex> lk(lock);
+      if (s.size() > kBlockSize / 4) {
+        blocks.push_back(std::make_unique_for_overwrite<char[]>(s.size()));
+        bytes.fetch_add(s.size(), std::memory_order_relaxed);
+        std::memcpy(blocks.back().get(), s.data(), s.size());
+        return blocks.back().get();
+      }
+      if (next == nullptr || left < s.size()) {
+        blocks.push_back(std::make_unique_for_overwrite<char[]>(kBlockSize));
+        bytes.fetch_add(kBlockSize, std::memory_order_relaxed);
+        next = blocks.back().get();
+        left = kBlockSize;
+      }
+      char* data = next;
+      std::memcpy(data, s.data(), s.size());
+      next += s.size();
+      left -= s.size();
+      return data;
+    }
+  };
+
+  static constexpr size_t kArenas = 64;
+
+  // The id directory is a list of chunks that double in size, so ids never
+  // move and View needs no lock. Chunk c holds 2^(kFirstChunkBits + c) refs.
+  static constexpr size_t kFirstChunkBits = 10;
+  static constexpr size_t kChunks = 33 - kFirstChunkBits;
+
+  const HashSetParams params_;
+  const size_t stripe_mask_;
+  std::unique_ptr<Stripe[]> stripes_;
+  std::vector<std::vector<Entry>> buckets_;
+  std::atomic<size_t> bucket_count_{0};
+  std::mutex resize_mutex_;
+  Arena arenas_[kArenas];
+  static inline std::atomic<size_t> next_arena_{0};
+  std::atomic<Ref*> chunks_[kChunks] = {};
+  std::unique_ptr<Ref[]> chunk_storage_[kChunks];
+  std::mutex chunk_mutex_;
+  std::atomic<uint64_t> next_id_{0};
+  std::atomic<size_t> size_{0};
+  std::atomic<size_t> arena_bytes_{0};
+  std::atomic<size_t> directory_bytes_{0};
+  std::hash<std::string_view> hasher_;
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  static const Entry* FindIn(const std::vector<Entry>& b, std::string_view s,
+                             size_t h) {
+    for (const Entry& e : b) {
+      if (e.hash == h && std::string_view(e.data, e.len) == s) {
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+
+  // This thread's arena slot in every pool.
+  static size_t ArenaSlot() {
+    thread_local size_t slot =
+        next_arena_.fetch_add(1, std::memory_order_relaxed) % kArenas;
+    return slot;
+  }
+
+  static size_t ChunkOf(uint64_t id, size_t* offset) {
+    uint64_t x = id + (uint64_t{1} << kFirstChunkBits);
+    auto bits = static_cast<size_t>(std::bit_width(x)) - 1;
+    *offset = static_cast<size_t>(x - (uint64_t{1} << bits));
+    return bits - kFirstChunkBits;
+  }
+
+  Ref& RefAt(uint32_t id) const {
+    size_t offset;
+    size_t c = ChunkOf(id, &offset);
+    return chunks_[c].load(std::memory_order_acquire)[offset];
+  }
+
+  // Hands out the next id and makes sure its directory chunk exists.
+  uint32_t NewId() {
+    uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    if (id >= UINT32_MAX) {
+      next_id_.store(UINT32_MAX, std::memory_order_relaxed);
+      throw std::length_error("StringPool: out of ids");
+    }
+    size_t offset;
+    size_t c = ChunkOf(id, &offset);
+    if (chunks_[c].load(std::memory_order_acquire) == nullptr) {
+      std::unique_lock<std::mutex> lk(chunk_mutex_);
+      if (chunks_[c].load(std::memory_order_relaxed) == nullptr) {
+        size_t n = size_t{1} << (kFirstChunkBits + c);
+        chunk_storage_[c] = std::make_unique_for_overwrite<Ref[]>(n);
+        directory_bytes_.fetch_add(n * sizeof(Ref), std::memory_order_relaxed);
+        chunks_[c].store(chunk_storage_[c].get(), std::memory_order_release);
+      }
+    }
+    return static_cast<uint32_t>(id);
+  }
+
+  void Resize(size_t old_capacity) {
+    std::unique_lock<std::mutex> resize_lock(resize_mutex_);
+    for (size_t s = 0; s <= stripe_mask_; ++s) {
+      stripes_[s].lock.lock();
+    }
+    if (buckets_.size() == old_capacity) {
+      std::vector<std::vector<Entry>> new_buckets(old_capacity * 2);
+      for (auto& b : buckets_) {
+        for (const Entry& e : b) {
+          new_buckets[e.hash & (new_buckets.size() - 1)].push_back(e);
+        }
+      }
+      buckets_.swap(new_buckets);
+      bucket_count_.store(buckets_.size(), std::memory_order_relaxed);
+    }
+    for (size_t s = 0; s <= stripe_mask_; ++s) {
+      stripes_[s].lock.unlock();
+    }
+  }
+};
+
+#endif  // STRING_POOL_H
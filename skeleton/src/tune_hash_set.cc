@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/benchmark.h"
+#include "src/hash_set_adaptive.h"
+#include "src/hash_set_base.h"
+#include "src/hash_set_coarse_grained.h"
+#include "src/hash_set_params.h"
+#include "src/hash_set_refinable.h"
+#include "src/hash_set_striped.h"
+
+// Searches lock policy, load factors, minimum table size and stripe count for
+// the fastest configuration on the benchmark driver's workload, and writes it
+// out as a header defining tuned::MakeHashSet<T>().
+
+namespace {
+
+enum class Policy { kCoarseGrained, kStriped, kRefinable, kAdaptive };
+
+const char* PolicyName(Policy policy) {
+  switch (policy) {
+    case Policy::kCoarseGrained:
+      return "coarse_grained";
+    case Policy::kStriped:
+      return "striped";
+    case Policy::kRefinable:
+      return "refinable";
+    case Policy::kAdaptive:
+      return "adaptive";
+  }
+  return "unknown";
+}
+
+struct Config {
+  Policy policy = Policy::kCoarseGrained;
+  HashSetParams params;
+  size_t stripes = 64;
+};
+
+struct Workload {
+  size_t num_threads = 0;
+  size_t initial_capacity = 0;
+  size_t chunk_size = 0;
+  size_t repetitions = 0;
+};
+
+// One axis of the search: the values to try and how to apply one.
+struct Dimension {
+  std::vector<double> values;
+  std::function<bool(Policy)> applies;
+  std::function<void(Config&, double)> set;
+};
+
+std::vector<Dimension> Dimensions() {
+  auto all = [](Policy) { return true; };
+  return {
+      {{1.0, 2.0, 4.0, 8.0},
+       all,
+       [](Config& c, double v) { c.params.max_load_factor = v; }},
+      // Only the coarse-grained and striped tables shrink.
+      {{0.0, 0.25, 1.0},
+       [](Policy p) { return p != Policy::kRefinable; },
+       [](Config& c, double v) { c.params.min_load_factor = v; }},
+      {{4.0, 64.0, 1024.0},
+       all,
+       [](Config& c, double v) {
+         c.params.min_buckets = static_cast<size_t>(v);
+       }},
+      {{16.0, 64.0, 256.0, 1024.0},
+       [](Policy p) { return p == Policy::kStriped; },
+       [](Config& c, double v) { c.stripes = static_cast<size_t>(v); }},
+  };
+}
+
+std::unique_ptr<HashSetBase<int>> MakeSet(const Config& config,
+                                          size_t initial_capacity) {
+  switch (config.policy) {
+    case Policy::kCoarseGrained:
+      return std::make_unique<HashSetCoarseGrained<int>>(initial_capacity,
+                                                         config.params);
+    case Policy::kStriped:
+      return std::make_unique<HashSetStriped<int>>(
+          initial_capacity,
+          StripedOptions{.stripes = config.stripes, .params = config.params});
+    case Policy::kRefinable:
+      return std::make_unique<HashSetRefinable<int>>(initial_capacity,
+                                                     config.params);
+    case Policy::kAdaptive:
+      return std::make_unique<HashSetAdaptive<int>>(initial_capacity,
+                                                    config.params);
+  }
+  return nullptr;
+}
+
+// Median wall time in milliseconds over the workload's repetitions, or
+// nothing if a run failed its correctness check.
+std::optional<double> Measure(const Config& config, const Workload& workload) {
+  std::vector<double> millis;
+  for (size_t r = 0; r < workload.repetitions; r++) {
+    auto hash_set = MakeSet(config, workload.initial_capacity);
+    std::chrono::nanoseconds elapsed{};
+    if (!benchmark::RunWorkload(PolicyName(config.policy), *hash_set,
+                                workload.num_threads, workload.chunk_size,
+                                elapsed)) {
+      return std::nullopt;
+    }
+    millis.push_back(
+        std::chrono::duration<double, std::milli>(elapsed).count());
+  }
+  std::sort(millis.begin(), millis.end());
+  return millis[millis.size() / 2];
+}
+
+std::string Describe(const Config& config) {
+  std::ostringstream out;
+  out << PolicyName(config.policy)
+      << " max_load_factor=" << config.params.max_load_factor
+      << " min_buckets=" << config.params.min_buckets;
+  if (config.policy != Policy::kRefinable) {
+    out << " min_load_factor=" << config.params.min_load_factor;
+  }
+  if (config.policy == Policy::kStriped) {
+    out << " stripes=" << config.stripes;
+  }
+  return out.str();
+}
+
+struct Candidate {
+  Config config;
+  double millis = 0.0;
+};
+
+// Coordinate search from the defaults: each dimension in turn is swept with
+// the others held at their best values so far.
+std::optional<Candidate> Tune(Policy policy, const Workload& workload) {
+  Candidate best;
+  best.config.policy = policy;
+  std::optional<double> base = Measure(best.config, workload);
+  if (!base) {
+    return std::nullopt;
+  }
+  best.millis = *base;
+  std::cout << "  " << Describe(best.config) << ": " << best.millis << " ms"
+            << std::endl;
+
+  for (const Dimension& dim : Dimensions()) {
+    if (!dim.applies(policy)) {
+      continue;
+    }
+    for (double value : dim.values) {
+      Config trial = best.config;
+      dim.set(trial, value);
+      if (Describe(trial) == Describe(best.config)) {
+        continue;  // Already measured.
+      }
+      std::optional<double> millis = Measure(trial, workload);
+      if (!millis) {
+        return std::nullopt;
+      }
+      std::cout << "  " << Describe(trial) << ": " << *millis << " ms"
+                << std::endl;
+      if (*millis < best.millis) {
+        best = Candidate{trial, *millis};
+      }
+    }
+  }
+  return best;
+}
+
+void WriteHeader(std::ostream& out, const Candidate& best,
+                 const Workload& workload) {
+  const Config& config = best.config;
+  std::ostringstream params;
+  params << std::fixed << std::setprecision(2)
+         << "{\n    .max_load_factor = " << config.params.max_load_factor
+         << ", .min_load_factor = " << config.params.min_load_factor
+         << ", .min_buckets = " << config.params.min_buckets << "}";
+
+  out << "// Generated by tune_hash_set; do not edit.\n"
+      << "// Workload: " << workload.num_threads << " threads, initial "
+      << "capacity " << workload.initial_capacity << ", chunk size "
+      << workload.chunk_size << ".\n"
+      << "// Best: " << Describe(config) << ",\n"
+      << "// " << best.millis << " ms (median of " << workload.repetitions
+      << " runs).\n"
+      << "#ifndef TUNED_HASH_SET_H\n"
+      << "#define TUNED_HASH_SET_H\n\n"
+      << "#include <cstddef>\n"
+      << "#include <memory>\n\n";
+  std::vector<std::string> includes = {
+      "src/hash_set_base.h", "src/hash_set_params.h",
+      std::string("src/hash_set_") + PolicyName(config.policy) + ".h"};
+  std::sort(includes.begin(), includes.end());
+  for (const auto& include : includes) {
+    out << "#include \"" << include << "\"\n";
+  }
+  out << "\nnamespace tuned {\n\n"
+      << "inline constexpr HashSetParams kParams = " << params.str() << ";\n";
+  if (config.policy == Policy::kStriped) {
+    out << "inline constexpr size_t kStripes = " << config.stripes << ";\n";
+  }
+  out << "\ntemplate <typename T>\n"
+      << "std::unique_ptr<HashSetBase<T>> MakeHashSet(size_t "
+      << "initial_capacity) {\n";
+  switch (config.policy) {
+    case Policy::kCoarseGrained:
+      out << "  return std::make_unique<HashSetCoarseGrained<T>>("
+          << "initial_capacity, kParams);\n";
+      break;
+    case Policy::kStriped:
+      out << "  return std::make_unique<HashSetStriped<T>>(\n"
+          << "      initial_capacity,\n"
+          << "      StripedOptions{.stripes = kStripes, .params = kParams});\n";
+      break;
+    case Policy::kRefinable:
+      out << "  return std::make_unique<HashSetRefinable<T>>("
+          << "initial_capacity, kParams);\n";
+      break;
+    case Policy::kAdaptive:
+      out << "  return std::make_unique<HashSetAdaptive<T>>("
+          << "initial_capacity, kParams);\n";
+      break;
+  }
+  out << "}\n\n"
+      << "}  // namespace tuned\n\n"
+      << "#endif  // TUNED_HASH_SET_H\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 6) {
+    std::cerr << "Usage: " << argv[0]
+              << " num_threads initial_capacity chunk_size repetitions"
+              << " output_header" << std::endl;
+    return 1;
+  }
+  Workload workload;
+  workload.num_threads = std::stoul(std::string(argv[1]));
+  workload.initial_capacity = std::stoul(std::string(argv[2]));
+  workload.chunk_size = std::stoul(std::string(argv[3]));
+  workload.repetitions = std::max<size_t>(std::stoul(std::string(argv[4])), 1);
+
+  std::optional<Candidate> best;
+  for (Policy policy : {Policy::kCoarseGrained, Policy::kStriped,
+                        Policy::kRefinable, Policy::kAdaptive}) {
+    std::cout << PolicyName(policy) << ":" << std::endl;
+    std::optional<Candidate> candidate = Tune(policy, workload);
+    if (!candidate) {
+      return 1;
+    }
+    if (!best || candidate->millis < best->millis) {
+      best = candidate;
+    }
+  }
+
+  std::ofstream out(argv[5]);
+  WriteHeader(out, *best, workload);
+  if (!out) {
+    std::cerr << argv[0] << " failed: cannot write " << argv[5] << std::endl;
+    return 1;
+  }
+  std::cout << "Best: " << Describe(best->config) << ", " << best->millis
+            << " ms; written to " << argv[5] << std::endl;
+  return 0;
+}
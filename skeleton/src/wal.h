@@ -0,0 +1,490 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <fcntl.h>   // open
+#include <unistd.h>  // close, fdatasync, fsync, write
+
+#include <algorithm>           // std::sort
+#include <atomic>              // std::atomic
+#include <cerrno>              // errno, EINTR
+#include <chrono>              // std::chrono::microseconds
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>             // size_t
+#include <cstdint>             // uint32_t, uint64_t
+#include <cstdio>              // std::remove
+#include <cstdlib>             // std::strtoull
+#include <cstring>             // std::memcmp, std::memcpy
+#include <filesystem>          // std::filesystem::directory_iterator
+#include <fstream>             // std::ifstream
+#include <iterator>            // std::istreambuf_iterator
+#include <memory>              // std::unique_ptr
+#include <mutex>               // std::mutex, std::unique_lock
+#include <optional>            // std::optional
+#include <string>              // std::string
+#include <thread>              // std::thread
+#include <type_traits>         // std::is_trivially_copyable_v
+#include <utility>             // std::move
+#include <vector>              // std::vector
+
+#include "src/batch_hash.h"
+
+// Write-ahead log of Add and Remove operations, for sets that must survive a
+// crash. Each operation gets a log sequence number (LSN) and is buffered by
+// the calling thread; a writer thread gathers every buffer once per commit
+// interval, writes the batch in LSN order and makes it durable with a single
+// fdatasync. That one sync covers every thread's operations in the window,
+// which is the point of group commit.
+//
+// State on disk is a snapshot (see src/snapshot.h) plus the log segments
+// written since it was taken, all named after a common prefix:
+//
+//   <prefix>.snap.<lsn>   every operation before <lsn>, maybe some later ones
+//   <prefix>.log.<lsn>    operations from <lsn> on, until the next segment
+//
+// A segment is a SegmentHeader followed by fixed-size records: a
+// RecordHeader (LSN, operation, check word) and the key, padded to 8 bytes.
+// Recovery loads the newest snapshot that validates, falling back to older
+// ones, and replays the segments from its LSN. Replaying a record the
+// snapshot already reflects is harmless, since Add and Remove are idempotent
+// and each key's records are in the order its operations took effect.
+// Replay stops at the first record that is torn or out of sequence: the tail
+// of a commit that never completed.
+namespace wal {
+
+inline constexpr char kMagic[8] = {'H', 'S', 'W', 'A', 'L', 0, '\r', '\n'};
+inline constexpr uint32_t kVersion = 1;
+
+enum class Op : uint32_t { kAdd = 1, kRemove = 2 };
+
+struct SegmentHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;   // sizeof(T) of the writer
+  uint64_t start_lsn;  // LSN of the first record
+};
+static_assert(sizeof(SegmentHeader) == 24, "part of the format");
+
+struct RecordHeader {
+  uint64_t lsn;
+  uint32_t op;
+  uint32_t check;  // RecordCheck() of the record
+};
+static_assert(sizeof(RecordHeader) == 16, "part of the format");
+
+struct Options {
+  // How long the writer gathers operations before committing them with one
+  // write and one fdatasync. Longer intervals mean fewer syncs and a larger
+  // window of operations a crash can lose. Must be positive.
+  std::chrono::microseconds commit_interval{1000};
+};
+
+template <typename T>
+inline constexpr size_t kRecordBytes =
+    (sizeof(RecordHeader) + sizeof(T) + 7) / 8 * 8;
+
+// Mixes the LSN, operation and key bytes; a torn or stale record fails it.
+inline uint32_t RecordCheck(uint64_t lsn, uint32_t op, const unsigned char* key,
+                            size_t key_size) {
+  uint64_t h = batch_hash::Mix64(lsn ^ (uint64_t{op} << 56));
+  for (size_t i = 0; i < key_size; i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, key + i, key_size - i < 8 ? key_size - i : 8);
+    h = batch_hash::Mix64(h ^ word);
+  }
+  return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+inline std::string SegmentPath(const std::string& prefix, uint64_t lsn) {
+  return prefix + ".log." + std::to_string(lsn);
+}
+
+inline std::string SnapshotPath(const std::string& prefix, uint64_t lsn) {
+  return prefix + ".snap." + std::to_string(lsn);
+}
+
+// Snapshots and segments found under a prefix, each by LSN, ascending.
+struct Files {
+  std::vector<uint64_t> snapshots;
+  std::vector<uint64_t> segments;
+};
+
+inline Files Scan(const std::string& prefix) {
+  namespace fs = std::filesystem;
+  fs::path base(prefix);
+  fs::path dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+  std::string stem = base.filename().string();
+  Files files;
+  std::error_code ec;
+  // Appends the LSN if |name| is |stem| + |kind| + a number.
+  auto match = [&stem](const std::string& name, const std::string& kind,
+                       std::vector<uint64_t>& out) {
+    std::string lead = stem + kind;
+    if (name.size() > lead.size() && name.compare(0, lead.size(), lead) == 0) {
+      char* end = nullptr;
+      uint64_t lsn = std::strtoull(name.c_str() + lead.size(), &end, 10);
+      if (*end == '\0') {
+        out.push_back(lsn);
+      }
+    }
+  };
+  for (const auto& entry : fs::directory_iterator(dir, ec)) {
+    std::string name = entry.path().filename().string();
+    match(name, ".snap.", files.snapshots);
+    match(name, ".log.", files.segments);
+  }
+  std::sort(files.snapshots.begin(), files.snapshots.end());
+  std::sort(files.segments.begin(), files.segments.end());
+  return files;
+}
+
+// fsyncs |path|, a file or a directory.
+inline bool SyncPath(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+// fsyncs the directory holding the files of |prefix|, which makes creating,
+// renaming and removing them durable.
+inline bool SyncDirectory(const std::string& prefix) {
+  std::filesystem::path dir = std::filesystem::path(prefix).parent_path();
+  return SyncPath(dir.empty() ? "." : dir.string());
+}
+
+// Removes snapshots older than |lsn| and segments that start before it. Only
+// safe once the snapshot at |lsn| is durable.
+inline void RemoveBefore(const std::string& prefix, uint64_t lsn) {
+  Files files = Scan(prefix);
+  for (uint64_t s : files.snapshots) {
+    if (s < lsn) {
+      std::remove(SnapshotPath(prefix, s).c_str());
+    }
+  }
+  for (uint64_t s : files.segments) {
+    if (s < lsn) {
+      std::remove(SegmentPath(prefix, s).c_str());
+    }
+  }
+}
+
+// Removes every snapshot and segment of |prefix|.
+inline void Destroy(const std::string& prefix) {
+  Files files = Scan(prefix);
+  for (uint64_t s : files.snapshots) {
+    std::remove(SnapshotPath(prefix, s).c_str());
+  }
+  for (uint64_t s : files.segments) {
+    std::remove(SegmentPath(prefix, s).c_str());
+  }
+}
+
+// Calls fn(op, key) for the records of the segment starting at |start|, in
+// order, stopping at the first invalid one. Returns the LSN after the last
+// record replayed, which is |start| if the segment is missing or unreadable.
+template <typename T, typename Fn>
+uint64_t Replay(const std::string& prefix, uint64_t start, Fn&& fn) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "the log stores keys as raw bytes");
+  std::ifstream in(SegmentPath(prefix, start), std::ios::binary);
+  std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)),
+                                  std::istreambuf_iterator<char>());
+  SegmentHeader header{};
+  if (data.size() < sizeof(header)) {
+    return start;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.key_size != sizeof(T) ||
+      header.start_lsn != start) {
+    return start;
+  }
+  uint64_t next = start;
+  for (size_t pos = sizeof(header); pos + kRecordBytes<T> <= data.size();
+       pos += kRecordBytes<T>) {
+    RecordHeader record{};
+    std::memcpy(&record, data.data() + pos, sizeof(record));
+    const unsigned char* key_bytes = data.data() + pos + sizeof(record);
+    if (record.lsn != next ||
+        (record.op != static_cast<uint32_t>(Op::kAdd) &&
+         record.op != static_cast<uint32_t>(Op::kRemove)) ||
+        record.check !=
+            RecordCheck(record.lsn, record.op, key_bytes, sizeof(T))) {
+      break;
+    }
+    T key;
+    std::memcpy(&key, key_bytes, sizeof(T));
+    fn(static_cast<Op>(record.op), key);
+    ++next;
+  }
+  return next;
+}
+
+// The writing side: per-thread operation buffers and the group-commit
+// writer thread.
+template <typename T>
+class Log {
+ public:
+  // Starts a new segment at |next_lsn|, the LSN after everything recovered,
+  // replacing any stale segment from there on. Returns nullptr if it cannot
+  // be created.
+  static std::unique_ptr<Log> Open(const std::string& prefix,
+                                   uint64_t next_lsn,
+                                   const Options& options = {}) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "the log stores keys as raw bytes");
+    for (uint64_t s : Scan(prefix).segments) {
+      if (s >= next_lsn) {
+        std::remove(SegmentPath(prefix, s).c_str());
+      }
+    }
+    int fd = CreateSegment(prefix, next_lsn);
+    if (fd < 0) {
+      return nullptr;
+    }
+    return std::unique_ptr<Log>(new Log(prefix, fd, next_lsn, options));
+  }
+
+  // Commits whatever is still buffered, then stops the writer.
+  ~Log() {
+    {
+      std::unique_lock<std::mutex> lk(wake_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    ::close(fd_);
+  }
+
+  Log(const Log&) = delete;
+  Log& operator=(const Log&) = delete;
+
+  // Buffers one operation and returns its LSN. Callers that need per-key
+  // order in the log must call this while holding whatever orders their
+  // operations on that key; the LSN is taken under the buffer's lock.
+  uint64_t Append(Op op, const T& key) {
+    Slot& slot = slots_[ThreadSlot()];
+    std::unique_lock<std::mutex> lk(slot.lock);
+    uint64_t lsn = next_lsn_.fetch_add(1, std::memory_order_relaxed);
+    slot.pending.push_back(Entry{lsn, op, key});
+    return lsn;
+  }
+
+  // Blocks until every operation appended before the call is durable,
+  // committing early instead of waiting out the interval. Concurrent calls
+  // share one fdatasync. Returns false if the log has failed to write.
+  bool Sync() {
+    uint64_t target = next_lsn_.load(std::memory_order_relaxed);
+    {
+      std::unique_lock<std::mutex> lk(wake_mutex_);
+      sync_requested_ = true;
+    }
+    wake_.notify_one();
+    std::unique_lock<std::mutex> lk(durable_mutex_);
+    durable_.wait(lk, [&] { return durable_lsn_ >= target || failed_; });
+    return !failed_;
+  }
+
+  // Commits everything buffered and starts a new segment. Returns the new
+  // segment's first LSN: every earlier operation is durable in older
+  // segments, so a snapshot taken after this call can replace them.
+  std::optional<uint64_t> Rotate() {
+    uint64_t lsn = 0;
+    if (!Commit(/*rotate=*/true, &lsn)) {
+      return std::nullopt;
+    }
+    return lsn;
+  }
+
+  // Operations with a smaller LSN are durable.
+  [[nodiscard]] uint64_t DurableLsn() const {
+    std::unique_lock<std::mutex> lk(durable_mutex_);
+    return durable_lsn_;
+  }
+
+  // Number of fdatasync calls so far.
+  [[nodiscard]] uint64_t Syncs() const {
+    return syncs_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] const std::string& Prefix() const { return prefix_; }
+
+ private:
+  static constexpr size_t kSlots = 64;
+
+  struct Entry {
+    uint64_t lsn;
+    Op op;
+    T key;
+  };
+
+  // One buffer per thread, up to kSlots threads; beyond that threads share.
+  struct alignas(64) Slot {
+    std::mutex lock;
+    std::vector<Entry> pending;
+  };
+
+  static size_t ThreadSlot() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+    return slot;
+  }
+
+  static int CreateSegment(const std::string& prefix, uint64_t lsn) {
+    std::string path = SegmentPath(prefix, lsn);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+      return -1;
+    }
+    SegmentHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.key_size = sizeof(T);
+    header.start_lsn = lsn;
+    if (!WriteAll(fd, reinterpret_cast<const unsigned char*>(&header),
+                  sizeof(header)) ||
+        ::fdatasync(fd) != 0 || !SyncDirectory(prefix)) {
+      ::close(fd);
+      std::remove(path.c_str());
+      return -1;
+    }
+    return fd;
+  }
+
+  static bool WriteAll(int fd, const unsigned char* data, size_t bytes) {
+    while (bytes > 0) {
+      ssize_t n = ::write(fd, data, bytes);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      data += n;
+      bytes -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  Log(std::string prefix, int fd, uint64_t next_lsn, const Options& options)
+      : prefix_(std::move(prefix)),
+        interval_(options.commit_interval),
+        fd_(fd),
+        next_lsn_(next_lsn),
+        committed_lsn_(next_lsn),
+        slots_(kSlots),
+        gathered_(kSlots),
+        durable_lsn_(next_lsn) {
+    writer_ = std::thread([this] { Run(); });
+  }
+
+  const std::string prefix_;
+  const std::chrono::microseconds interval_;
+  int fd_;                          // Current segment; guarded by file_mutex_
+  std::atomic<uint64_t> next_lsn_;  // Advanced under some slot's lock
+  uint64_t committed_lsn_;          // Guarded by file_mutex_
+  std::vector<Slot> slots_;
+  std::thread writer_;
+
+  std::mutex file_mutex_;  // One commit or rotation at a time
+  std::vector<std::vector<Entry>> gathered_;
+  std::vector<unsigned char> buffer_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool sync_requested_ = false;
+  bool stop_ = false;
+
+  mutable std::mutex durable_mutex_;
+  std::condition_variable durable_;
+  uint64_t durable_lsn_;
+  bool failed_ = false;
+  std::atomic<uint64_t> syncs_{0};
+
+  void Run() {
+    std::unique_lock<std::mutex> lk(wake_mutex_);
+    while (!stop_) {
+      wake_.wait_for(lk, interval_,
+                     [this] { return stop_ || sync_requested_; });
+      sync_requested_ = false;
+      lk.unlock();
+      Commit(/*rotate=*/false, nullptr);
+      lk.lock();
+    }
+  }
+
+  // Takes every buffered operation, writes them in LSN order and syncs.
+  // Holding all slot locks while reading next_lsn_ means every LSN below it
+  // has been buffered, so each commit covers one contiguous range and the
+  // segment never has gaps.
+  bool Commit(bool rotate, uint64_t* end_lsn) {
+    std::unique_lock<std::mutex> file_lock(file_mutex_);
+    for (Slot& slot : slots_) {
+      slot.lock.lock();
+    }
+    uint64_t end = next_lsn_.load(std::memory_order_relaxed);
+    for (size_t s = 0; s < kSlots; ++s) {
+      gathered_[s].swap(slots_[s].pending);
+    }
+    for (Slot& slot : slots_) {
+      slot.lock.unlock();
+    }
+
+    bool ok = true;
+    size_t count = static_cast<size_t>(end - committed_lsn_);
+    if (count > 0) {
+      // Each LSN has a fixed place in the batch, so no sort is needed.
+      buffer_.resize(count * kRecordBytes<T>);
+      for (auto& entries : gathered_) {
+        for (const Entry& e : entries) {
+          unsigned char* out =
+              buffer_.data() +
+              static_cast<size_t>(e.lsn - committed_lsn_) * kRecordBytes<T>;
+          RecordHeader record{e.lsn, static_cast<uint32_t>(e.op), 0};
+          std::memset(out, 0, kRecordBytes<T>);
+          std::memcpy(out + sizeof(record), &e.key, sizeof(T));
+          record.check =
+              RecordCheck(e.lsn, record.op, out + sizeof(record), sizeof(T));
+          std::memcpy(out, &record, sizeof(record));
+        }
+        entries.clear();
+      }
+      ok = WriteAll(fd_, buffer_.data(), buffer_.size()) &&
+           ::fdatasync(fd_) == 0;
+      syncs_.fetch_add(1, std::memory_order_relaxed);
+      committed_lsn_ = end;
+    }
+    if (ok && rotate) {
+      int fd = CreateSegment(prefix_, end);
+      if (fd < 0) {
+        ok = false;
+      } else {
+        ::close(fd_);
+        fd_ = fd;
+      }
+    }
+    if (end_lsn != nullptr) {
+      *end_lsn = end;
+    }
+
+    {
+      std::unique_lock<std::mutex> lk(durable_mutex_);
+      if (ok) {
+        durable_lsn_ = end;
+      } else {
+        failed_ = true;
+      }
+    }
+    durable_.notify_all();
+    return ok;
+  }
+};
+
+}  // namespace wal
+
+#endif  // WAL_H
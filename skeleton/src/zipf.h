@@ -0,0 +1,46 @@
+#ifndef ZIPF_H
+#define ZIPF_H
+
+#include <algorithm>  // std::upper_bound
+#include <cmath>      // std::pow
+#include <cstddef>    // size_t
+#include <random>     // std::mt19937_64, std::uniform_real_distribution
+#include <vector>     // std::vector
+
+namespace benchmark {
+
+// Draws ranks in [0, n) with P(rank k) proportional to 1 / (k + 1)^skew, by
+// binary search over the precomputed CDF. Slow enough per draw that
+// benchmarks should generate their key streams before the timed section.
+class ZipfGenerator {
+ public:
+  ZipfGenerator(size_t n, double skew, unsigned long long seed)
+      : cdf_(n), engine_(seed) {
+    double sum = 0.0;
+    for (size_t k = 0; k < n; k++) {
+      sum += 1.0 / std::pow(static_cast<double>(k + 1), skew);
+      cdf_[k] = sum;
+    }
+    for (auto& c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  size_t Next() {
+    double u = uniform_(engine_);
+    auto it = std::upper_bound(cdf_.begin(), cdf_.end(), u);
+    if (it == cdf_.end()) {
+      return cdf_.size() - 1;
+    }
+    return static_cast<size_t>(it - cdf_.begin());
+  }
+
+ private:
+  std::vector<double> cdf_;
+  std::mt19937_64 engine_;
+  std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+};
+
+}  // namespace benchmark
+
+#endif  // ZIPF_H